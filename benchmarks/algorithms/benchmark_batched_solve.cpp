@@ -0,0 +1,81 @@
+#include <string>
+#include <vector>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include "algorithms.hpp"
+#include "device.hpp"
+#include "tensor.hpp"
+
+using namespace gpu_playground;
+
+TEST_CASE("algorithms: batched solves", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // 1024 tridiagonal SPD systems of each size, solved in one call or one `conjuaget_gradient` per
+  // system
+  constexpr size_t batch{1024};
+  constexpr float tol{1e-5};
+  for (size_t const n : {16, 64})
+  {
+    std::vector<float> a_data(batch * n * n, 0.0);
+    for (size_t s{0}; s < batch; s++)
+    {
+      for (size_t i{0}; i < n; i++)
+      {
+        a_data[(s * n * n) + (i * n) + i] = static_cast<float>(4 + (s % 3));
+        if (i + 1 < n)
+        {
+          a_data[(s * n * n) + (i * n) + i + 1]   = -1.0;
+          a_data[(s * n * n) + ((i + 1) * n) + i] = -1.0;
+        }
+      }
+    }
+    Tensor a  = Tensor(a_data, Shape{batch * n, n}, devices[DeviceIdx::SERIAL]);
+    Tensor b  = Tensor::ones(Shape{batch * n, 1}, devices[DeviceIdx::SERIAL]);
+    Tensor x0 = Tensor::zeros(Shape{batch * n, 1}, devices[DeviceIdx::SERIAL]);
+
+    for (auto const &device : devices)
+    {
+      if (device != nullptr)
+      {
+        a.to(device);
+        b.to(device);
+        x0.to(device);
+        auto const name = std::string(get_device_name(device->type())) + " " + std::to_string(n);
+
+        std::vector<Tensor> systems;
+        systems.reserve(batch);
+        for (size_t s{0}; s < batch; s++)
+        {
+          auto const first = a_data.cbegin() + static_cast<std::ptrdiff_t>(s * n * n);
+          systems.emplace_back(
+              std::vector<float>(first, first + static_cast<std::ptrdiff_t>(n * n)),
+              Shape{n, n},
+              device
+          );
+        }
+        Tensor const b_s  = Tensor::ones(Shape{n, 1}, device);
+        Tensor const x0_s = Tensor::zeros(Shape{n, 1}, device);
+
+        BENCHMARK(name + " batched cg")
+        {
+          return batched_conjugate_gradient(a, b, x0, batch, 1000, tol);
+        };
+        BENCHMARK(name + " batched cholesky") { return batched_cholesky_solve(a, b, batch); };
+        BENCHMARK(name + " cg per system")
+        {
+          std::vector<Tensor> res;
+          res.reserve(batch);
+          for (auto const &system : systems)
+          {
+            res.push_back(conjuaget_gradient(system, b_s, x0_s, 1000, tol));
+          }
+          return res;
+        };
+      }
+    }
+  }
+}
@@ -0,0 +1,83 @@
+#include <string>
+#include <vector>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include "algorithms.hpp"
+#include "csr_matrix.hpp"
+#include "device.hpp"
+#include "tensor.hpp"
+
+using namespace gpu_playground;
+
+TEST_CASE("algorithms: block conjugate gradient", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // 5-point Laplacian on a 200x200 grid against 16 right-hand sides, for a fixed number of
+  // iterations: one block solve against one solve per column
+  constexpr size_t side{200};
+  constexpr size_t rows{side * side};
+  constexpr size_t s{16};
+  constexpr size_t iters{20};
+  std::vector<backend::Triplet> triplets;
+  for (size_t i{0}; i < rows; i++)
+  {
+    auto const row = static_cast<backend::CsrIndex>(i);
+    triplets.push_back({row, row, 4.0});
+    if (i % side > 0)
+    {
+      triplets.push_back({row, row - 1, -1.0});
+      triplets.push_back({row - 1, row, -1.0});
+    }
+    if (i >= side)
+    {
+      triplets.push_back({row, static_cast<backend::CsrIndex>(i - side), -1.0});
+      triplets.push_back({static_cast<backend::CsrIndex>(i - side), row, -1.0});
+    }
+  }
+  auto const csr = backend::csr_from_triplets(Shape{rows, rows}, triplets);
+  Tensor b       = Tensor::rand(Shape{rows, s}, devices[DeviceIdx::SERIAL]);
+  Tensor x0      = Tensor::zeros(Shape{rows, s}, devices[DeviceIdx::SERIAL]);
+  Tensor x0_col  = Tensor::zeros(Shape{rows, 1}, devices[DeviceIdx::SERIAL]);
+  std::vector<Tensor> b_cols;
+  auto const b_host = b.cpu();
+  for (size_t j{0}; j < s; j++)
+  {
+    std::vector<float> col(rows);
+    for (size_t i{0}; i < rows; i++)
+    {
+      col[i] = b_host[(i * s) + j];
+    }
+    b_cols.emplace_back(std::move(col), Shape{rows, 1}, devices[DeviceIdx::SERIAL]);
+  }
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      b.to(device);
+      x0.to(device);
+      x0_col.to(device);
+      for (auto &b_col : b_cols)
+      {
+        b_col.to(device);
+      }
+      auto const name = std::string(get_device_name(device->type()));
+      CsrMatrix const a(Shape{rows, rows}, csr.row_ptr, csr.col_idx, csr.values, device);
+
+      BENCHMARK(name + " block") { return block_conjugate_gradient(a, b, x0, iters, 0.0); };
+      BENCHMARK(name + " one column at a time")
+      {
+        std::vector<Tensor> res;
+        res.reserve(s);
+        for (auto const &b_col : b_cols)
+        {
+          res.push_back(conjuaget_gradient(a, b_col, x0_col, iters, 0.0));
+        }
+        return res;
+      };
+    }
+  }
+}
@@ -1,3 +1,4 @@
+#include <limits>
 #include <string>
 
 #include "catch2/benchmark/catch_benchmark.hpp"
@@ -35,6 +36,46 @@ TEST_CASE("algorithms: conjugate gradient", "[algorithms]")
       {
         return conjuaget_gradient(a, b, x0);
       };
+      BENCHMARK(std::string(get_device_name(device->type())) + " check every 8")
+      {
+        return conjuaget_gradient(a, b, x0, 1000, std::numeric_limits<float>::epsilon(), 8);
+      };
+    }
+  }
+}
+
+TEST_CASE("algorithms: conjugate gradient double precision", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  constexpr size_t n{500};
+  Shape const a_shape{n, n};
+  Shape const b_shape{n, 1};
+  Tensor a  = Tensor::rand(a_shape, devices[DeviceIdx::SERIAL]);
+  Tensor b  = Tensor::rand(b_shape, devices[DeviceIdx::SERIAL]);
+  Tensor x0 = Tensor::zeros(b_shape, devices[DeviceIdx::SERIAL]);
+
+  a = a.transpose() * a;
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F64))
+    {
+      a.to(device);
+      b.to(device);
+      x0.to(device);
+
+      // A fixed number of iterations, so that both dtypes do the same work
+      for (auto const dtype : {DType::F32, DType::F64})
+      {
+        auto const a_r  = a.to_dtype(dtype);
+        auto const b_r  = b.to_dtype(dtype);
+        auto const x0_r = x0.to_dtype(dtype);
+        auto const name = std::string(get_device_name(device->type())) + " " +
+                          std::string(get_dtype_name(dtype));
+
+        BENCHMARK(name) { return conjuaget_gradient(a_r, b_r, x0_r, 100, 0.0F); };
+      }
     }
   }
 }
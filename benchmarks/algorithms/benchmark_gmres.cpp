@@ -0,0 +1,69 @@
+#include <string>
+#include <vector>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include "algorithms.hpp"
+#include "csr_matrix.hpp"
+#include "device.hpp"
+#include "tensor.hpp"
+
+using namespace gpu_playground;
+
+TEST_CASE("algorithms: gmres", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // Upwinded convection-diffusion on a 100x100 grid, a non-symmetric system, for several sizes of
+  // the Krylov subspace
+  constexpr size_t side{100};
+  constexpr size_t rows{side * side};
+  constexpr float tol{1e-3};
+  std::vector<backend::Triplet> triplets;
+  for (size_t i{0}; i < side; i++)
+  {
+    for (size_t j{0}; j < side; j++)
+    {
+      auto const row = static_cast<backend::CsrIndex>((i * side) + j);
+      triplets.push_back({row, row, 5.0});
+      if (i > 0)
+      {
+        triplets.push_back({row, row - static_cast<backend::CsrIndex>(side), -2.0});
+      }
+      if (j > 0)
+      {
+        triplets.push_back({row, row - 1, -2.0});
+      }
+      if (j + 1 < side)
+      {
+        triplets.push_back({row, row + 1, -0.5});
+      }
+      if (i + 1 < side)
+      {
+        triplets.push_back({row, row + static_cast<backend::CsrIndex>(side), -0.5});
+      }
+    }
+  }
+  Tensor b  = Tensor::ones(Shape{rows, 1}, devices[DeviceIdx::SERIAL]);
+  Tensor x0 = Tensor::zeros(Shape{rows, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      b.to(device);
+      x0.to(device);
+      auto const name = std::string(get_device_name(device->type()));
+      auto const a    = CsrMatrix::from_triplets(Shape{rows, rows}, triplets, device);
+
+      for (size_t const restart : {10, 30, 60})
+      {
+        BENCHMARK(name + " gmres(" + std::to_string(restart) + ")")
+        {
+          return gmres(a, b, x0, restart, 10'000, tol);
+        };
+      }
+    }
+  }
+}
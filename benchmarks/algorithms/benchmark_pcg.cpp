@@ -0,0 +1,91 @@
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include "algorithms.hpp"
+#include "csr_matrix.hpp"
+#include "device.hpp"
+#include "preconditioners.hpp"
+#include "tensor.hpp"
+
+using namespace gpu_playground;
+
+TEST_CASE("algorithms: preconditioned conjugate gradient", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // 5-point Laplacian on a 100x100 grid with rows and columns scaled by 1, 10 and 100, solved to
+  // the same tolerance: the time to reach it is what matters, not the cost of an iteration
+  constexpr size_t side{100};
+  constexpr size_t rows{side * side};
+  constexpr float tol{1e-2};
+  auto const scale = [](size_t const i) { return std::pow(10.0F, static_cast<float>(i % 3)); };
+  std::vector<backend::Triplet> triplets;
+  auto const push = [&](size_t const row, size_t const col, float const value)
+  {
+    triplets.push_back(
+        {static_cast<backend::CsrIndex>(row),
+         static_cast<backend::CsrIndex>(col),
+         value * scale(row) * scale(col)}
+    );
+  };
+  for (size_t i{0}; i < side; i++)
+  {
+    for (size_t j{0}; j < side; j++)
+    {
+      auto const row = (i * side) + j;
+      push(row, row, 4.0);
+      if (i > 0)
+      {
+        push(row, row - side, -1.0);
+      }
+      if (j > 0)
+      {
+        push(row, row - 1, -1.0);
+      }
+      if (j + 1 < side)
+      {
+        push(row, row + 1, -1.0);
+      }
+      if (i + 1 < side)
+      {
+        push(row, row + side, -1.0);
+      }
+    }
+  }
+  auto const csr = backend::csr_from_triplets(Shape{rows, rows}, triplets);
+  Tensor b       = Tensor::ones(Shape{rows, 1}, devices[DeviceIdx::SERIAL]);
+  Tensor x0      = Tensor::zeros(Shape{rows, 1}, devices[DeviceIdx::SERIAL]);
+
+  SsorPreconditioner const ssor{csr};
+  Ilu0Preconditioner const ilu{csr};
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      b.to(device);
+      x0.to(device);
+      auto const name = std::string(get_device_name(device->type()));
+      CsrMatrix const a(Shape{rows, rows}, csr.row_ptr, csr.col_idx, csr.values, device);
+      JacobiPreconditioner const jacobi{csr, device};
+
+      BENCHMARK(name + " cg") { return conjuaget_gradient(a, b, x0, 10'000, tol); };
+      BENCHMARK(name + " pcg jacobi")
+      {
+        return preconditioned_conjugate_gradient(a, b, x0, jacobi, 10'000, tol);
+      };
+      BENCHMARK(name + " pcg ssor")
+      {
+        return preconditioned_conjugate_gradient(a, b, x0, ssor, 10'000, tol);
+      };
+      BENCHMARK(name + " pcg ilu(0)")
+      {
+        return preconditioned_conjugate_gradient(a, b, x0, ilu, 10'000, tol);
+      };
+    }
+  }
+}
@@ -0,0 +1,69 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include "algorithms.hpp"
+#include "device.hpp"
+#include "tensor.hpp"
+
+using namespace gpu_playground;
+
+TEST_CASE("algorithms: mixed precision refinement", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // A dense symmetric matrix with pseudo-random entries in [-1, 1] and a diagonal shifted past
+  // their spectrum, so that it is SPD and well conditioned. Both solvers stop at the same F64
+  // residual norm, i.e. at double accuracy, and are bound by the bytes of A they stream.
+  constexpr size_t n{2'000};
+  constexpr float tol{1e-9};
+  std::vector<double> a_data(n * n);
+  for (size_t i{0}; i < n; i++)
+  {
+    a_data[(i * n) + i] = 100.0;
+    for (size_t j{i + 1}; j < n; j++)
+    {
+      auto const value    = std::sin(static_cast<double>((i * n) + j));
+      a_data[(i * n) + j] = value;
+      a_data[(j * n) + i] = value;
+    }
+  }
+  Shape const b_shape{n, 1};
+  Tensor a  = Tensor::from_f64(a_data, Shape{n, n}, devices[DeviceIdx::SERIAL]);
+  Tensor b  = Tensor::ones(b_shape, devices[DeviceIdx::SERIAL]).to_dtype(DType::F64);
+  Tensor x0 = Tensor::zeros(b_shape, devices[DeviceIdx::SERIAL]).to_dtype(DType::F64);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F64))
+    {
+      a.to(device);
+      b.to(device);
+      x0.to(device);
+      auto const name = std::string(get_device_name(device->type()));
+
+      auto const time = [&](std::string const &solver, auto const &solve)
+      {
+        auto const start = std::chrono::steady_clock::now();
+        auto const x     = solve();
+        std::chrono::duration<double> const seconds = std::chrono::steady_clock::now() - start;
+        auto const r = b - a * x;
+        std::cout << "algorithms: mixed precision refinement: " << name << " " << solver << ": "
+                  << seconds.count() << " s to a residual of " << std::sqrt(r.dot(r).item_f64())
+                  << "\n";
+      };
+      auto const refinement = [&]() { return mixed_precision_refinement(a, b, x0, 100, tol); };
+      auto const double_cg  = [&]() { return conjuaget_gradient(a, b, x0, 1000, tol); };
+      time("refinement", refinement);
+      time("F64 cg", double_cg);
+
+      BENCHMARK(name + " refinement") { return refinement(); };
+      BENCHMARK(name + " F64 cg") { return double_cg(); };
+    }
+  }
+}
@@ -0,0 +1,78 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include "csr_matrix.hpp"
+#include "device.hpp"
+#include "reordering.hpp"
+#include "tensor.hpp"
+
+using namespace gpu_playground;
+
+TEST_CASE("algorithms: reordering", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // 5-point Laplacian on a 500x500 grid, with the grid points numbered in a scrambled order
+  constexpr size_t side{500};
+  constexpr size_t rows{side * side};
+  auto const label = [](size_t const point)
+  { return static_cast<backend::CsrIndex>((point * 7'919) % rows); };
+  std::vector<backend::Triplet> triplets;
+  for (size_t i{0}; i < side; i++)
+  {
+    for (size_t j{0}; j < side; j++)
+    {
+      auto const row = label((i * side) + j);
+      triplets.push_back({row, row, 4.0});
+      if (i > 0)
+      {
+        triplets.push_back({row, label(((i - 1) * side) + j), -1.0});
+      }
+      if (j > 0)
+      {
+        triplets.push_back({row, label((i * side) + j - 1), -1.0});
+      }
+      if (j + 1 < side)
+      {
+        triplets.push_back({row, label((i * side) + j + 1), -1.0});
+      }
+      if (i + 1 < side)
+      {
+        triplets.push_back({row, label(((i + 1) * side) + j), -1.0});
+      }
+    }
+  }
+  auto const scrambled = backend::csr_from_triplets(Shape{rows, rows}, triplets);
+  auto const rcm       = Reordering::rcm(scrambled).apply(scrambled);
+  auto const nd        = Reordering::nested_dissection(scrambled).apply(scrambled);
+  std::cout << "bandwidth: scrambled " << bandwidth(scrambled) << ", rcm " << bandwidth(rcm)
+            << ", nested dissection " << bandwidth(nd) << "\n";
+
+  Tensor x = Tensor::rand(Shape{rows, 1}, devices[DeviceIdx::SERIAL]);
+
+  BENCHMARK("rcm ordering") { return Reordering::rcm(scrambled); };
+  BENCHMARK("nested dissection ordering") { return Reordering::nested_dissection(scrambled); };
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      x.to(device);
+      auto const name = std::string(get_device_name(device->type()));
+
+      auto const make = [&](backend::CsrData const &a)
+      { return CsrMatrix(Shape{rows, rows}, a.row_ptr, a.col_idx, a.values, device); };
+      auto const a_scrambled = make(scrambled);
+      auto const a_rcm       = make(rcm);
+      auto const a_nd        = make(nd);
+
+      BENCHMARK(name + " spmv scrambled") { return a_scrambled * x; };
+      BENCHMARK(name + " spmv rcm") { return a_rcm * x; };
+      BENCHMARK(name + " spmv nested dissection") { return a_nd * x; };
+    }
+  }
+}
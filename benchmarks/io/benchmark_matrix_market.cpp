@@ -0,0 +1,60 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include "device.hpp"
+#include "matrix_market.hpp"
+
+using namespace gpu_playground;
+
+TEST_CASE("io: matrix market", "[io]")
+{
+  auto const devices = make_devices();
+
+  // Lower triangle of the 5-point Laplacian on a 1000x1000 grid, 3 * 10^6 entries
+  constexpr size_t side{1'000};
+  constexpr size_t rows{side * side};
+  auto const path = (std::filesystem::temp_directory_path() / "gpu_playground_bench.mtx").string();
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << "%%MatrixMarket matrix coordinate real symmetric\n";
+    file << rows << " " << rows << " " << ((3 * rows) - (2 * side)) << "\n";
+    for (size_t i{0}; i < side; i++)
+    {
+      for (size_t j{0}; j < side; j++)
+      {
+        auto const row = (i * side) + j + 1;
+        if (i > 0)
+        {
+          file << row << " " << row - side << " -1.0\n";
+        }
+        if (j > 0)
+        {
+          file << row << " " << row - 1 << " -1.0\n";
+        }
+        file << row << " " << row << " 4.0\n";
+      }
+    }
+  }
+
+  auto const mm = read_matrix_market(path);
+  REQUIRE(mm.has_value());
+  std::cout << "io: matrix market: " << mm->stats.mb_per_s() << " MB/s\n";
+
+  BENCHMARK("parse") { return read_matrix_market(path); };
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      BENCHMARK(std::string(get_device_name(device->type())) + " csr")
+      {
+        return load_matrix_market_csr(path, device);
+      };
+    }
+  }
+}
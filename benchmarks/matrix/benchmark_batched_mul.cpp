@@ -0,0 +1,61 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include "device.hpp"
+#include "tensor.hpp"
+
+using namespace gpu_playground;
+
+TEST_CASE("matrix: batched mul", "[matrix]")
+{
+  auto const devices = make_devices();
+
+  // Stacks of small square matrices, multiplied in one call or one Tensor product at a time
+  for (size_t const size : {32, 64, 128})
+  {
+    auto const batch = (size_t{1} << 15) / size;
+    std::vector<float> data(batch * size * size);
+    for (size_t i{0}; i < data.size(); i++)
+    {
+      data[i] = static_cast<float>(i % 7) - 3.0F;
+    }
+    Tensor a(data, Shape{batch * size, size}, devices[DeviceIdx::SERIAL]);
+    Tensor b(data, Shape{batch * size, size}, devices[DeviceIdx::SERIAL]);
+    std::vector<float> const one(data.cbegin(), data.cbegin() + (size * size));
+
+    for (auto const &device : devices)
+    {
+      if (device != nullptr)
+      {
+        a.to(device);
+        b.to(device);
+        Tensor const a_one(one, Shape{size, size}, device);
+        Tensor const b_one(one, Shape{size, size}, device);
+        auto const name = std::string(get_device_name(device->type())) + " " +
+                          std::to_string(size) + "x" + std::to_string(size) + " x" +
+                          std::to_string(batch);
+
+        auto const start = std::chrono::steady_clock::now();
+        a.batched_mul(b, batch).sync();
+        std::chrono::duration<double> const seconds = std::chrono::steady_clock::now() - start;
+        std::cout << "matrix: batched mul: " << name << ": "
+                  << static_cast<double>(batch) / seconds.count() << " matrices/s\n";
+
+        BENCHMARK(name + " batched") { return a.batched_mul(b, batch); };
+        BENCHMARK(name + " one at a time")
+        {
+          for (size_t s{0}; s + 1 < batch; s++)
+          {
+            (a_one * b_one).sync();
+          }
+          return a_one * b_one;
+        };
+      }
+    }
+  }
+}
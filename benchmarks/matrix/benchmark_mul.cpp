@@ -1,3 +1,5 @@
+#include <chrono>
+#include <iostream>
 #include <numeric>
 #include <string>
 #include <vector>
@@ -36,3 +38,44 @@ TEST_CASE("matrix: mul", "[matrix]")
     }
   }
 }
+
+TEST_CASE("matrix: mul double precision", "[matrix]")
+{
+  auto const devices = make_devices();
+
+  constexpr size_t n{1'024};
+  constexpr size_t reps{5};
+  std::vector<float> a_data(n * n);
+  for (size_t i{0}; i < a_data.size(); i++)
+  {
+    a_data[i] = static_cast<float>(i % 7) - 3.0F;
+  }
+  Tensor a(a_data, Shape{n, n}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F64))
+    {
+      a.to(device);
+
+      for (auto const dtype : {DType::F32, DType::F64})
+      {
+        auto const a_r  = a.to_dtype(dtype);
+        auto const name = std::string(get_device_name(device->type())) + " " +
+                          std::string(get_dtype_name(dtype));
+
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t r{0}; r < reps; r++)
+        {
+          (a_r * a_r).sync();
+        }
+        std::chrono::duration<double> const seconds = std::chrono::steady_clock::now() - start;
+        auto const flops = static_cast<double>(2 * reps * n * n * n);
+        std::cout << "matrix: mul double precision: " << name << ": "
+                  << flops / seconds.count() / 1e9 << " GFLOP/s\n";
+
+        BENCHMARK(name) { return a_r * a_r; };
+      }
+    }
+  }
+}
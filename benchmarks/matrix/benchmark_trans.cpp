@@ -14,20 +14,33 @@ TEST_CASE("matrix: trans", "[matrix]")
 {
   auto const devices = make_devices();
 
-  constexpr size_t rows{1'000};
-  constexpr size_t cols{1'000};
-  std::vector<float> data(rows * cols);
-  std::iota(data.begin(), data.end(), 0.0);
-  Shape const shape{rows, cols};
-  Tensor a(data, shape, devices[DeviceIdx::SERIAL]);
-
-  for (auto const &device : devices)
+  // Square, power-of-two (cache set conflicts), tall and skinny, and ragged shapes
+  std::vector<Shape> const shapes{
+      Shape{1'000, 1'000},
+      Shape{1'024, 1'024},
+      Shape{2'048, 2'048},
+      Shape{4'096, 256},
+      Shape{257, 3'001},
+  };
+
+  for (auto const &shape : shapes)
   {
-    if (device != nullptr)
+    std::vector<float> data(shape.rows * shape.cols);
+    std::iota(data.begin(), data.end(), 0.0);
+    Tensor a(data, shape, devices[DeviceIdx::SERIAL]);
+    auto const name = std::to_string(shape.rows) + "x" + std::to_string(shape.cols);
+
+    for (auto const &device : devices)
     {
-      a.to(device);
+      if (device != nullptr)
+      {
+        a.to(device);
 
-      BENCHMARK(std::string(get_device_name(device->type()))) { return a.transpose(); };
+        BENCHMARK(std::string(get_device_name(device->type())) + " " + name)
+        {
+          return a.transpose().contiguous();
+        };
+      }
     }
   }
 }
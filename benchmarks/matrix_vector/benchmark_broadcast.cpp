@@ -0,0 +1,51 @@
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include "device.hpp"
+#include "tensor.hpp"
+
+using namespace gpu_playground;
+
+TEST_CASE("matrix-vector: broadcast", "[matrix-vector]")
+{
+  auto const devices = make_devices();
+
+  // Broadcasting a row and a column vector, against adding the row vector expanded by hand into a
+  // full matrix
+  constexpr size_t rows{1'000};
+  constexpr size_t cols{1'000};
+  std::vector<float> a_data(rows * cols);
+  std::vector<float> v_data(cols);
+  std::vector<float> expanded_data(rows * cols);
+  std::iota(a_data.begin(), a_data.end(), 0.0);
+  std::iota(v_data.begin(), v_data.end(), 1.0);
+  for (size_t i{0}; i < rows; i++)
+  {
+    std::copy(v_data.cbegin(), v_data.cend(), expanded_data.begin() + (i * cols));
+  }
+  Tensor a(a_data, Shape{rows, cols}, devices[DeviceIdx::SERIAL]);
+  Tensor row(v_data, Shape{1, cols}, devices[DeviceIdx::SERIAL]);
+  Tensor col(v_data, Shape{rows, 1}, devices[DeviceIdx::SERIAL]);
+  Tensor expanded(expanded_data, Shape{rows, cols}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      a.to(device);
+      row.to(device);
+      col.to(device);
+      expanded.to(device);
+      auto const name = std::string(get_device_name(device->type()));
+
+      BENCHMARK(name + " row") { return a + row; };
+      BENCHMARK(name + " column") { return a + col; };
+      BENCHMARK(name + " expanded") { return a + expanded; };
+      BENCHMARK(name + " row cdiv") { return a.cdiv(row); };
+    }
+  }
+}
@@ -1,3 +1,5 @@
+#include <chrono>
+#include <iostream>
 #include <numeric>
 #include <string>
 #include <vector>
@@ -36,3 +38,52 @@ TEST_CASE("matrix-vector: mul", "[matrix-vector]")
     }
   }
 }
+
+TEST_CASE("matrix-vector: mul per dtype", "[matrix-vector]")
+{
+  auto const devices = make_devices();
+
+  // A matrix well beyond the caches, so that the product is bound by the bytes of A it streams
+  constexpr size_t rows{4'096};
+  constexpr size_t cols{4'096};
+  constexpr size_t reps{10};
+  std::vector<float> a_data(rows * cols);
+  std::vector<float> b_data(cols);
+  for (size_t i{0}; i < a_data.size(); i++)
+  {
+    a_data[i] = static_cast<float>(i % 7) - 3.0F;
+  }
+  std::iota(b_data.begin(), b_data.end(), 1.0);
+  Tensor a(a_data, Shape{rows, cols}, devices[DeviceIdx::SERIAL]);
+  Tensor b(b_data, Shape{cols, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F16))
+    {
+      a.to(device);
+      b.to(device);
+
+      for (auto const dtype : {DType::F64, DType::F32, DType::F16, DType::BF16})
+      {
+        // F64 only multiplies F64, the 16-bit types multiply an F32 x
+        auto const a_r  = a.to_dtype(dtype);
+        auto const b_r  = dtype == DType::F64 ? b.to_dtype(DType::F64) : b;
+        auto const name = std::string(get_device_name(device->type())) + " " +
+                          std::string(get_dtype_name(dtype));
+
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t r{0}; r < reps; r++)
+        {
+          (a_r * b_r).sync();
+        }
+        std::chrono::duration<double> const seconds = std::chrono::steady_clock::now() - start;
+        auto const bytes = static_cast<double>(reps * rows * cols * dtype_size(dtype));
+        std::cout << "matrix-vector: mul per dtype: " << name << ": "
+                  << bytes / seconds.count() / 1e9 << " GB/s\n";
+
+        BENCHMARK(name) { return a_r * b_r; };
+      }
+    }
+  }
+}
@@ -0,0 +1,114 @@
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include "csr_matrix.hpp"
+#include "device.hpp"
+#include "sell_matrix.hpp"
+#include "tensor.hpp"
+
+using namespace gpu_playground;
+
+TEST_CASE("matrix-vector: spmv", "[matrix-vector]")
+{
+  auto const devices = make_devices();
+
+  // 5-point Laplacian on a 1000x1000 grid, 10^6 unknowns
+  constexpr size_t side{1'000};
+  constexpr size_t rows{side * side};
+  std::vector<backend::CsrIndex> row_ptr{0};
+  std::vector<backend::CsrIndex> col_idx;
+  std::vector<float> values;
+  auto const push = [&](size_t const col, float const value)
+  {
+    col_idx.push_back(static_cast<backend::CsrIndex>(col));
+    values.push_back(value);
+  };
+  for (size_t i{0}; i < side; i++)
+  {
+    for (size_t j{0}; j < side; j++)
+    {
+      auto const row = (i * side) + j;
+      if (i > 0)
+      {
+        push(row - side, -1.0);
+      }
+      if (j > 0)
+      {
+        push(row - 1, -1.0);
+      }
+      push(row, 4.0);
+      if (j + 1 < side)
+      {
+        push(row + 1, -1.0);
+      }
+      if (i + 1 < side)
+      {
+        push(row + side, -1.0);
+      }
+      row_ptr.push_back(static_cast<backend::CsrIndex>(values.size()));
+    }
+  }
+  std::vector<float> x_data(rows);
+  std::iota(x_data.begin(), x_data.end(), 0.0);
+  Tensor x(x_data, Shape{rows, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      x.to(device);
+      CsrMatrix const a(Shape{rows, rows}, row_ptr, col_idx, values, device);
+
+      BENCHMARK(std::string(get_device_name(device->type()))) { return a * x; };
+    }
+  }
+}
+
+TEST_CASE("matrix-vector: spmv irregular", "[matrix-vector]")
+{
+  auto const devices = make_devices();
+
+  // Row lengths skewed towards short rows, from 1 to 128 non-zeros spread over the columns
+  constexpr size_t rows{200'000};
+  std::mt19937 rng{42};
+  std::uniform_real_distribution<float> dist(0.0, 1.0);
+  std::vector<backend::CsrIndex> row_ptr{0};
+  std::vector<backend::CsrIndex> col_idx;
+  std::vector<float> values;
+  for (size_t i{0}; i < rows; i++)
+  {
+    auto const u     = dist(rng);
+    auto const len   = 1 + static_cast<size_t>(127.0F * u * u * u);
+    auto const step  = rows / len;
+    auto const start = static_cast<size_t>(dist(rng) * static_cast<float>(step - 1));
+    for (size_t k{0}; k < len; k++)
+    {
+      col_idx.push_back(static_cast<backend::CsrIndex>(start + (k * step)));
+      values.push_back(1.0F + dist(rng));
+    }
+    row_ptr.push_back(static_cast<backend::CsrIndex>(values.size()));
+  }
+  std::vector<float> x_data(rows);
+  std::iota(x_data.begin(), x_data.end(), 0.0);
+  Tensor x(x_data, Shape{rows, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      x.to(device);
+      CsrMatrix const csr(Shape{rows, rows}, row_ptr, col_idx, values, device);
+      SellMatrix const sell(Shape{rows, rows}, row_ptr, col_idx, values, device);
+      auto const name = std::string(get_device_name(device->type()));
+
+      BENCHMARK(name + " csr") { return csr * x; };
+
+      BENCHMARK(name + " sell") { return sell * x; };
+    }
+  }
+}
@@ -0,0 +1,89 @@
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include "device.hpp"
+#include "tensor.hpp"
+
+using namespace gpu_playground;
+
+TEST_CASE("vector: axpy", "[vector]")
+{
+  auto const devices = make_devices();
+
+  constexpr size_t len{1'000'000};
+  std::vector<float> x_data(len);
+  std::vector<float> y_data(len);
+  std::iota(x_data.begin(), x_data.end(), 0.0);
+  std::iota(y_data.begin(), y_data.end(), 1.0);
+  Shape const shape{len, 1};
+  Shape const scalar_shape{1, 1};
+  Tensor x(x_data, shape, devices[DeviceIdx::SERIAL]);
+  Tensor y(y_data, shape, devices[DeviceIdx::SERIAL]);
+  Tensor alpha(std::vector<float>{1.0}, scalar_shape, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      x.to(device);
+      y.to(device);
+      alpha.to(device);
+
+      BENCHMARK(std::string(get_device_name(device->type()))) { y.axpy(alpha, x); };
+    }
+  }
+}
+
+TEST_CASE("vector: axpy double precision", "[vector]")
+{
+  auto const devices = make_devices();
+
+  // Vectors well beyond the caches, so that axpy is bound by the bytes it streams
+  constexpr size_t len{1U << 24};
+  constexpr size_t reps{10};
+  std::vector<float> x_data(len);
+  for (size_t i{0}; i < len; i++)
+  {
+    x_data[i] = static_cast<float>(i % 7) - 3.0F;
+  }
+  Shape const shape{len, 1};
+  Tensor x(x_data, shape, devices[DeviceIdx::SERIAL]);
+  Tensor alpha(std::vector<float>{0.5}, Shape{1, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F64))
+    {
+      x.to(device);
+      alpha.to(device);
+
+      for (auto const dtype : {DType::F32, DType::F64})
+      {
+        auto const x_r     = x.to_dtype(dtype);
+        auto const alpha_r = alpha.to_dtype(dtype);
+        auto y_r           = Tensor::zeros(shape, device).to_dtype(dtype);
+        auto const name    = std::string(get_device_name(device->type())) + " " +
+                             std::string(get_dtype_name(dtype));
+
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t r{0}; r < reps; r++)
+        {
+          y_r.axpy(alpha_r, x_r);
+          y_r.sync();
+        }
+        std::chrono::duration<double> const seconds = std::chrono::steady_clock::now() - start;
+        auto const bytes = static_cast<double>(3 * reps * len * dtype_size(dtype));
+        std::cout << "vector: axpy double precision: " << name << ": "
+                  << bytes / seconds.count() / 1e9 << " GB/s\n";
+
+        BENCHMARK(name) { y_r.axpy(alpha_r, x_r); };
+      }
+    }
+  }
+}
@@ -0,0 +1,84 @@
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include "device.hpp"
+#include "tensor.hpp"
+
+using namespace gpu_playground;
+
+TEST_CASE("vector: dot", "[vector]")
+{
+  auto const devices = make_devices();
+
+  constexpr size_t len{1'000'000};
+  std::vector<float> a_data(len);
+  std::vector<float> b_data(len);
+  std::iota(a_data.begin(), a_data.end(), 0.0);
+  std::iota(b_data.begin(), b_data.end(), 1.0);
+  Shape const shape{len, 1};
+  Tensor a(a_data, shape, devices[DeviceIdx::SERIAL]);
+  Tensor b(b_data, shape, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      a.to(device);
+      b.to(device);
+
+      BENCHMARK(std::string(get_device_name(device->type()))) { return a.dot(b); };
+    }
+  }
+}
+
+TEST_CASE("vector: dot per dtype", "[vector]")
+{
+  auto const devices = make_devices();
+
+  // Vectors well beyond the caches, so that the dot product is bound by the bytes it streams
+  constexpr size_t len{1U << 24};
+  constexpr size_t reps{10};
+  std::vector<float> a_data(len);
+  for (size_t i{0}; i < len; i++)
+  {
+    a_data[i] = static_cast<float>(i % 7) - 3.0F;
+  }
+  Shape const shape{len, 1};
+  Tensor a(a_data, shape, devices[DeviceIdx::SERIAL]);
+  Tensor b(a_data, shape, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F16))
+    {
+      a.to(device);
+      b.to(device);
+
+      for (auto const dtype : {DType::F64, DType::F32, DType::F16, DType::BF16})
+      {
+        auto const a_r  = a.to_dtype(dtype);
+        auto const b_r  = b.to_dtype(dtype);
+        auto const name = std::string(get_device_name(device->type())) + " " +
+                          std::string(get_dtype_name(dtype));
+
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t r{0}; r < reps; r++)
+        {
+          a_r.dot(b_r).sync();
+        }
+        std::chrono::duration<double> const seconds = std::chrono::steady_clock::now() - start;
+        auto const bytes = static_cast<double>(2 * reps * len * dtype_size(dtype));
+        std::cout << "vector: dot per dtype: " << name << ": "
+                  << bytes / seconds.count() / 1e9 << " GB/s\n";
+
+        BENCHMARK(name) { return a_r.dot(b_r); };
+      }
+    }
+  }
+}
@@ -1,7 +1,11 @@
 include(xsimd)
 
 add_library(simd_backend STATIC
+  "${SRC_DIR}/src/backends/simd/simd_batched.cpp"
   "${SRC_DIR}/src/backends/simd/simd_device.cpp"
+  "${SRC_DIR}/src/backends/simd/simd_gemm.cpp"
+  "${SRC_DIR}/src/backends/simd/simd_reduced.cpp"
+  "${SRC_DIR}/src/backends/simd/simd_sparse.cpp"
 )
 
 target_include_directories(simd_backend PRIVATE
@@ -11,6 +15,7 @@ target_include_directories(simd_backend PRIVATE
 
 target_link_libraries(simd_backend
     xsimd
+    Threads::Threads
 )
 
 target_compile_definitions(simd_backend PUBLIC
@@ -1,71 +1,589 @@
 #pragma once
 
+#include "csr_matrix.hpp"
+#include "preconditioners.hpp"
+#include "sell_matrix.hpp"
 #include "tensor.hpp"
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <limits>
+#include <vector>
 
 namespace gpu_playground
 {
 
-inline Tensor gradient_descent(
-    Tensor const &a,
+namespace detail
+{
+
+inline bool is_check(size_t const iter, size_t const check_every)
+{
+  return check_every <= 1 or iter % check_every == 0;
+}
+
+// Cholesky factor L of the row-major s x s symmetric matrix m, in place in its lower triangle.
+// Fails when a pivot is not safely positive, i.e. when m is numerically singular.
+inline bool cholesky(std::vector<double> &m, size_t const s)
+{
+  for (size_t j{0}; j < s; j++)
+  {
+    auto const diag = m[(j * s) + j];
+    auto pivot      = diag;
+    for (size_t k{0}; k < j; k++)
+    {
+      pivot -= m[(j * s) + k] * m[(j * s) + k];
+    }
+    if (not(pivot > std::numeric_limits<float>::epsilon() * diag))
+    {
+      return false;
+    }
+    m[(j * s) + j] = std::sqrt(pivot);
+    for (size_t i{j + 1}; i < s; i++)
+    {
+      auto value = m[(i * s) + j];
+      for (size_t k{0}; k < j; k++)
+      {
+        value -= m[(i * s) + k] * m[(j * s) + k];
+      }
+      m[(i * s) + j] = value / m[(j * s) + j];
+    }
+  }
+  return true;
+}
+
+// Y = (L L^T)^-1 C for the row-major s x s matrix C, with L from `cholesky`
+inline std::vector<float>
+cholesky_solve(std::vector<double> const &l, std::vector<float> const &c, size_t const s)
+{
+  std::vector<double> y(c.cbegin(), c.cend());
+  for (size_t col{0}; col < s; col++)
+  {
+    for (size_t i{0}; i < s; i++)
+    {
+      for (size_t k{0}; k < i; k++)
+      {
+        y[(i * s) + col] -= l[(i * s) + k] * y[(k * s) + col];
+      }
+      y[(i * s) + col] /= l[(i * s) + i];
+    }
+    for (size_t i{s}; i-- > 0;)
+    {
+      for (size_t k{i + 1}; k < s; k++)
+      {
+        y[(i * s) + col] -= l[(k * s) + i] * y[(k * s) + col];
+      }
+      y[(i * s) + col] /= l[(i * s) + i];
+    }
+  }
+  return {y.cbegin(), y.cend()};
+}
+
+// 1x1 tensor holding `value`, with the dtype and on the device of `like`
+inline Tensor scalar_like(double const value, Tensor const &like)
+{
+  if (like.dtype() == DType::F64)
+  {
+    return Tensor::from_f64({value}, Shape{1, 1}, like.get_device());
+  }
+  Tensor scalar({static_cast<float>(value)}, Shape{1, 1}, like.get_device());
+  if (like.dtype() == DType::F32)
+  {
+    return scalar;
+  }
+  return scalar.to_dtype(like.dtype());
+}
+
+// num / den for 1x1 tensors in a single kernel, 0 where den is 0. Once a solver has converged
+// exactly its scalar updates are 0 / 0, which then leave x unchanged instead of making it NaN.
+inline Tensor quotient(Tensor const &num, Tensor const &den)
+{
+  return num.lazy().cdiv_or_zero(den.lazy());
+}
+
+} // namespace detail
+
+// `a` is any operator whose product with a column vector gives a Tensor, such as a dense Tensor,
+// a CsrMatrix or a SellMatrix.
+//
+// The residual norm is read back to the host every `check_every` iterations only, so that the
+// device can queue the iterations in between. Up to `check_every - 1` iterations may then run
+// past convergence, which is harmless: their scalar updates go through `detail::quotient`, which
+// gives 0 rather than 0 / 0 once the residual is exactly zero, and so leaves x unchanged.
+//
+// Gradient descent and conjugate gradient run in the dtype of x0, F32 or F64, which `a` and b
+// must share. The residual norm is read and compared to `tol` in double, so that an F64 solve
+// can converge below the accuracy of float.
+template <class Operator>
+Tensor gradient_descent(
+    Operator const &a,
     Tensor const &b,
     Tensor const &x0,
-    size_t const max_iter = 1000,
-    float const tol       = std::numeric_limits<float>::epsilon()
+    size_t const max_iter    = 1000,
+    double const tol         = std::numeric_limits<float>::epsilon(),
+    size_t const check_every = 1
 )
 {
   Tensor x_res{x0};
+  auto const minus_one = detail::scalar_like(-1.0, x_res);
 
   auto r = b - a * x_res;
 
   for (size_t i{0}; i < max_iter; i++)
   {
-    auto const r_t = r.transpose();
-    auto const r_e = r_t * r;
-    if (std::sqrt(r_e.cpu().front()) < tol)
+    auto const r_e = r.dot(r);
+    if (detail::is_check(i, check_every) and std::sqrt(r_e.item_f64()) < tol)
     {
       return x_res;
     }
 
-    auto const ar   = a * r;
-    auto const eta  = r_e.cdiv(r_t * ar);
-    x_res          += r.smul(eta);
-    r              -= ar.smul(eta);
+    auto const ar  = a * r;
+    auto const eta = detail::quotient(r_e, r.dot(ar));
+    x_res.axpy(eta, r);
+    r.axpy(eta.smul(minus_one), ar);
   }
 
   return x_res;
 }
 
-inline Tensor conjuaget_gradient(
+template <class Operator>
+Tensor conjuaget_gradient(
+    Operator const &a,
+    Tensor const &b,
+    Tensor const &x0,
+    size_t const max_iter    = 1000,
+    double const tol         = std::numeric_limits<float>::epsilon(),
+    size_t const check_every = 1
+)
+{
+  Tensor x_res{x0};
+  auto const one       = detail::scalar_like(1.0, x_res);
+  auto const minus_one = detail::scalar_like(-1.0, x_res);
+
+  auto r   = b - a * x_res;
+  auto p   = r;
+  auto r_e = r.dot(r);
+
+  for (size_t i{0}; i < max_iter; i++)
+  {
+    if (detail::is_check(i, check_every) and std::sqrt(r_e.item_f64()) < tol)
+    {
+      return x_res;
+    }
+
+    auto const ap    = a * p;
+    auto const alpha = detail::quotient(r_e, p.dot(ap));
+    x_res.axpy(alpha, p);
+    r.axpy(alpha.smul(minus_one), ap);
+    auto const r_e_next = r.dot(r);
+    p.axpby(one, r, detail::quotient(r_e_next, r_e));
+    r_e = r_e_next;
+  }
+
+  return x_res;
+}
+
+// Mixed-precision iterative refinement of the SPD system A x = b held in F64. The residuals
+// r = b - A x and the updates x += d are computed in F64, while every correction equation A d = r
+// is solved by `conjuaget_gradient` in F32, on a copy of `a` that streams half the bytes. x then
+// reaches double accuracy, as long as the condition number of A stays well below 1 / eps of float.
+//
+// Each correction is solved to the relative accuracy `inner_tol`: r is scaled to unit norm first,
+// so that it stays in the range of float as it shrinks. Stops when the norm of the F64 residual is
+// at most `tol`, after at most `max_iter` corrections.
+inline Tensor mixed_precision_refinement(
     Tensor const &a,
     Tensor const &b,
     Tensor const &x0,
+    size_t const max_iter       = 100,
+    double const tol            = 1e-12,
+    size_t const inner_max_iter = 1000,
+    float const inner_tol       = 1e-4
+)
+{
+#ifndef NDEBUG
+  assert(
+      a.dtype() == DType::F64 and b.dtype() == DType::F64 and x0.dtype() == DType::F64 and
+      "Iterative refinement needs an F64 system"
+  );
+#endif
+
+  Tensor x_res{x0};
+  auto const device = x_res.get_device();
+  auto const a_low  = a.to_dtype(DType::F32);
+  auto const d0     = Tensor::zeros(b.shape(), device);
+
+  for (size_t i{0}; i < max_iter; i++)
+  {
+    auto const r    = b - a * x_res;
+    auto const norm = std::sqrt(r.dot(r).item_f64());
+    if (norm <= tol)
+    {
+      return x_res;
+    }
+
+    auto const scale = Tensor::from_f64({1.0 / norm}, Shape{1, 1}, device);
+    auto const d     = conjuaget_gradient(
+        a_low, r.smul(scale).to_dtype(DType::F32), d0, inner_max_iter, inner_tol
+    );
+    x_res.axpy(Tensor::from_f64({norm}, Shape{1, 1}, device), d.to_dtype(DType::F64));
+  }
+
+  return x_res;
+}
+
+// Conjugate gradient on M^-1 A x = M^-1 b, where `m` is a preconditioner such as a
+// JacobiPreconditioner, SsorPreconditioner or Ilu0Preconditioner. Stops on the norm of the
+// unpreconditioned residual, as `conjuaget_gradient` does. Runs in the dtype of x0, which the
+// results of `m.apply` must share.
+template <class Operator, class Preconditioner>
+Tensor preconditioned_conjugate_gradient(
+    Operator const &a,
+    Tensor const &b,
+    Tensor const &x0,
+    Preconditioner const &m,
+    size_t const max_iter    = 1000,
+    double const tol         = std::numeric_limits<float>::epsilon(),
+    size_t const check_every = 1
+)
+{
+  Tensor x_res{x0};
+  auto const one       = detail::scalar_like(1.0, x_res);
+  auto const minus_one = detail::scalar_like(-1.0, x_res);
+
+  auto r   = b - a * x_res;
+  auto z   = m.apply(r);
+  auto p   = z;
+  auto r_z = r.dot(z);
+
+  for (size_t i{0}; i < max_iter; i++)
+  {
+    if (detail::is_check(i, check_every) and std::sqrt(r.dot(r).item_f64()) < tol)
+    {
+      return x_res;
+    }
+
+    auto const ap    = a * p;
+    auto const alpha = detail::quotient(r_z, p.dot(ap));
+    x_res.axpy(alpha, p);
+    r.axpy(alpha.smul(minus_one), ap);
+    z                   = m.apply(r);
+    auto const r_z_next = r.dot(z);
+    p.axpby(one, z, detail::quotient(r_z_next, r_z));
+    r_z = r_z_next;
+  }
+
+  return x_res;
+}
+
+// Conjugate gradient on the s right-hand sides of the n x s block b at once (O'Leary), sharing
+// one Krylov subspace between them. Every iteration multiplies `a` by an n x s block, so that a
+// sparse `a` is read once for all s columns, and factors two s x s matrices on the host. The
+// shared subspace also takes fewer iterations than s separate solves, at the price of about
+// 5 n s^2 dense flops per iteration. Stops when the residual norm of every column is below `tol`.
+//
+// If the block loses rank, e.g. for repeated or already solved right-hand sides, the columns
+// that have not converged yet are finished one at a time by `conjuaget_gradient`.
+template <class Operator>
+Tensor block_conjugate_gradient(
+    Operator const &a,
+    Tensor const &b,
+    Tensor const &x0,
     size_t const max_iter = 1000,
     float const tol       = std::numeric_limits<float>::epsilon()
 )
 {
   Tensor x_res{x0};
+  auto const device = x_res.get_device();
+  auto const n      = b.shape().rows;
+  auto const s      = b.shape().cols;
 
-  auto r = b - a * x_res;
-  auto p = r;
+  auto r   = b - a * x_res;
+  auto p   = r;
+  auto rtr = (r.transpose() * r).cpu();
+
+  auto const converged = [&]()
+  {
+    for (size_t j{0}; j < s; j++)
+    {
+      if (std::sqrt(rtr[(j * s) + j]) >= tol)
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  size_t iter{0};
+  for (; iter < max_iter and not converged(); iter++)
+  {
+    // alpha = (P^T A P)^-1 R^T R
+    auto const ap   = a * p;
+    auto const ptap = (p.transpose() * ap).cpu();
+    std::vector<double> ptap_fac(ptap.cbegin(), ptap.cend());
+    std::vector<double> rtr_fac(rtr.cbegin(), rtr.cend());
+    if (not detail::cholesky(ptap_fac, s) or not detail::cholesky(rtr_fac, s))
+    {
+      break;
+    }
+    Tensor const alpha(detail::cholesky_solve(ptap_fac, rtr, s), Shape{s, s}, device);
+    x_res += p * alpha;
+    r -= ap * alpha;
+
+    // beta = (R^T R)^-1 R_next^T R_next
+    auto rtr_next = (r.transpose() * r).cpu();
+    Tensor const beta(detail::cholesky_solve(rtr_fac, rtr_next, s), Shape{s, s}, device);
+    p   = r + p * beta;
+    rtr = std::move(rtr_next);
+  }
+
+  if (iter == max_iter or converged())
+  {
+    return x_res;
+  }
+
+  // Breakdown: the columns left are solved one at a time from the current iterate
+  auto x_host       = x_res.cpu();
+  auto const b_host = b.cpu();
+  std::vector<float> x_col(n);
+  std::vector<float> b_col(n);
+  for (size_t j{0}; j < s; j++)
+  {
+    if (std::sqrt(rtr[(j * s) + j]) < tol)
+    {
+      continue;
+    }
+    for (size_t i{0}; i < n; i++)
+    {
+      x_col[i] = x_host[(i * s) + j];
+      b_col[i] = b_host[(i * s) + j];
+    }
+    auto const col = conjuaget_gradient(
+        a,
+        Tensor(b_col, Shape{n, 1}, device),
+        Tensor(x_col, Shape{n, 1}, device),
+        max_iter - iter,
+        tol
+    );
+    auto const col_host = col.cpu();
+    for (size_t i{0}; i < n; i++)
+    {
+      x_host[(i * s) + j] = col_host[i];
+    }
+  }
+  return {std::move(x_host), b.shape(), device};
+}
+
+// Conjugate gradient on a batch of small independent SPD systems A_i x_i = b_i, with `a` stacking
+// the (n x n) matrices A_i by rows into a (batch * n x n) row-major tensor and b, x0 the vectors.
+// A single device call iterates all the systems in lockstep, every one stopping on its own
+// residual norm, instead of paying the cost of one `Tensor` operation per step and per system.
+inline Tensor batched_conjugate_gradient(
+    Tensor const &a,
+    Tensor const &b,
+    Tensor const &x0,
+    size_t const batch,
+    size_t const max_iter = 1000,
+    float const tol       = std::numeric_limits<float>::epsilon()
+)
+{
+  return a.batched_cg(b, x0, batch, max_iter, tol);
+}
+
+// Direct solve of the same batch of systems by Cholesky factorisation, in n^3 / 3 multiply-adds
+// per system. Systems that are not positive definite get unspecified solutions.
+inline Tensor batched_cholesky_solve(Tensor const &a, Tensor const &b, size_t const batch)
+{
+  return a.batched_cholesky(b, batch);
+}
+
+// Restarted GMRES(m) for non-symmetric systems, with `restart` the dimension m of the Krylov
+// subspace. The basis is orthogonalised by modified Gram-Schmidt on the device, while the small
+// Hessenberg least-squares problem is reduced by Givens rotations on the host. Stops on the
+// residual norm estimated by the rotations, after at most `max_iter` products with `a`.
+template <class Operator>
+Tensor gmres(
+    Operator const &a,
+    Tensor const &b,
+    Tensor const &x0,
+    size_t const restart  = 30,
+    size_t const max_iter = 1000,
+    float const tol       = std::numeric_limits<float>::epsilon()
+)
+{
+  Tensor x_res{x0};
+  auto const device = x_res.get_device();
+  auto const m      = std::max<size_t>(restart, 1);
+  Tensor const minus_one({-1.0}, Shape{1, 1}, device);
+  auto const scalar = [&](float const value) { return Tensor({value}, Shape{1, 1}, device); };
+
+  // Krylov basis, allocated once per solve and reused by every restart
+  std::vector<Tensor> basis;
+  basis.reserve(m + 1);
+  for (size_t i{0}; i <= m; i++)
+  {
+    basis.push_back(Tensor::empty(b.shape(), device));
+  }
+
+  // Column-major (m + 1) x m Hessenberg matrix, rotations and rotated right-hand side
+  std::vector<float> h((m + 1) * m);
+  std::vector<float> cs(m);
+  std::vector<float> sn(m);
+  std::vector<float> g(m + 1);
+  std::vector<Tensor> coeffs;
+  coeffs.reserve(m);
+  auto const at = [&](size_t const i, size_t const j) -> float & { return h[(j * (m + 1)) + i]; };
+
+  size_t iter{0};
+  while (iter < max_iter)
+  {
+    auto const r    = b - a * x_res;
+    auto const beta = std::sqrt(r.dot(r).item());
+    if (beta < tol)
+    {
+      return x_res;
+    }
+    basis[0] = r.lazy().smul(scalar(1.0F / beta).lazy());
+    std::fill(g.begin(), g.end(), 0.0F);
+    g[0] = beta;
+
+    size_t k{0};
+    bool converged{false};
+    bool breakdown{false};
+    while (k < m and iter < max_iter and not converged)
+    {
+      auto w = a * basis[k];
+      coeffs.clear();
+      for (size_t i{0}; i <= k; i++)
+      {
+        coeffs.push_back(w.dot(basis[i]));
+        w.axpy(coeffs.back().smul(minus_one), basis[i]);
+      }
+      for (size_t i{0}; i <= k; i++)
+      {
+        at(i, k) = coeffs[i].item();
+      }
+      auto const norm = std::sqrt(w.dot(w).item());
+      at(k + 1, k)    = norm;
+
+      for (size_t i{0}; i < k; i++)
+      {
+        auto const upper = at(i, k);
+        at(i, k)         = (cs[i] * upper) + (sn[i] * at(i + 1, k));
+        at(i + 1, k)     = (cs[i] * at(i + 1, k)) - (sn[i] * upper);
+      }
+      auto const radius = std::hypot(at(k, k), norm);
+      if (radius == 0.0F)
+      {
+        // A zero column means A v_k = 0: `a` is singular and the subspace cannot grow, so the
+        // previous columns already give the least-squares solution
+        breakdown = true;
+        iter++;
+        break;
+      }
+      cs[k]        = at(k, k) / radius;
+      sn[k]        = norm / radius;
+      at(k, k)     = radius;
+      at(k + 1, k) = 0.0;
+      g[k + 1]     = -sn[k] * g[k];
+      g[k]         = cs[k] * g[k];
+
+      // A zero norm means the Krylov subspace is invariant and holds the solution
+      converged = std::abs(g[k + 1]) < tol or norm == 0.0F;
+      if (not converged)
+      {
+        basis[k + 1] = w.lazy().smul(scalar(1.0F / norm).lazy());
+      }
+      k++;
+      iter++;
+    }
+
+    // x += V y, with y solving the triangular system H y = g
+    for (size_t i{k}; i-- > 0;)
+    {
+      for (size_t j{i + 1}; j < k; j++)
+      {
+        g[i] -= at(i, j) * g[j];
+      }
+      g[i] /= at(i, i);
+    }
+    for (size_t i{0}; i < k; i++)
+    {
+      x_res.axpy(scalar(g[i]), basis[i]);
+    }
+
+    if (converged or breakdown)
+    {
+      return x_res;
+    }
+  }
+
+  return x_res;
+}
+
+// BiCGSTAB for non-symmetric systems, in constant memory unlike GMRES. Every scalar stays on the
+// device between checks. A check reads back the norms of r and of the half-step residual s, which
+// ends the solve early as in the standard algorithm, and the breakdown scalars rho and t . t.
+template <class Operator>
+Tensor bicgstab(
+    Operator const &a,
+    Tensor const &b,
+    Tensor const &x0,
+    size_t const max_iter    = 1000,
+    float const tol          = std::numeric_limits<float>::epsilon(),
+    size_t const check_every = 1
+)
+{
+  Tensor x_res{x0};
+
+  // s is updated in place by fused element-wise expressions
+  Tensor r = b - a * x_res;
+  Tensor r_hat{r};
+  Tensor p{r};
+  Tensor s = Tensor::empty(b.shape(), x_res.get_device());
+  auto rho = r_hat.dot(r);
 
   for (size_t i{0}; i < max_iter; i++)
   {
-    auto const r_t = r.transpose();
-    auto const r_e = r_t * r;
-    if (std::sqrt(r_e.cpu().front()) < tol)
+    auto const check = detail::is_check(i, check_every);
+    if (check and std::sqrt(r.dot(r).item()) < tol)
+    {
+      return x_res;
+    }
+    if (check and rho.item() == 0.0F)
+    {
+      // r is orthogonal to the shadow residual: restart from r
+      r_hat = r;
+      p     = r;
+      rho   = r.dot(r);
+    }
+
+    auto const v     = a * p;
+    auto const alpha = detail::quotient(rho, r_hat.dot(v));
+    s                = r.lazy() - v.lazy().smul(alpha.lazy());
+    if (check and std::sqrt(s.dot(s).item()) < tol)
+    {
+      x_res.axpy(alpha, p);
+      return x_res;
+    }
+
+    auto const t   = a * s;
+    auto const t_t = t.dot(t);
+    if (check and t_t.item() == 0.0F)
     {
+      // A s = 0 with s != 0: `a` is singular and x + alpha p is as far as the solve can go
+      x_res.axpy(alpha, p);
       return x_res;
     }
+    auto const omega = detail::quotient(t.dot(s), t_t);
+    x_res            = x_res.lazy() + p.lazy().smul(alpha.lazy()) + s.lazy().smul(omega.lazy());
+    r                = s.lazy() - t.lazy().smul(omega.lazy());
 
-    auto const p_t    = p.transpose();
-    auto const ap     = a * p;
-    auto const alpha  = r_e.cdiv(p_t * ap);
-    x_res            += p.smul(alpha);
-    r                -= ap.smul(alpha);
-    auto const beta   = (r.transpose() * r).cdiv(r_e);
-    p                 = r + p.smul(beta);
+    // beta = (rho_next / rho) (alpha / omega), in one quotient
+    auto const rho_next = r_hat.dot(r);
+    Tensor const beta   =
+        rho_next.lazy().cmul(alpha.lazy()).cdiv_or_zero(rho.lazy().cmul(omega.lazy()));
+    p   = r.lazy() + (p.lazy() - v.lazy().smul(omega.lazy())).smul(beta.lazy());
+    rho = rho_next;
   }
 
   return x_res;
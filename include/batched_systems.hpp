@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace gpu_playground::backend
+{
+
+// Host kernels on batches of small dense SPD systems A_s x_s = b_s, with the (n x n) matrices A_s
+// stacked by rows in `a` and the vectors stacked in `b` and `x`. Each one solves the systems
+// [first, last) one after the other.
+
+// Conjugate gradient from the initial guesses in x, every system stopping as soon as its own
+// residual norm is below `tol`
+inline void batched_cg_systems(
+    float const *a,
+    float const *b,
+    float *x,
+    size_t const n,
+    size_t const first,
+    size_t const last,
+    size_t const max_iter,
+    float const tol
+)
+{
+  std::vector<float> r(n);
+  std::vector<float> p(n);
+  std::vector<float> ap(n);
+  auto const row_dot = [n](float const *row, float const *v)
+  {
+    float acc{0.0};
+    for (size_t j{0}; j < n; j++)
+    {
+      acc = std::fma(row[j], v[j], acc);
+    }
+    return acc;
+  };
+
+  for (size_t s{first}; s < last; s++)
+  {
+    auto const *a_s = a + (s * n * n);
+    auto const *b_s = b + (s * n);
+    auto *x_s       = x + (s * n);
+
+    float rr{0.0};
+    for (size_t i{0}; i < n; i++)
+    {
+      r[i] = b_s[i] - row_dot(a_s + (i * n), x_s);
+      p[i] = r[i];
+      rr   = std::fma(r[i], r[i], rr);
+    }
+
+    for (size_t iter{0}; iter < max_iter and std::sqrt(rr) >= tol; iter++)
+    {
+      float pap{0.0};
+      for (size_t i{0}; i < n; i++)
+      {
+        ap[i] = row_dot(a_s + (i * n), p.data());
+        pap   = std::fma(p[i], ap[i], pap);
+      }
+      auto const alpha = rr / pap;
+
+      float rr_next{0.0};
+      for (size_t i{0}; i < n; i++)
+      {
+        x_s[i]  = std::fma(alpha, p[i], x_s[i]);
+        r[i]    = std::fma(-alpha, ap[i], r[i]);
+        rr_next = std::fma(r[i], r[i], rr_next);
+      }
+      auto const beta = rr_next / rr;
+      for (size_t i{0}; i < n; i++)
+      {
+        p[i] = std::fma(beta, p[i], r[i]);
+      }
+      rr = rr_next;
+    }
+  }
+}
+
+// Cholesky factorisation A_s = L L^T of every system followed by the two triangular solves. A
+// system that is not positive definite gets NaN in its solution.
+inline void batched_cholesky_systems(
+    float const *a, float const *b, float *x, size_t const n, size_t const first, size_t const last
+)
+{
+  std::vector<float> l(n * n);
+  for (size_t s{first}; s < last; s++)
+  {
+    auto const *a_s = a + (s * n * n);
+    auto const *b_s = b + (s * n);
+    auto *x_s       = x + (s * n);
+
+    std::copy(a_s, a_s + (n * n), l.begin());
+    for (size_t j{0}; j < n; j++)
+    {
+      auto diag = l[(j * n) + j];
+      for (size_t k{0}; k < j; k++)
+      {
+        diag = std::fma(-l[(j * n) + k], l[(j * n) + k], diag);
+      }
+      l[(j * n) + j] = std::sqrt(diag);
+      for (size_t i{j + 1}; i < n; i++)
+      {
+        auto value = l[(i * n) + j];
+        for (size_t k{0}; k < j; k++)
+        {
+          value = std::fma(-l[(i * n) + k], l[(j * n) + k], value);
+        }
+        l[(i * n) + j] = value / l[(j * n) + j];
+      }
+    }
+
+    // L y = b, then L^T x = y
+    for (size_t i{0}; i < n; i++)
+    {
+      auto value = b_s[i];
+      for (size_t k{0}; k < i; k++)
+      {
+        value = std::fma(-l[(i * n) + k], x_s[k], value);
+      }
+      x_s[i] = value / l[(i * n) + i];
+    }
+    for (size_t i{n}; i-- > 0;)
+    {
+      auto value = x_s[i];
+      for (size_t k{i + 1}; k < n; k++)
+      {
+        value = std::fma(-l[(k * n) + i], x_s[k], value);
+      }
+      x_s[i] = value / l[(i * n) + i];
+    }
+  }
+}
+
+} // namespace gpu_playground::backend
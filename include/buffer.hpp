@@ -1,18 +1,21 @@
 #pragma once
 
 #include <cassert>
-#include <functional>
 #include <memory>
 #include <type_traits>
 
 #include "device_types.hpp"
+#include "dtype.hpp"
 #include "shape.hpp"
 
 namespace gpu_playground::backend
 {
 
-using HandlePtr = std::unique_ptr<void, std::function<void(void *)>>;
+using HandlePtr = std::shared_ptr<void>;
 
+// Device storage together with the shape it is seen with. Several buffers may share the same
+// storage, e.g. a matrix and its transposed view. A transposed matrix keeps the row-major
+// storage of its transpose, vectors are laid out the same either way and are never flagged.
 class Buffer
 {
 private:
@@ -20,6 +23,14 @@ private:
   Shape m_shape;
   size_t m_size;
   DeviceType m_device_type;
+  DType m_dtype{DType::F32};
+  bool m_transposed{false};
+
+  Buffer(HandlePtr handle, Shape shape, DeviceType device_type, DType dtype, bool transposed)
+      : m_handle(std::move(handle)), m_shape(shape), m_size(shape.rows * shape.cols),
+        m_device_type(device_type), m_dtype(dtype), m_transposed(transposed)
+  {
+  }
 
 public:
   Buffer()                          = delete;
@@ -29,21 +40,56 @@ public:
   Buffer &operator=(Buffer &&)      = default;
   ~Buffer()                         = default;
 
-  Buffer(HandlePtr handle, Shape shape, DeviceType device_type)
+  Buffer(HandlePtr handle, Shape shape, DeviceType device_type, DType dtype = DType::F32)
       : m_handle(std::move(handle)), m_shape(shape), m_size(shape.rows * shape.cols),
-        m_device_type(device_type)
+        m_device_type(device_type), m_dtype(dtype)
   {
   }
 
+  // Buffer sharing the storage of this one
+  [[nodiscard]] Buffer view() const
+  {
+    return Buffer{
+        this->m_handle, this->m_shape, this->m_device_type, this->m_dtype, this->m_transposed
+    };
+  }
+
+  // Transposed view sharing the storage of this buffer
+  [[nodiscard]] Buffer transposed() const
+  {
+    auto const [rows, cols] = this->m_shape;
+    auto const flagged      = rows != 1 and cols != 1 and not this->m_transposed;
+    return Buffer{this->m_handle, Shape{cols, rows}, this->m_device_type, this->m_dtype, flagged};
+  }
+
+  // Row-major view of the storage, i.e. this buffer unless it is transposed
+  [[nodiscard]] Buffer storage() const
+  {
+    return this->m_transposed ? this->transposed() : this->view();
+  }
+
   [[nodiscard]] void *get() { return this->m_handle.get(); }
 
   [[nodiscard]] void const *get() const { return this->m_handle.get(); }
 
   [[nodiscard]] Shape shape() const { return this->m_shape; }
 
+  // Shape of the row-major storage behind this buffer
+  [[nodiscard]] Shape storage_shape() const
+  {
+    return this->m_transposed ? Shape{this->m_shape.cols, this->m_shape.rows} : this->m_shape;
+  }
+
   [[nodiscard]] size_t size() const { return this->m_size; }
 
   [[nodiscard]] DeviceType device_type() const { return this->m_device_type; }
+
+  [[nodiscard]] DType dtype() const { return this->m_dtype; }
+
+  [[nodiscard]] bool is_transposed() const { return this->m_transposed; }
+
+  // Whether other buffers share this storage
+  [[nodiscard]] bool is_shared() const { return this->m_handle.use_count() > 1; }
 };
 
 template <typename... Rest>
@@ -74,6 +120,32 @@ assert_size_nonzero([[maybe_unused]] Buffer const &first, [[maybe_unused]] Rest
 #endif
 }
 
+// Only conversions, copies and the products of `assert_compatible_mul` and
+// `assert_compatible_dot` read reduced precision buffers, everything else works on buffers that
+// are either all F32 or all F64
+template <typename... Rest>
+inline void
+assert_float_storage([[maybe_unused]] Buffer const &first, [[maybe_unused]] Rest const &...rest)
+{
+#ifndef NDEBUG
+  assert_is_buffer<Rest...>();
+  assert(not is_reduced(first.dtype()) and "Operation only supports F32 and F64 buffers");
+  (assert(rest.dtype() == first.dtype() and "Buffers must have the same dtype"), ...);
+#endif
+}
+
+// Sparse and batched kernels only exist for F32
+template <typename... Rest>
+inline void
+assert_single_precision([[maybe_unused]] Buffer const &first, [[maybe_unused]] Rest const &...rest)
+{
+#ifndef NDEBUG
+  assert_is_buffer<Rest...>();
+  assert(first.dtype() == DType::F32 and "Operation only supports F32 buffers");
+  (assert(rest.dtype() == DType::F32 and "Operation only supports F32 buffers"), ...);
+#endif
+}
+
 template <typename... Rest>
 inline void
 assert_valid_buffers([[maybe_unused]] Buffer const &first, [[maybe_unused]] Rest const &...rest)
@@ -82,6 +154,37 @@ assert_valid_buffers([[maybe_unused]] Buffer const &first, [[maybe_unused]] Rest
   assert_is_buffer<Rest...>();
   assert_same_device(first, rest...);
   assert_size_nonzero(first, rest...);
+  assert_float_storage(first, rest...);
+#endif
+}
+
+// Operands of any dtype but F64, in row-major storage when it is a reduced precision one, and an
+// F32 result, or F64 operands and result
+template <typename... Rest>
+inline void assert_valid_mixed_buffers(
+    [[maybe_unused]] Buffer const &out,
+    [[maybe_unused]] Buffer const &first,
+    [[maybe_unused]] Rest const &...rest
+)
+{
+#ifndef NDEBUG
+  assert_is_buffer<Rest...>();
+  assert_same_device(out, first, rest...);
+  assert_size_nonzero(out, first, rest...);
+  auto const f64 = out.dtype() == DType::F64;
+  assert((f64 or out.dtype() == DType::F32) and "Products are F32 or F64");
+  assert((first.dtype() == DType::F64) == f64 and "F64 buffers only combine with F64 buffers");
+  (assert((rest.dtype() == DType::F64) == f64 and "F64 buffers only combine with F64 buffers"),
+   ...);
+  assert(
+      (not is_reduced(first.dtype()) or not first.is_transposed()) and
+      "Reduced precision buffers must be row-major"
+  );
+  (assert(
+       (not is_reduced(rest.dtype()) or not rest.is_transposed()) and
+       "Reduced precision buffers must be row-major"
+   ),
+   ...);
 #endif
 }
 
@@ -106,6 +209,8 @@ assert_valid_transpose([[maybe_unused]] Buffer const &first, [[maybe_unused]] Re
   auto const cols = first.shape().cols;
   (assert(rest.shape().rows == cols and "Output buffers rows must equals input cols"), ...);
   (assert(rest.shape().cols == rows and "Output buffers cols must equals input rows"), ...);
+  assert(not first.is_transposed() and "Input buffer must be row-major");
+  (assert(not rest.is_transposed() and "Output buffers must be row-major"), ...);
 #endif
 }
 
@@ -129,8 +234,26 @@ inline void
 assert_compatible_copy([[maybe_unused]] Buffer const &first, [[maybe_unused]] Rest const &...rest)
 {
 #ifndef NDEBUG
-  assert_valid_buffers(first, rest...);
+  assert_is_buffer<Rest...>();
+  assert_same_device(first, rest...);
+  assert_size_nonzero(first, rest...);
   assert_valid_copy(first, rest...);
+  (assert(rest.dtype() == first.dtype() and "Buffers must have the same dtype"), ...);
+#endif
+}
+
+// to = from converted to the dtype of `to`, both in row-major storage
+inline void
+assert_compatible_convert([[maybe_unused]] Buffer const &from, [[maybe_unused]] Buffer const &to)
+{
+#ifndef NDEBUG
+  assert_same_device(from, to);
+  assert_size_nonzero(from, to);
+  assert_valid_copy(from, to);
+  assert(
+      not from.is_transposed() and not to.is_transposed() and
+      "Converted buffers must be row-major"
+  );
 #endif
 }
 
@@ -164,7 +287,7 @@ inline void assert_compatible_mul(
 )
 {
 #ifndef NDEBUG
-  assert_valid_buffers(a, b, c);
+  assert_valid_mixed_buffers(c, a, b);
   assert_valid_mul(a, b, c);
 #endif
 }
@@ -177,9 +300,126 @@ inline void assert_compatible_sop(
 {
 #ifndef NDEBUG
   assert_same_shape(a, c);
+  assert_valid_buffers(a, b);
   assert(b.shape().rows == 1 and "Buffer must have 1 row");
   assert(b.shape().cols == 1 and "Buffer must have 1 column");
 #endif
 }
 
+inline void assert_compatible_dot(
+    [[maybe_unused]] Buffer const &a,
+    [[maybe_unused]] Buffer const &b,
+    [[maybe_unused]] Buffer const &c
+)
+{
+#ifndef NDEBUG
+  assert_valid_mixed_buffers(c, a, b);
+  assert_valid_copy(a, b);
+  assert(c.shape().rows == 1 and "Buffer must have 1 row");
+  assert(c.shape().cols == 1 and "Buffer must have 1 column");
+#endif
+}
+
+inline void assert_compatible_axpy(
+    [[maybe_unused]] Buffer const &alpha,
+    [[maybe_unused]] Buffer const &x,
+    [[maybe_unused]] Buffer const &y
+)
+{
+#ifndef NDEBUG
+  assert_same_shape(x, y);
+  assert_valid_buffers(alpha, x);
+  assert(alpha.shape().rows == 1 and "Buffer must have 1 row");
+  assert(alpha.shape().cols == 1 and "Buffer must have 1 column");
+#endif
+}
+
+inline void assert_compatible_axpby(
+    [[maybe_unused]] Buffer const &alpha,
+    [[maybe_unused]] Buffer const &x,
+    [[maybe_unused]] Buffer const &beta,
+    [[maybe_unused]] Buffer const &y
+)
+{
+#ifndef NDEBUG
+  assert_compatible_axpy(alpha, x, y);
+  assert_compatible_axpy(beta, x, y);
+#endif
+}
+
+// C_i = A_i * B_i for i < batch, with the matrices of each batch stacked by rows
+inline void assert_compatible_batched_mul(
+    [[maybe_unused]] Buffer const &a,
+    [[maybe_unused]] Buffer const &b,
+    [[maybe_unused]] Buffer const &c,
+    [[maybe_unused]] size_t const batch
+)
+{
+#ifndef NDEBUG
+  assert_valid_buffers(a, b, c);
+  assert_single_precision(a, b, c);
+  assert(batch > 0 and "Batch must hold at least one matrix");
+  assert(
+      not a.is_transposed() and not b.is_transposed() and not c.is_transposed() and
+      "Batched buffers must be row-major"
+  );
+  assert(a.shape().rows % batch == 0 and "Rows of a must split evenly in the batch");
+  assert(b.shape().rows == batch * a.shape().cols and "Input buffers shape error");
+  assert(
+      (c.shape().rows == a.shape().rows and c.shape().cols == b.shape().cols) and
+      "Output buffer shape error"
+  );
+#endif
+}
+
+// a stacks the batch of (n x n) matrices by rows, b and x the (n x 1) vectors
+inline void assert_compatible_batched_solve(
+    [[maybe_unused]] Buffer const &a,
+    [[maybe_unused]] Buffer const &b,
+    [[maybe_unused]] Buffer const &x,
+    [[maybe_unused]] size_t const batch
+)
+{
+#ifndef NDEBUG
+  assert_valid_buffers(a, b, x);
+  assert_single_precision(a, b, x);
+  assert(batch > 0 and "Batch must hold at least one system");
+  assert(not a.is_transposed() and "Batched matrices must be row-major");
+  assert(a.shape().rows == batch * a.shape().cols and "Batched matrices must be square");
+  assert(
+      (b.shape().rows == a.shape().rows and b.shape().cols == 1) and "Right-hand side shape error"
+  );
+  assert((x.shape().rows == b.shape().rows and x.shape().cols == 1) and "Solution shape error");
+#endif
+}
+
+// c = a op b, with b a row vector (1 x cols) repeated over the rows of a or a column vector
+// (rows x 1) repeated over its columns, and c laid out as a
+inline void assert_compatible_broadcast(
+    [[maybe_unused]] Buffer const &a,
+    [[maybe_unused]] Buffer const &b,
+    [[maybe_unused]] Buffer const &c
+)
+{
+#ifndef NDEBUG
+  assert_valid_buffers(a, b, c);
+  assert_same_shape(a, c);
+  assert(a.is_transposed() == c.is_transposed() and "Output buffer layout error");
+  auto const [rows, cols] = a.shape();
+  assert(
+      ((b.shape().rows == 1 and b.shape().cols == cols) or
+       (b.shape().rows == rows and b.shape().cols == 1)) and
+      "Broadcast buffer must be a row or column vector of the matrix"
+  );
+#endif
+}
+
+// Whether the vector broadcast over a holds one value per row of the storage of a, rather than
+// one per column of it
+inline bool broadcast_per_row(Buffer const &a, Buffer const &b)
+{
+  auto const column_vector = b.shape().cols == 1 and b.shape().rows == a.shape().rows;
+  return column_vector != a.is_transposed();
+}
+
 } // namespace gpu_playground::backend
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer.hpp"
+
+namespace gpu_playground
+{
+
+struct AllocatorStats
+{
+  size_t hits{0};
+  size_t misses{0};
+  size_t bytes_cached{0};
+
+  // Combines the stats of the several caches of a device
+  AllocatorStats &operator+=(AllocatorStats const &other)
+  {
+    this->hits += other.hits;
+    this->misses += other.misses;
+    this->bytes_cached += other.bytes_cached;
+    return *this;
+  }
+};
+
+} // namespace gpu_playground
+
+namespace gpu_playground::backend
+{
+
+// Blocks up to 512 bytes are rounded to 64 bytes, larger ones to a quarter of their power of two,
+// so that a cached block wastes at most 25% of its size.
+inline size_t size_class(size_t const bytes)
+{
+  constexpr size_t small = 512;
+  constexpr size_t line  = 64;
+  if (bytes <= small)
+  {
+    return ((bytes + line - 1) / line) * line;
+  }
+
+  size_t power{small};
+  while (power * 2 <= bytes)
+  {
+    power *= 2;
+  }
+  auto const step = power / 4;
+  return ((bytes + step - 1) / step) * step;
+}
+
+inline size_t exact_size_class(size_t const bytes) { return bytes; }
+
+// Caches the storage of released buffers by size class and hands it back to later allocations
+// of the same class.
+//
+// The pool is reference counted by the allocator and by every live storage block, so buffers may
+// outlive the device that created them.
+template <class Storage>
+class CachingAllocator
+{
+private:
+  struct Pool
+  {
+    std::mutex mutex;
+    std::unordered_map<size_t, std::vector<std::unique_ptr<Storage>>> blocks;
+    AllocatorStats stats;
+    std::atomic<size_t> refs{1};
+
+    Storage *take(size_t const cls)
+    {
+      std::lock_guard<std::mutex> const lock(this->mutex);
+      auto it = this->blocks.find(cls);
+      if (it == this->blocks.end() or it->second.empty())
+      {
+        this->stats.misses++;
+        return nullptr;
+      }
+
+      auto *storage = it->second.back().release();
+      it->second.pop_back();
+      this->stats.hits++;
+      this->stats.bytes_cached -= cls;
+      return storage;
+    }
+
+    void give(size_t const cls, Storage *storage)
+    {
+      std::lock_guard<std::mutex> const lock(this->mutex);
+      this->blocks[cls].emplace_back(storage);
+      this->stats.bytes_cached += cls;
+    }
+
+    static void unref(Pool *pool)
+    {
+      if (pool->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+        delete pool;
+      }
+    }
+  };
+
+  Pool *m_pool;
+  size_t (*m_size_class)(size_t);
+
+public:
+  explicit CachingAllocator(size_t (*size_class)(size_t) = &backend::size_class)
+      : m_pool(new Pool()), m_size_class(size_class)
+  {
+  }
+
+  CachingAllocator(CachingAllocator const &)            = delete;
+  CachingAllocator &operator=(CachingAllocator const &) = delete;
+  CachingAllocator(CachingAllocator &&)                 = delete;
+  CachingAllocator &operator=(CachingAllocator &&)      = delete;
+
+  ~CachingAllocator() { Pool::unref(this->m_pool); }
+
+  // Returns a handle to storage for `bytes` bytes. On a miss `make(class_bytes)` builds new
+  // storage big enough for the whole size class, on a hit `fit(storage)` adapts a cached block.
+  template <class Make, class Fit>
+  [[nodiscard]] HandlePtr allocate(size_t const bytes, Make const &make, Fit const &fit) const
+  {
+    auto const cls   = this->m_size_class(bytes);
+    Storage *storage = this->m_pool->take(cls);
+    if (storage == nullptr)
+    {
+      storage = make(cls);
+    }
+    else
+    {
+      fit(*storage);
+    }
+
+    this->m_pool->refs.fetch_add(1, std::memory_order_relaxed);
+    return HandlePtr{
+        storage,
+        [pool = this->m_pool, cls](void *ptr) -> void
+        {
+          pool->give(cls, static_cast<Storage *>(ptr));
+          Pool::unref(pool);
+        }
+    };
+  }
+
+  [[nodiscard]] AllocatorStats stats() const
+  {
+    std::lock_guard<std::mutex> const lock(this->m_pool->mutex);
+    return this->m_pool->stats;
+  }
+
+  // Frees every cached block.
+  void trim() const
+  {
+    std::lock_guard<std::mutex> const lock(this->m_pool->mutex);
+    this->m_pool->blocks.clear();
+    this->m_pool->stats.bytes_cached = 0;
+  }
+};
+
+} // namespace gpu_playground::backend
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+
+#include "tensor.hpp"
+
+namespace gpu_playground
+{
+
+// Sparse matrix in compressed sparse row format, used as the system operator of the solvers
+// when a dense Tensor would not fit in memory.
+class CsrMatrix
+{
+private:
+  DevicePtr device;
+  backend::SparseBuffer buffer;
+
+  CsrMatrix(Shape shape, backend::CsrData csr, DevicePtr device)
+      : device(std::move(device)), buffer(this->device->new_csr(shape, std::move(csr)))
+  {
+  }
+
+public:
+  CsrMatrix()  = delete;
+  ~CsrMatrix() = default;
+
+  CsrMatrix(CsrMatrix const &)            = delete;
+  CsrMatrix &operator=(CsrMatrix const &) = delete;
+  CsrMatrix(CsrMatrix &&)                 = default;
+  CsrMatrix &operator=(CsrMatrix &&)      = default;
+
+  // The non-zeros of row i are values[row_ptr[i] .. row_ptr[i + 1]), in columns col_idx[...]
+  CsrMatrix(
+      Shape shape,
+      std::vector<backend::CsrIndex> row_ptr,
+      std::vector<backend::CsrIndex> col_idx,
+      std::vector<float> values,
+      DevicePtr device
+  )
+      : CsrMatrix(
+            shape,
+            backend::CsrData{std::move(row_ptr), std::move(col_idx), std::move(values)},
+            std::move(device)
+        )
+  {
+  }
+
+  static CsrMatrix
+  from_triplets(Shape shape, std::vector<backend::Triplet> const &triplets, DevicePtr device)
+  {
+    return {shape, backend::csr_from_triplets(shape, triplets), std::move(device)};
+  }
+
+  // Non-zeros of a dense tensor, on the same device
+  static CsrMatrix from_dense(Tensor const &a)
+  {
+    return {a.shape(), backend::csr_from_dense(a.shape(), a.cpu()), a.get_device()};
+  }
+
+  // Sparse matrix-vector product with x a column vector, or sparse matrix times a block of
+  // columns, which reads the matrix once for all of them
+  Tensor operator*(Tensor const &x) const
+  {
+    Tensor out = Tensor::empty(Shape{this->buffer.shape().rows, x.shape().cols}, this->device);
+    if (x.shape().cols == 1)
+    {
+      this->device->spmv(this->buffer, x.buffer, out.buffer);
+      return out;
+    }
+    this->device->spmm(this->buffer, x.contiguous().buffer, out.buffer);
+    return out;
+  }
+
+  [[nodiscard]] Shape shape() const { return this->buffer.shape(); }
+
+  [[nodiscard]] size_t nnz() const { return this->buffer.nnz(); }
+
+  [[nodiscard]] DevicePtr get_device() const { return this->device; }
+};
+
+} // namespace gpu_playground
@@ -3,7 +3,11 @@
 #include <memory>
 #include <vector>
 
+#include "batched_systems.hpp"
 #include "buffer.hpp"
+#include "caching_allocator.hpp"
+#include "expression.hpp"
+#include "sparse_buffer.hpp"
 
 namespace gpu_playground
 {
@@ -50,22 +54,414 @@ public:
   virtual void
   sdiv(backend::Buffer const &a, backend::Buffer const &b, backend::Buffer &c) const = 0;
 
+  virtual void
+  dot(backend::Buffer const &a, backend::Buffer const &b, backend::Buffer &c) const = 0;
+
+  // y = alpha * x + y, with alpha a 1x1 buffer
+  virtual void
+  axpy(backend::Buffer const &alpha, backend::Buffer const &x, backend::Buffer &y) const = 0;
+
+  // y = alpha * x + beta * y, with alpha and beta 1x1 buffers
+  virtual void axpby(
+      backend::Buffer const &alpha,
+      backend::Buffer const &x,
+      backend::Buffer const &beta,
+      backend::Buffer &y
+  ) const = 0;
+
+  // y = a * x, with a sparse and x, y vectors. By default x is brought back to the host and
+  // multiplied there.
+  virtual void
+  spmv(backend::SparseBuffer const &a, backend::Buffer const &x, backend::Buffer &y) const;
+
+  // Y = a * X, with a sparse and X, Y row-major blocks of s columns, reading a once for all the
+  // columns. By default X is brought back to the host and multiplied there.
+  virtual void
+  spmm(backend::SparseBuffer const &a, backend::Buffer const &x, backend::Buffer &y) const;
+
+  // C_i = A_i * B_i for i < batch, where a stacks the batch of (m x k) matrices A_i by rows into
+  // a (batch * m x k) buffer, b the (k x n) matrices B_i and c the (m x n) results. By default
+  // the operands are brought back to the host and multiplied there.
+  virtual void batched_mul(
+      backend::Buffer const &a, backend::Buffer const &b, backend::Buffer &c, size_t batch
+  ) const;
+
+  // Solves the batch of small SPD systems A_i x_i = b_i by conjugate gradient, with a stacking the
+  // (n x n) matrices A_i by rows into a (batch * n x n) buffer and b, x the vectors. x holds the
+  // initial guesses on entry, and every system stops on its own residual norm. By default the
+  // systems are solved on the host.
+  virtual void batched_cg(
+      backend::Buffer const &a,
+      backend::Buffer const &b,
+      backend::Buffer &x,
+      size_t batch,
+      size_t max_iter,
+      float tol
+  ) const;
+
+  // Same systems solved directly by Cholesky factorisation, on the host by default
+  virtual void batched_cholesky(
+      backend::Buffer const &a, backend::Buffer const &b, backend::Buffer &x, size_t batch
+  ) const;
+
+  // c = a op b for op one of ADD, SUB, MUL and DIV, with b a row or column vector repeated over
+  // the matrix a. By default the operands are brought back to the host and combined there.
+  virtual void broadcast(
+      backend::ExprOp op, backend::Buffer const &a, backend::Buffer const &b, backend::Buffer &c
+  ) const;
+
+  // out = expr, evaluated by default one operation at a time through the other device ops
+  virtual void eval(backend::Expression const &expr, backend::Buffer &out) const;
+
   [[nodiscard]] virtual backend::Buffer new_buffer(std::vector<float> data, Shape shape) const = 0;
 
-  [[nodiscard]] backend::Buffer new_buffer_with_shape(Shape shape) const
+  // F64 buffer holding `data`, on devices that support F64
+  [[nodiscard]] virtual backend::Buffer
+  new_f64_buffer(std::vector<double> data, Shape shape) const
+  {
+#ifndef NDEBUG
+    assert(this->supports_dtype(DType::F64) and "Device does not store F64 buffers");
+#endif
+    return this->new_buffer(std::vector<float>(data.cbegin(), data.cend()), shape);
+  }
+
+  [[nodiscard]] virtual backend::Buffer new_buffer_with_shape(Shape shape) const
   {
     return this->new_buffer(std::vector<float>(shape.rows * shape.cols, 0.0), shape);
   }
 
+  // Buffer with unspecified contents, for outputs that are about to be fully overwritten
+  [[nodiscard]] virtual backend::Buffer new_empty_buffer(Shape shape) const
+  {
+    return this->new_buffer_with_shape(shape);
+  }
+
+  // Whether buffers of `dtype` can be created on this device. Devices only store F32 by default.
+  [[nodiscard]] virtual bool supports_dtype(DType const dtype) const
+  {
+    return dtype == DType::F32;
+  }
+
+  // Buffer with unspecified contents whose elements are of `dtype`, which must be supported
+  [[nodiscard]] virtual backend::Buffer
+  new_typed_buffer(Shape shape, [[maybe_unused]] DType dtype) const
+  {
+#ifndef NDEBUG
+    assert(dtype == DType::F32 and "Device only stores F32 buffers");
+#endif
+    return this->new_empty_buffer(shape);
+  }
+
+  // to = from converted to the dtype of `to`, rounding to nearest even
+  virtual void convert(backend::Buffer const &from, backend::Buffer &to) const
+  {
+    backend::assert_compatible_convert(from, to);
+    this->copy_buffer(from, to);
+  }
+
+  // Sparse matrix given by its CSR arrays, kept by default as host CSR arrays
+  [[nodiscard]] virtual backend::SparseBuffer new_csr(Shape shape, backend::CsrData csr) const
+  {
+    backend::assert_valid_csr(shape, csr);
+    auto const nnz = csr.values.size();
+    return backend::SparseBuffer{
+        std::make_shared<backend::CsrData>(std::move(csr)), shape, nnz, this->type()
+    };
+  }
+
+  // Sparse matrix in sliced ELLPACK (SELL-C-sigma) format, for devices with kernels for it: rows
+  // are sorted by length within windows of `sigma` rows and packed in chunks of C rows, padded to
+  // the longest row of the chunk. Kept in CSR by default.
+  [[nodiscard]] virtual backend::SparseBuffer
+  new_sell(Shape shape, backend::CsrData csr, [[maybe_unused]] size_t sigma) const
+  {
+    return this->new_csr(shape, std::move(csr));
+  }
+
+  [[nodiscard]] virtual AllocatorStats allocator_stats() const { return {}; }
+
+  // Releases the memory held by the device allocator cache
+  virtual void trim() const {}
+
   virtual void copy_buffer(backend::Buffer const &from, backend::Buffer &to) const = 0;
 
   virtual void transpose(backend::Buffer const &from, backend::Buffer &to) const = 0;
 
+  // Row-major copy of a transposed buffer, or a view of any other buffer
+  [[nodiscard]] backend::Buffer contiguous(backend::Buffer const &buffer) const
+  {
+    if (not buffer.is_transposed())
+    {
+      return buffer.view();
+    }
+
+    auto out = this->new_typed_buffer(buffer.shape(), buffer.dtype());
+    this->transpose(buffer.storage(), out);
+    return out;
+  }
+
+  // Host copy of the buffer as floats, whatever its dtype
   [[nodiscard]] virtual std::vector<float> cpu(backend::Buffer const &buffer) const = 0;
 
+  // Host copy of the buffer as doubles, exact for F64 buffers
+  [[nodiscard]] virtual std::vector<double> cpu_f64(backend::Buffer const &buffer) const
+  {
+    auto const host = this->cpu(buffer);
+    return {host.cbegin(), host.cend()};
+  }
+
+  // First element of the buffer, typically a 1x1 result, read without building a host vector
+  [[nodiscard]] virtual float read_scalar(backend::Buffer const &buffer) const = 0;
+
+  // Same as `read_scalar`, exact for F64 buffers
+  [[nodiscard]] virtual double read_scalar_f64(backend::Buffer const &buffer) const
+  {
+    return this->read_scalar(buffer);
+  }
+
+  // Row-major elements of an F32 buffer held in host memory, so that the host can fill it in
+  // place, or nullptr on devices whose buffers live elsewhere
+  [[nodiscard]] virtual float *host_data([[maybe_unused]] backend::Buffer &buffer) const
+  {
+    return nullptr;
+  }
+
   virtual void sync(backend::Buffer const &buffer) const = 0;
 };
 
+inline void
+Device::spmv(backend::SparseBuffer const &a, backend::Buffer const &x, backend::Buffer &y) const
+{
+  backend::assert_compatible_spmv(a, x, y);
+
+  auto const &csr   = *static_cast<backend::CsrData const *>(a.get());
+  auto const host_x = this->cpu(x);
+  std::vector<float> host_y(y.size());
+  backend::csr_spmv_rows(csr, host_x.data(), host_y.data(), 0, a.shape().rows);
+
+  auto const result = this->new_buffer(std::move(host_y), y.shape());
+  this->copy_buffer(result, y);
+}
+
+inline void
+Device::spmm(backend::SparseBuffer const &a, backend::Buffer const &x, backend::Buffer &y) const
+{
+  backend::assert_compatible_spmm(a, x, y);
+
+  auto const &csr   = *static_cast<backend::CsrData const *>(a.get());
+  auto const host_x = this->cpu(x);
+  std::vector<float> host_y(y.size());
+  backend::csr_spmm_rows(csr, host_x.data(), host_y.data(), x.shape().cols, 0, a.shape().rows);
+
+  auto const result = this->new_buffer(std::move(host_y), y.shape());
+  this->copy_buffer(result, y);
+}
+
+inline void Device::batched_mul(
+    backend::Buffer const &a, backend::Buffer const &b, backend::Buffer &c, size_t const batch
+) const
+{
+  backend::assert_compatible_batched_mul(a, b, c, batch);
+
+  auto const host_a = this->cpu(a);
+  auto const host_b = this->cpu(b);
+  auto const m      = a.shape().rows / batch;
+  auto const k      = a.shape().cols;
+  auto const n      = b.shape().cols;
+  std::vector<float> host_c(c.size(), 0.0);
+  for (size_t s{0}; s < batch; s++)
+  {
+    auto const *a_s = host_a.data() + (s * m * k);
+    auto const *b_s = host_b.data() + (s * k * n);
+    auto *c_s       = host_c.data() + (s * m * n);
+    for (size_t i{0}; i < m; i++)
+    {
+      for (size_t p{0}; p < k; p++)
+      {
+        for (size_t j{0}; j < n; j++)
+        {
+          c_s[(i * n) + j] += a_s[(i * k) + p] * b_s[(p * n) + j];
+        }
+      }
+    }
+  }
+
+  auto const result = this->new_buffer(std::move(host_c), c.shape());
+  this->copy_buffer(result, c);
+}
+
+inline void Device::batched_cg(
+    backend::Buffer const &a,
+    backend::Buffer const &b,
+    backend::Buffer &x,
+    size_t const batch,
+    size_t const max_iter,
+    float const tol
+) const
+{
+  backend::assert_compatible_batched_solve(a, b, x, batch);
+
+  auto const host_a = this->cpu(a);
+  auto const host_b = this->cpu(b);
+  auto host_x       = this->cpu(x);
+  backend::batched_cg_systems(
+      host_a.data(), host_b.data(), host_x.data(), a.shape().cols, 0, batch, max_iter, tol
+  );
+
+  auto const result = this->new_buffer(std::move(host_x), x.shape());
+  this->copy_buffer(result, x);
+}
+
+inline void Device::batched_cholesky(
+    backend::Buffer const &a, backend::Buffer const &b, backend::Buffer &x, size_t const batch
+) const
+{
+  backend::assert_compatible_batched_solve(a, b, x, batch);
+
+  auto const host_a = this->cpu(a);
+  auto const host_b = this->cpu(b);
+  std::vector<float> host_x(x.size());
+  backend::batched_cholesky_systems(
+      host_a.data(), host_b.data(), host_x.data(), a.shape().cols, 0, batch
+  );
+
+  auto const result = this->new_buffer(std::move(host_x), x.shape());
+  this->copy_buffer(result, x);
+}
+
+inline void Device::broadcast(
+    backend::ExprOp const op,
+    backend::Buffer const &a,
+    backend::Buffer const &b,
+    backend::Buffer &c
+) const
+{
+  using backend::ExprOp;
+
+  backend::assert_compatible_broadcast(a, b, c);
+
+  auto const host_a       = this->cpu(a);
+  auto const host_b       = this->cpu(b);
+  auto const [rows, cols] = a.storage_shape();
+  auto const per_row      = backend::broadcast_per_row(a, b);
+  std::vector<float> host_c(host_a.size());
+  for (size_t i{0}; i < rows; i++)
+  {
+    for (size_t j{0}; j < cols; j++)
+    {
+      auto const x = host_a[(i * cols) + j];
+      auto const y = host_b[per_row ? i : j];
+      auto &z      = host_c[(i * cols) + j];
+      switch (op)
+      {
+      case ExprOp::ADD:
+        z = x + y;
+        break;
+      case ExprOp::SUB:
+        z = x - y;
+        break;
+      case ExprOp::MUL:
+        z = x * y;
+        break;
+      default:
+        z = x / y;
+        break;
+      }
+    }
+  }
+
+  auto const result = this->new_buffer(std::move(host_c), a.storage_shape());
+  auto storage      = c.storage();
+  this->copy_buffer(result, storage);
+}
+
+inline void Device::eval(backend::Expression const &expr, backend::Buffer &out) const
+{
+  using backend::Buffer;
+  using backend::ExprOp;
+
+  backend::assert_compatible_eval(expr, out);
+
+  struct Value
+  {
+    Buffer const *buffer{nullptr};
+    bool scalar{false};
+    std::unique_ptr<Buffer> owned;
+  };
+
+  auto const &code     = expr.code();
+  auto const &operands = expr.operands();
+  if (code.size() == 1)
+  {
+    this->copy_buffer(*operands.front(), out);
+    return;
+  }
+
+  std::vector<Value> stack;
+  stack.reserve(expr.depth());
+  for (size_t pc{0}; pc < code.size(); pc++)
+  {
+    auto const &instr = code[pc];
+    if (instr.op == ExprOp::LOAD or instr.op == ExprOp::SCALAR)
+    {
+      stack.push_back(Value{operands[instr.operand], instr.op == ExprOp::SCALAR, nullptr});
+      continue;
+    }
+
+    auto const rhs = std::move(stack.back());
+    stack.pop_back();
+    auto const lhs = std::move(stack.back());
+    stack.pop_back();
+
+    Value res;
+    if (pc + 1 != code.size())
+    {
+      res.owned = std::make_unique<Buffer>(this->new_typed_buffer(expr.shape(), expr.dtype()));
+    }
+    auto &dst  = res.owned != nullptr ? *res.owned : out;
+    res.buffer = &dst;
+
+#ifndef NDEBUG
+    assert(not lhs.scalar and "Scalars must be the right operand");
+#endif
+    auto const &a = *lhs.buffer;
+    auto const &b = *rhs.buffer;
+    switch (instr.op)
+    {
+    case ExprOp::ADD:
+      rhs.scalar ? this->sadd(a, b, dst) : this->add(a, b, dst);
+      break;
+    case ExprOp::SUB:
+      rhs.scalar ? this->ssub(a, b, dst) : this->sub(a, b, dst);
+      break;
+    case ExprOp::MUL:
+      rhs.scalar ? this->smul(a, b, dst) : this->cmul(a, b, dst);
+      break;
+    case ExprOp::DIV_OR_ZERO:
+    {
+      // No device op masks the quotient, so it is taken on the host
+      auto const host_a = this->cpu(a);
+      auto const host_b = this->cpu(b);
+      std::vector<float> host_c(host_a.size());
+      for (size_t i{0}; i < host_c.size(); i++)
+      {
+        auto const y = host_b[rhs.scalar ? 0 : i];
+        host_c[i]    = y == 0.0F ? 0.0F : host_a[i] / y;
+      }
+      auto const result = this->new_buffer(std::move(host_c), a.storage_shape());
+      auto storage      = dst.storage();
+      this->copy_buffer(result, storage);
+      break;
+    }
+    default:
+      rhs.scalar ? this->sdiv(a, b, dst) : this->cdiv(a, b, dst);
+      break;
+    }
+
+    stack.push_back(std::move(res));
+  }
+}
+
 using DevicePtr = std::shared_ptr<Device>;
 
 DevicePtr make_serial_device();
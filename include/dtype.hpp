@@ -0,0 +1,175 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace gpu_playground
+{
+
+#define DTYPES                                                                                     \
+  X(F32)                                                                                           \
+  X(F16)                                                                                           \
+  X(BF16)                                                                                          \
+  X(F64)
+
+// Element type of the storage behind a buffer. F16 (IEEE binary16) and BF16 (bfloat16) halve the
+// bytes moved by bandwidth bound kernels, which widen them to float as they read them so that
+// every sum is still accumulated in float. F64 (double) is for solves that need more accuracy
+// than float can give, and is computed in double throughout.
+enum class DType : uint8_t
+{
+#define X(type) type,
+  DTYPES
+#undef X
+      COUNT
+};
+
+inline constexpr std::array<std::string_view, static_cast<size_t>(DType::COUNT)> dtype_names{
+#define X(name) #name,
+    DTYPES
+#undef X
+};
+
+constexpr std::string_view get_dtype_name(DType const dtype)
+{
+  return dtype_names.at(static_cast<size_t>(dtype));
+}
+
+// Bytes taken by one element
+constexpr size_t dtype_size(DType const dtype)
+{
+  switch (dtype)
+  {
+  case DType::F64:
+    return sizeof(double);
+  case DType::F32:
+    return sizeof(float);
+  default:
+    return sizeof(uint16_t);
+  }
+}
+
+// Whether elements are stored on 16 bits and only read through widening kernels
+constexpr bool is_reduced(DType const dtype)
+{
+  return dtype == DType::F16 or dtype == DType::BF16;
+}
+
+} // namespace gpu_playground
+
+namespace gpu_playground::backend
+{
+
+// Tag of the element type of F32 or F64 storage
+template <class T>
+struct Precision
+{
+  using type = T;
+};
+
+// Calls fn with the `Precision` of F32 or F64 storage, so that kernels templated on its element
+// type are instantiated once per precision
+template <class Fn>
+decltype(auto) visit_precision(DType const dtype, Fn const &fn)
+{
+  if (dtype == DType::F64)
+  {
+    return fn(Precision<double>{});
+  }
+  return fn(Precision<float>{});
+}
+
+inline uint32_t float_bits(float const value)
+{
+  uint32_t bits{0};
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline float bits_float(uint32_t const bits)
+{
+  float value{0.0};
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Conversions between float and the 16-bit types, rounding to nearest even. Values out of the
+// binary16 range become infinities and NaNs stay (quiet) NaNs.
+
+inline float half_to_float(uint16_t const value)
+{
+  constexpr uint32_t shifted_exp = uint32_t{0x7c00} << 13;
+  constexpr uint32_t exp_adjust  = uint32_t{127 - 15} << 23;
+
+  uint32_t bits  = (uint32_t{value} & 0x7fffU) << 13;
+  auto const exp = bits & shifted_exp;
+  bits += exp_adjust;
+  if (exp == shifted_exp)
+  {
+    // Infinity or NaN: the exponent is all ones in float too
+    bits += exp_adjust;
+  }
+  else if (exp == 0)
+  {
+    // Zero or subnormal, renormalised by a float subtraction
+    bits = float_bits(bits_float(bits + (1U << 23)) - bits_float(113U << 23));
+  }
+  return bits_float(bits | ((uint32_t{value} & 0x8000U) << 16));
+}
+
+inline uint16_t float_to_half(float const value)
+{
+  constexpr uint32_t f32_inf      = 255U << 23;
+  constexpr uint32_t f16_overflow = (127U + 16) << 23;
+  constexpr uint32_t f16_normal   = 113U << 23;
+  constexpr uint32_t denorm_magic = ((127U - 15) + (23 - 10) + 1) << 23;
+
+  auto bits       = float_bits(value);
+  auto const sign = bits & 0x80000000U;
+  bits ^= sign;
+
+  uint32_t res{0};
+  if (bits >= f16_overflow)
+  {
+    res = bits > f32_inf ? 0x7e00U : 0x7c00U;
+  }
+  else if (bits < f16_normal)
+  {
+    // The float addition rounds the mantissa to its last 10 bits
+    res = float_bits(bits_float(bits) + bits_float(denorm_magic)) - denorm_magic;
+  }
+  else
+  {
+    auto const odd = (bits >> 13) & 1U;
+    res            = (bits - ((127U - 15) << 23) + 0xfffU + odd) >> 13;
+  }
+  return static_cast<uint16_t>(res | (sign >> 16));
+}
+
+inline float bfloat16_to_float(uint16_t const value) { return bits_float(uint32_t{value} << 16); }
+
+inline uint16_t float_to_bfloat16(float const value)
+{
+  auto const bits = float_bits(value);
+  if ((bits & 0x7fffffffU) > 0x7f800000U)
+  {
+    return static_cast<uint16_t>((bits >> 16) | 0x40U);
+  }
+  auto const odd = (bits >> 16) & 1U;
+  return static_cast<uint16_t>((bits + 0x7fffU + odd) >> 16);
+}
+
+// Element of 16-bit `dtype` storage as a float, and back
+inline float reduced_to_float(DType const dtype, uint16_t const value)
+{
+  return dtype == DType::F16 ? half_to_float(value) : bfloat16_to_float(value);
+}
+
+inline uint16_t float_to_reduced(DType const dtype, float const value)
+{
+  return dtype == DType::F16 ? float_to_half(value) : float_to_bfloat16(value);
+}
+
+} // namespace gpu_playground::backend
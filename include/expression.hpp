@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "buffer.hpp"
+
+namespace gpu_playground::backend
+{
+
+enum class ExprOp : std::uint8_t
+{
+  LOAD,   // push an element of a buffer of the expression shape
+  SCALAR, // push the single element of a 1x1 buffer
+  ADD,
+  SUB,
+  MUL,
+  DIV,
+  DIV_OR_ZERO, // a / b, or 0 where b is 0
+};
+
+struct ExprInstr
+{
+  ExprOp op{ExprOp::LOAD};
+  size_t operand{0};
+};
+
+// Element-wise expression over buffers of one shape and 1x1 scalars, stored as a postfix program
+// so that backends can evaluate it in a single pass over memory.
+//
+// The expression only keeps pointers to its operands, which must outlive its evaluation.
+class Expression
+{
+private:
+  std::vector<ExprInstr> m_code;
+  std::vector<Buffer const *> m_operands;
+  Shape m_shape;
+  bool m_transposed{false};
+  size_t m_depth{1};
+
+  Expression(ExprOp const op, Buffer const &buffer, Shape const shape, bool const transposed)
+      : m_code{ExprInstr{op, 0}}, m_operands{&buffer}, m_shape(shape), m_transposed(transposed)
+  {
+  }
+
+public:
+  static Expression load(Buffer const &buffer)
+  {
+    return Expression{ExprOp::LOAD, buffer, buffer.shape(), buffer.is_transposed()};
+  }
+
+  // Broadcasts a 1x1 buffer to the shape and layout of `like`
+  static Expression scalar(Buffer const &buffer, Expression const &like)
+  {
+#ifndef NDEBUG
+    assert(buffer.size() == 1 and "Scalar buffer must have 1 element");
+#endif
+    return Expression{ExprOp::SCALAR, buffer, like.m_shape, like.m_transposed};
+  }
+
+  static Expression binary(ExprOp const op, Expression lhs, Expression const &rhs)
+  {
+#ifndef NDEBUG
+    assert(op != ExprOp::LOAD and op != ExprOp::SCALAR and "Not a binary operation");
+    assert(lhs.m_shape.rows == rhs.m_shape.rows and "Expressions must have the same rows");
+    assert(lhs.m_shape.cols == rhs.m_shape.cols and "Expressions must have the same columns");
+    assert(lhs.m_transposed == rhs.m_transposed and "Expressions must have the same layout");
+    assert(lhs.dtype() == rhs.dtype() and "Expressions must have the same dtype");
+#endif
+    auto const offset = lhs.m_operands.size();
+    for (auto instr : rhs.m_code)
+    {
+      if (instr.op == ExprOp::LOAD or instr.op == ExprOp::SCALAR)
+      {
+        instr.operand += offset;
+      }
+      lhs.m_code.push_back(instr);
+    }
+    lhs.m_code.push_back(ExprInstr{op, 0});
+    lhs.m_operands.insert(lhs.m_operands.end(), rhs.m_operands.cbegin(), rhs.m_operands.cend());
+    lhs.m_depth = std::max(lhs.m_depth, rhs.m_depth + 1);
+
+    return lhs;
+  }
+
+  [[nodiscard]] std::vector<ExprInstr> const &code() const { return this->m_code; }
+
+  [[nodiscard]] std::vector<Buffer const *> const &operands() const { return this->m_operands; }
+
+  [[nodiscard]] Shape shape() const { return this->m_shape; }
+
+  // Whether the operands are transposed views, which are then evaluated in their storage order
+  [[nodiscard]] bool transposed() const { return this->m_transposed; }
+
+  [[nodiscard]] size_t size() const { return this->m_shape.rows * this->m_shape.cols; }
+
+  [[nodiscard]] DType dtype() const { return this->m_operands.front()->dtype(); }
+
+  // Number of values live at once while running the program
+  [[nodiscard]] size_t depth() const { return this->m_depth; }
+};
+
+inline void
+assert_compatible_eval([[maybe_unused]] Expression const &expr, [[maybe_unused]] Buffer const &out)
+{
+#ifndef NDEBUG
+  assert_size_nonzero(out);
+  assert(expr.shape().rows == out.shape().rows and "Output buffer shape error");
+  assert(expr.shape().cols == out.shape().cols and "Output buffer shape error");
+  assert(expr.transposed() == out.is_transposed() and "Output buffer layout error");
+  for (auto const *operand : expr.operands())
+  {
+    assert_valid_buffers(*operand, out);
+  }
+#endif
+}
+
+// Elements evaluated at once by `eval_chunked`, sized so that the intermediate values of an
+// expression stay in L1.
+constexpr size_t EXPR_CHUNK = 512;
+
+// Evaluates elements [begin, end) of `expr` into `out` one chunk at a time. `inputs[i]` points to
+// the data of operand i, and `kernel(op, a, b, c, n)` computes c[j] = a[j] op b[j] for j < n.
+// Loads are read in place, scalars are broadcast into a chunk and the last operation writes
+// straight into `out`, so intermediate values never leave the chunk buffers.
+template <class T, class Kernel>
+void eval_chunked(
+    Expression const &expr,
+    std::vector<T const *> const &inputs,
+    T *out,
+    size_t const begin,
+    size_t const end,
+    Kernel const &kernel
+)
+{
+  auto const &code = expr.code();
+  std::vector<T> scratch(expr.depth() * EXPR_CHUNK);
+  std::vector<T const *> stack(expr.depth());
+
+  for (size_t first{begin}; first < end; first += EXPR_CHUNK)
+  {
+    auto const n = std::min(EXPR_CHUNK, end - first);
+    size_t top{0};
+
+    for (size_t pc{0}; pc < code.size(); pc++)
+    {
+      auto const &instr = code[pc];
+      switch (instr.op)
+      {
+      case ExprOp::LOAD:
+        stack[top++] = inputs[instr.operand] + first;
+        break;
+      case ExprOp::SCALAR:
+      {
+        T *slot = scratch.data() + (top * EXPR_CHUNK);
+        std::fill(slot, slot + n, *inputs[instr.operand]);
+        stack[top++] = slot;
+        break;
+      }
+      default:
+      {
+        top--;
+        T *dst = pc + 1 == code.size() ? out + first : scratch.data() + ((top - 1) * EXPR_CHUNK);
+        kernel(instr.op, stack[top - 1], stack[top], dst, n);
+        stack[top - 1] = dst;
+        break;
+      }
+      }
+    }
+
+    if (stack.front() != out + first)
+    {
+      std::copy(stack.front(), stack.front() + n, out + first);
+    }
+  }
+}
+
+} // namespace gpu_playground::backend
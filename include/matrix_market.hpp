@@ -0,0 +1,591 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "csr_matrix.hpp"
+#include "sell_matrix.hpp"
+#include "tensor.hpp"
+#include "thread_pool.hpp"
+
+namespace gpu_playground
+{
+
+struct MatrixMarketStats
+{
+  size_t bytes{0};
+  size_t entries{0};
+  double seconds{0.0};
+
+  // Parse throughput over the whole file
+  [[nodiscard]] double mb_per_s() const
+  {
+    return this->seconds > 0.0 ? static_cast<double>(this->bytes) / 1e6 / this->seconds : 0.0;
+  }
+};
+
+// Coordinate matrix read from a Matrix Market file. The entries of symmetric and skew-symmetric
+// matrices are mirrored, so the triplets always describe the whole matrix.
+struct MatrixMarket
+{
+  Shape shape{0, 0};
+  std::vector<backend::Triplet> triplets;
+  MatrixMarketStats stats;
+};
+
+namespace detail
+{
+
+// Read-only memory map of a whole file, with mmap or with a Win32 file mapping
+class MappedFile
+{
+private:
+  void *m_data{nullptr};
+  size_t m_size{0};
+
+public:
+  explicit MappedFile(std::string const &path)
+  {
+#if defined(_WIN32)
+    HANDLE const file = ::CreateFileA(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE)
+    {
+      return;
+    }
+
+    LARGE_INTEGER size{};
+    if (::GetFileSizeEx(file, &size) != 0 and size.QuadPart > 0)
+    {
+      // The view keeps the mapping alive once its handle is closed
+      HANDLE const mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (mapping != nullptr)
+      {
+        this->m_data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        ::CloseHandle(mapping);
+      }
+      this->m_size = this->valid() ? static_cast<size_t>(size.QuadPart) : 0;
+    }
+    ::CloseHandle(file);
+#else
+    int const fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      return;
+    }
+
+    struct stat info{};
+    if (::fstat(fd, &info) == 0 and info.st_size > 0)
+    {
+      auto const size = static_cast<size_t>(info.st_size);
+      void *data      = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED)
+      {
+        ::madvise(data, size, MADV_WILLNEED);
+        this->m_data = data;
+        this->m_size = size;
+      }
+    }
+    ::close(fd);
+#endif
+  }
+
+  MappedFile(MappedFile const &)            = delete;
+  MappedFile &operator=(MappedFile const &) = delete;
+  MappedFile(MappedFile &&)                 = delete;
+  MappedFile &operator=(MappedFile &&)      = delete;
+
+  ~MappedFile()
+  {
+    if (not this->valid())
+    {
+      return;
+    }
+#if defined(_WIN32)
+    ::UnmapViewOfFile(this->m_data);
+#else
+    ::munmap(this->m_data, this->m_size);
+#endif
+  }
+
+  [[nodiscard]] bool valid() const { return this->m_data != nullptr; }
+
+  [[nodiscard]] char const *begin() const { return static_cast<char const *>(this->m_data); }
+
+  [[nodiscard]] char const *end() const { return this->begin() + this->m_size; }
+
+  [[nodiscard]] size_t size() const { return this->m_size; }
+};
+
+enum class MtxField : std::uint8_t
+{
+  REAL,
+  INTEGER,
+  PATTERN,
+};
+
+enum class MtxSymmetry : std::uint8_t
+{
+  GENERAL,
+  SYMMETRIC,
+  SKEW_SYMMETRIC,
+};
+
+struct MtxHeader
+{
+  MtxField field{MtxField::REAL};
+  MtxSymmetry symmetry{MtxSymmetry::GENERAL};
+  size_t rows{0};
+  size_t cols{0};
+  size_t entries{0};
+  char const *body{nullptr};
+};
+
+// Smallest chunk of the file handed to a task
+constexpr size_t MTX_MIN_CHUNK = size_t{1} << 14;
+
+inline bool is_blank(char const c) { return c == ' ' or c == '\t' or c == '\r'; }
+
+inline bool is_digit(char const c) { return c >= '0' and c <= '9'; }
+
+inline char const *skip_blanks(char const *p, char const *end)
+{
+  while (p < end and is_blank(*p))
+  {
+    p++;
+  }
+  return p;
+}
+
+// Start of the line following p, or end
+inline char const *next_line(char const *p, char const *end)
+{
+  auto const *newline = static_cast<char const *>(std::memchr(p, '\n', end - p));
+  return newline == nullptr ? end : newline + 1;
+}
+
+inline bool parse_index(char const *&p, char const *end, size_t &out)
+{
+  p = skip_blanks(p, end);
+  if (p == end or not is_digit(*p))
+  {
+    return false;
+  }
+
+  out = 0;
+  for (; p < end and is_digit(*p); p++)
+  {
+    out = (out * 10) + static_cast<size_t>(*p - '0');
+  }
+  return true;
+}
+
+// Decimal number with optional fraction and exponent. The first 19 significant digits are
+// accumulated exactly and scaled once in double precision, close enough to correct rounding once
+// narrowed to float.
+inline bool parse_real(char const *&p, char const *end, float &out)
+{
+  constexpr size_t max_digits = 19;
+  static constexpr std::array<double, 23> powers{
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+  };
+
+  p = skip_blanks(p, end);
+  bool const negative = p < end and *p == '-';
+  if (p < end and (*p == '-' or *p == '+'))
+  {
+    p++;
+  }
+
+  std::uint64_t mantissa{0};
+  size_t digits{0};
+  long exponent{0};
+  bool any{false};
+  auto const digit = [&](bool const fraction)
+  {
+    any = true;
+    if (digits < max_digits)
+    {
+      mantissa = (mantissa * 10) + static_cast<std::uint64_t>(*p - '0');
+      digits += mantissa != 0 ? 1 : 0;
+      exponent -= fraction ? 1 : 0;
+    }
+    else
+    {
+      exponent += fraction ? 0 : 1;
+    }
+  };
+
+  for (; p < end and is_digit(*p); p++)
+  {
+    digit(false);
+  }
+  if (p < end and *p == '.')
+  {
+    for (p++; p < end and is_digit(*p); p++)
+    {
+      digit(true);
+    }
+  }
+  if (not any)
+  {
+    return false;
+  }
+
+  if (p < end and (*p == 'e' or *p == 'E'))
+  {
+    p++;
+    bool const negative_exp = p < end and *p == '-';
+    if (p < end and (*p == '-' or *p == '+'))
+    {
+      p++;
+    }
+    size_t value{0};
+    if (not parse_index(p, end, value))
+    {
+      return false;
+    }
+    auto const capped = static_cast<long>(std::min<size_t>(value, 1000));
+    exponent += negative_exp ? -capped : capped;
+  }
+
+  auto result = static_cast<double>(mantissa);
+  if (result != 0.0)
+  {
+    auto const magnitude = static_cast<size_t>(exponent < 0 ? -exponent : exponent);
+    auto const scale     = magnitude < powers.size()
+                               ? powers[magnitude]
+                               : std::pow(10.0, static_cast<double>(magnitude));
+    result               = exponent < 0 ? result / scale : result * scale;
+  }
+  out = static_cast<float>(negative ? -result : result);
+  return true;
+}
+
+inline std::optional<MtxHeader> parse_header(char const *begin, char const *end)
+{
+  auto const *line_end = next_line(begin, end);
+  std::string banner(begin, line_end);
+  std::transform(
+      banner.begin(),
+      banner.end(),
+      banner.begin(),
+      [](unsigned char const c) { return static_cast<char>(std::tolower(c)); }
+  );
+
+  std::istringstream tokens(banner);
+  std::string magic;
+  std::string object;
+  std::string format;
+  std::string field;
+  std::string symmetry;
+  tokens >> magic >> object >> format >> field >> symmetry;
+  if (magic != "%%matrixmarket" or object != "matrix" or format != "coordinate")
+  {
+    return std::nullopt;
+  }
+
+  MtxHeader header;
+  if (field == "real" or field == "double")
+  {
+    header.field = MtxField::REAL;
+  }
+  else if (field == "integer")
+  {
+    header.field = MtxField::INTEGER;
+  }
+  else if (field == "pattern")
+  {
+    header.field = MtxField::PATTERN;
+  }
+  else
+  {
+    return std::nullopt;
+  }
+
+  // Hermitian matrices are symmetric once restricted to real values
+  if (symmetry == "general")
+  {
+    header.symmetry = MtxSymmetry::GENERAL;
+  }
+  else if (symmetry == "symmetric" or symmetry == "hermitian")
+  {
+    header.symmetry = MtxSymmetry::SYMMETRIC;
+  }
+  else if (symmetry == "skew-symmetric")
+  {
+    header.symmetry = MtxSymmetry::SKEW_SYMMETRIC;
+  }
+  else
+  {
+    return std::nullopt;
+  }
+
+  // Comments and blank lines up to the size line
+  auto const *p = line_end;
+  while (p < end)
+  {
+    auto const *first = skip_blanks(p, end);
+    if (first < end and *first != '%' and *first != '\n')
+    {
+      break;
+    }
+    p = next_line(p, end);
+  }
+
+  if (not parse_index(p, end, header.rows) or not parse_index(p, end, header.cols) or
+      not parse_index(p, end, header.entries))
+  {
+    return std::nullopt;
+  }
+  constexpr auto max_index = static_cast<size_t>(std::numeric_limits<backend::CsrIndex>::max());
+  if (header.rows > max_index or header.cols > max_index)
+  {
+    return std::nullopt;
+  }
+
+  header.body = next_line(p, end);
+  return header;
+}
+
+// Whether the line starting at p holds an entry, i.e. is neither blank nor a comment
+inline bool is_entry(char const *p, char const *end)
+{
+  p = skip_blanks(p, end);
+  return p < end and *p != '\n' and *p != '%';
+}
+
+} // namespace detail
+
+// Reads a coordinate Matrix Market file (real, integer or pattern; general, symmetric,
+// skew-symmetric or hermitian). The file is memory-mapped and split in chunks of whole lines
+// parsed in parallel: a first pass counts the entries of every chunk, and the slots they fill once
+// off-diagonal entries of symmetric files are mirrored, so that the second one parses and mirrors
+// them straight into place. Returns nothing if the file cannot be read or is malformed.
+inline std::optional<MatrixMarket> read_matrix_market(std::string const &path)
+{
+  using detail::MtxSymmetry;
+
+  auto const start = std::chrono::steady_clock::now();
+
+  detail::MappedFile const file(path);
+  if (not file.valid())
+  {
+    return std::nullopt;
+  }
+
+  auto const header = detail::parse_header(file.begin(), file.end());
+  if (not header)
+  {
+    return std::nullopt;
+  }
+
+  auto const *body  = header->body;
+  auto const *end   = file.end();
+  auto const bytes  = static_cast<size_t>(end - body);
+  auto const chunks = std::clamp<size_t>(bytes / detail::MTX_MIN_CHUNK, 1, num_threads() * 4);
+
+  // Chunks start on the first line beginning at or after their share of the body
+  auto const chunk_begin = [&](size_t const c) -> char const *
+  {
+    if (c == 0)
+    {
+      return body;
+    }
+    if (c == chunks)
+    {
+      return end;
+    }
+    auto const *raw = body + ((c * bytes) / chunks);
+    return raw[-1] == '\n' ? raw : detail::next_line(raw, end);
+  };
+
+  bool const mirrored = header->symmetry != MtxSymmetry::GENERAL;
+
+  // Entries of every chunk, and the triplet slots they fill
+  std::vector<size_t> entries(chunks, 0);
+  std::vector<size_t> offsets(chunks + 1, 0);
+  thread_pool().parallel_for(
+      0,
+      chunks,
+      1,
+      [&](size_t const first, size_t const last)
+      {
+        for (size_t c{first}; c < last; c++)
+        {
+          auto const *chunk_end = chunk_begin(c + 1);
+          size_t count{0};
+          size_t slots{0};
+          for (auto const *p = chunk_begin(c); p < chunk_end; p = detail::next_line(p, chunk_end))
+          {
+            if (not detail::is_entry(p, chunk_end))
+            {
+              continue;
+            }
+
+            // Malformed lines take a single slot and are reported by the parse
+            size_t row{0};
+            size_t col{0};
+            auto const *q = p;
+            bool const off_diagonal = mirrored and detail::parse_index(q, chunk_end, row) and
+                                      detail::parse_index(q, chunk_end, col) and row != col;
+            count++;
+            slots += off_diagonal ? 2 : 1;
+          }
+          entries[c]     = count;
+          offsets[c + 1] = slots;
+        }
+      }
+  );
+  size_t total_entries{0};
+  for (size_t c{0}; c < chunks; c++)
+  {
+    total_entries += entries[c];
+    offsets[c + 1] += offsets[c];
+  }
+  if (total_entries != header->entries)
+  {
+    return std::nullopt;
+  }
+
+  auto const sign = header->symmetry == MtxSymmetry::SKEW_SYMMETRIC ? -1.0F : 1.0F;
+
+  MatrixMarket res;
+  res.shape = Shape{header->rows, header->cols};
+  res.triplets.resize(offsets.back());
+
+  std::atomic<bool> failed{false};
+  thread_pool().parallel_for(
+      0,
+      chunks,
+      1,
+      [&](size_t const first, size_t const last)
+      {
+        for (size_t c{first}; c < last; c++)
+        {
+          auto const *chunk_end = chunk_begin(c + 1);
+          auto *out             = res.triplets.data() + offsets[c];
+          for (auto const *p = chunk_begin(c); p < chunk_end; p = detail::next_line(p, chunk_end))
+          {
+            if (not detail::is_entry(p, chunk_end))
+            {
+              continue;
+            }
+
+            size_t row{0};
+            size_t col{0};
+            float value{1.0};
+            bool const valid =
+                detail::parse_index(p, chunk_end, row) and
+                detail::parse_index(p, chunk_end, col) and
+                (header->field == detail::MtxField::PATTERN or
+                 detail::parse_real(p, chunk_end, value)) and
+                row >= 1 and row <= header->rows and col >= 1 and col <= header->cols;
+            if (not valid)
+            {
+              failed.store(true, std::memory_order_relaxed);
+              return;
+            }
+
+            auto const i = static_cast<backend::CsrIndex>(row - 1);
+            auto const j = static_cast<backend::CsrIndex>(col - 1);
+            *out++       = backend::Triplet{i, j, value};
+            if (mirrored and i != j)
+            {
+              *out++ = backend::Triplet{j, i, sign * value};
+            }
+          }
+        }
+      }
+  );
+  if (failed.load())
+  {
+    return std::nullopt;
+  }
+
+  std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+  res.stats = MatrixMarketStats{file.size(), res.triplets.size(), elapsed.count()};
+  return res;
+}
+
+inline std::optional<CsrMatrix> load_matrix_market_csr(std::string const &path, DevicePtr device)
+{
+  auto const mm = read_matrix_market(path);
+  if (not mm)
+  {
+    return std::nullopt;
+  }
+  return CsrMatrix::from_triplets(mm->shape, mm->triplets, std::move(device));
+}
+
+inline std::optional<SellMatrix> load_matrix_market_sell(
+    std::string const &path, DevicePtr device, size_t const sigma = SellMatrix::default_sigma
+)
+{
+  auto const mm = read_matrix_market(path);
+  if (not mm)
+  {
+    return std::nullopt;
+  }
+  return SellMatrix::from_triplets(mm->shape, mm->triplets, std::move(device), sigma);
+}
+
+// Dense tensor of the matrix, scattered straight into the device buffer on the CPU backends
+inline std::optional<Tensor> load_matrix_market_dense(std::string const &path, DevicePtr device)
+{
+  auto const mm = read_matrix_market(path);
+  if (not mm)
+  {
+    return std::nullopt;
+  }
+
+  auto const cols = mm->shape.cols;
+  return Tensor::filled(
+      mm->shape,
+      std::move(device),
+      [&](float *data)
+      {
+        for (auto const &triplet : mm->triplets)
+        {
+          data[(static_cast<size_t>(triplet.row) * cols) + static_cast<size_t>(triplet.col)] +=
+              triplet.value;
+        }
+      }
+  );
+}
+
+} // namespace gpu_playground
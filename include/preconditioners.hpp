@@ -0,0 +1,303 @@
+#pragma once
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+#include "sparse_buffer.hpp"
+#include "tensor.hpp"
+#include "thread_pool.hpp"
+
+namespace gpu_playground
+{
+
+namespace detail
+{
+
+using backend::CsrData;
+using backend::CsrIndex;
+
+// Triangular matrix T = off_diagonal + diag(1 / inv_diag), with its rows grouped in levels:
+// a row only depends on rows of earlier levels, so the rows of one level are solved in parallel.
+struct TriangularFactor
+{
+  CsrData off_diagonal;
+  std::vector<float> inv_diag;
+  std::vector<CsrIndex> level_ptr;
+  std::vector<CsrIndex> level_rows;
+};
+
+inline TriangularFactor
+make_triangular(CsrData off_diagonal, std::vector<float> inv_diag, bool const lower)
+{
+  auto const n = inv_diag.size();
+
+  // Level of a row is one more than the deepest level it depends on
+  std::vector<CsrIndex> level(n, 0);
+  CsrIndex levels{n > 0 ? 1 : 0};
+  for (size_t step{0}; step < n; step++)
+  {
+    auto const i = lower ? step : n - 1 - step;
+    for (auto k = off_diagonal.row_ptr[i]; k < off_diagonal.row_ptr[i + 1]; k++)
+    {
+      level[i] = std::max(level[i], level[off_diagonal.col_idx[k]] + 1);
+    }
+    levels = std::max(levels, level[i] + 1);
+  }
+
+  TriangularFactor res{std::move(off_diagonal), std::move(inv_diag), {}, {}};
+  res.level_ptr.assign(static_cast<size_t>(levels) + 1, 0);
+  res.level_rows.resize(n);
+  for (auto const l : level)
+  {
+    res.level_ptr[static_cast<size_t>(l) + 1]++;
+  }
+  for (size_t l{0}; l < static_cast<size_t>(levels); l++)
+  {
+    res.level_ptr[l + 1] += res.level_ptr[l];
+  }
+  auto next = res.level_ptr;
+  for (size_t i{0}; i < n; i++)
+  {
+    res.level_rows[next[level[i]]++] = static_cast<CsrIndex>(i);
+  }
+
+  return res;
+}
+
+// Solves T x = b in place, with x holding b on entry
+inline void triangular_solve(TriangularFactor const &t, float *x)
+{
+  auto const &off = t.off_diagonal;
+  for (size_t l{0}; l + 1 < t.level_ptr.size(); l++)
+  {
+    parallel_for(
+        static_cast<size_t>(t.level_ptr[l]),
+        static_cast<size_t>(t.level_ptr[l + 1]),
+        [&](size_t const begin, size_t const end)
+        {
+          for (size_t r{begin}; r < end; r++)
+          {
+            auto const i = static_cast<size_t>(t.level_rows[r]);
+            auto sum     = x[i];
+            for (auto k = off.row_ptr[i]; k < off.row_ptr[i + 1]; k++)
+            {
+              sum -= off.values[k] * x[off.col_idx[k]];
+            }
+            x[i] = sum * t.inv_diag[i];
+          }
+        }
+    );
+  }
+}
+
+// Strictly lower and strictly upper parts of `a`, and its diagonal
+struct Splitting
+{
+  CsrData lower;
+  CsrData upper;
+  std::vector<float> diag;
+};
+
+inline Splitting split(CsrData const &a)
+{
+  auto const n = a.row_ptr.size() - 1;
+
+  Splitting res;
+  res.lower.row_ptr.push_back(0);
+  res.upper.row_ptr.push_back(0);
+  res.diag.assign(n, 0.0);
+  for (size_t i{0}; i < n; i++)
+  {
+    for (auto k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++)
+    {
+      auto const col = static_cast<size_t>(a.col_idx[k]);
+      if (col == i)
+      {
+        res.diag[i] = a.values[k];
+        continue;
+      }
+      auto &part = col < i ? res.lower : res.upper;
+      part.col_idx.push_back(a.col_idx[k]);
+      part.values.push_back(a.values[k]);
+    }
+    res.lower.row_ptr.push_back(static_cast<CsrIndex>(res.lower.values.size()));
+    res.upper.row_ptr.push_back(static_cast<CsrIndex>(res.upper.values.size()));
+  }
+
+  return res;
+}
+
+inline void assert_nonzero_diagonal([[maybe_unused]] std::vector<float> const &diag)
+{
+#ifndef NDEBUG
+  for (auto const d : diag)
+  {
+    assert(d != 0.0F and "Preconditioner needs a non-zero diagonal");
+  }
+#endif
+}
+
+} // namespace detail
+
+// A preconditioner M is any object whose `apply(r)` returns M^-1 r, for
+// `preconditioned_conjugate_gradient`.
+
+// Diagonal (Jacobi) preconditioner, applied as one element-wise product on the device.
+class JacobiPreconditioner
+{
+private:
+  Tensor inv_diag;
+
+  static Tensor inverse_diagonal(backend::CsrData const &a, DevicePtr device)
+  {
+    auto diag = detail::split(a).diag;
+    detail::assert_nonzero_diagonal(diag);
+    for (auto &d : diag)
+    {
+      d = 1.0F / d;
+    }
+    auto const n = diag.size();
+    return {std::move(diag), Shape{n, 1}, std::move(device)};
+  }
+
+public:
+  JacobiPreconditioner(backend::CsrData const &a, DevicePtr device)
+      : inv_diag(JacobiPreconditioner::inverse_diagonal(a, std::move(device)))
+  {
+  }
+
+  static JacobiPreconditioner from_dense(Tensor const &a)
+  {
+    return {backend::csr_from_dense(a.shape(), a.cpu()), a.get_device()};
+  }
+
+  [[nodiscard]] Tensor apply(Tensor const &r) const { return r.cmul(this->inv_diag); }
+};
+
+// Symmetric successive over-relaxation, M = w / (2 - w) (D / w + L) (D / w)^-1 (D / w + U) for
+// A = L + D + U. The triangular solves run on the host, level by level.
+class SsorPreconditioner
+{
+private:
+  detail::TriangularFactor lower;
+  detail::TriangularFactor upper;
+  std::vector<float> scale;
+
+public:
+  SsorPreconditioner(backend::CsrData const &a, float const omega = 1.0)
+  {
+#ifndef NDEBUG
+    assert(omega > 0.0F and omega < 2.0F and "SSOR relaxation factor must be in (0, 2)");
+#endif
+
+    auto parts = detail::split(a);
+    detail::assert_nonzero_diagonal(parts.diag);
+    std::vector<float> inv_diag(parts.diag.size());
+    this->scale.resize(parts.diag.size());
+    for (size_t i{0}; i < parts.diag.size(); i++)
+    {
+      inv_diag[i]    = omega / parts.diag[i];
+      this->scale[i] = (2.0F - omega) * parts.diag[i] / (omega * omega);
+    }
+    this->lower = detail::make_triangular(std::move(parts.lower), inv_diag, true);
+    this->upper = detail::make_triangular(std::move(parts.upper), std::move(inv_diag), false);
+  }
+
+  static SsorPreconditioner from_dense(Tensor const &a, float const omega = 1.0)
+  {
+    return {backend::csr_from_dense(a.shape(), a.cpu()), omega};
+  }
+
+  [[nodiscard]] Tensor apply(Tensor const &r) const
+  {
+    auto z = r.cpu();
+    detail::triangular_solve(this->lower, z.data());
+    for (size_t i{0}; i < z.size(); i++)
+    {
+      z[i] *= this->scale[i];
+    }
+    detail::triangular_solve(this->upper, z.data());
+    return {std::move(z), r.shape(), r.get_device()};
+  }
+};
+
+// Incomplete LU factorisation with the sparsity pattern of A, M = L U with L unit lower
+// triangular. Every row of A must store its diagonal.
+class Ilu0Preconditioner
+{
+private:
+  detail::TriangularFactor lower;
+  detail::TriangularFactor upper;
+
+public:
+  explicit Ilu0Preconditioner(backend::CsrData a)
+  {
+    auto const n = a.row_ptr.size() - 1;
+
+    // Position of the diagonal in every row, and of every column of the current row
+    std::vector<backend::CsrIndex> diag_pos(n, -1);
+    std::vector<backend::CsrIndex> col_pos(n, -1);
+    for (size_t i{0}; i < n; i++)
+    {
+      for (auto k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++)
+      {
+        col_pos[a.col_idx[k]] = k;
+      }
+
+      for (auto k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++)
+      {
+        auto const p = static_cast<size_t>(a.col_idx[k]);
+        if (p >= i)
+        {
+          break;
+        }
+        a.values[k] /= a.values[diag_pos[p]];
+        for (auto kp = diag_pos[p] + 1; kp < a.row_ptr[p + 1]; kp++)
+        {
+          auto const pos = col_pos[a.col_idx[kp]];
+          if (pos >= 0)
+          {
+            a.values[pos] -= a.values[k] * a.values[kp];
+          }
+        }
+      }
+
+      for (auto k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++)
+      {
+        if (static_cast<size_t>(a.col_idx[k]) == i)
+        {
+          diag_pos[i] = k;
+        }
+        col_pos[a.col_idx[k]] = -1;
+      }
+#ifndef NDEBUG
+      assert(diag_pos[i] >= 0 and "ILU(0) needs every diagonal entry to be stored");
+      assert(a.values[diag_pos[i]] != 0.0F and "ILU(0) broke down on a zero pivot");
+#endif
+    }
+
+    auto parts = detail::split(a);
+    for (auto &d : parts.diag)
+    {
+      d = 1.0F / d;
+    }
+    this->lower = detail::make_triangular(std::move(parts.lower), std::vector<float>(n, 1.0), true);
+    this->upper = detail::make_triangular(std::move(parts.upper), std::move(parts.diag), false);
+  }
+
+  static Ilu0Preconditioner from_dense(Tensor const &a)
+  {
+    return Ilu0Preconditioner{backend::csr_from_dense(a.shape(), a.cpu())};
+  }
+
+  [[nodiscard]] Tensor apply(Tensor const &r) const
+  {
+    auto z = r.cpu();
+    detail::triangular_solve(this->lower, z.data());
+    detail::triangular_solve(this->upper, z.data());
+    return {std::move(z), r.shape(), r.get_device()};
+  }
+};
+
+} // namespace gpu_playground
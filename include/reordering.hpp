@@ -0,0 +1,398 @@
+#pragma once
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "csr_matrix.hpp"
+#include "sparse_buffer.hpp"
+#include "tensor.hpp"
+
+namespace gpu_playground
+{
+
+namespace detail
+{
+
+using backend::CsrData;
+using backend::CsrIndex;
+
+inline size_t degree(CsrData const &graph, CsrIndex const v)
+{
+  return static_cast<size_t>(graph.row_ptr[v + 1] - graph.row_ptr[v]);
+}
+
+// Adjacency of the pattern of A + A^T without its diagonal, so that unsymmetric patterns are
+// reordered as well
+inline CsrData symmetric_graph(CsrData const &a)
+{
+  auto const n = a.row_ptr.size() - 1;
+  std::vector<backend::Triplet> edges;
+  edges.reserve(2 * a.col_idx.size());
+  for (size_t i{0}; i < n; i++)
+  {
+    auto const row = static_cast<CsrIndex>(i);
+    for (auto k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++)
+    {
+      auto const col = a.col_idx[k];
+      if (col != row)
+      {
+        edges.push_back({row, col, 1.0});
+        edges.push_back({col, row, 1.0});
+      }
+    }
+  }
+  return backend::csr_from_triplets(Shape{n, n}, edges);
+}
+
+// Breadth-first search from `root` over the unvisited vertices v with mask[v] == label, visiting
+// the neighbours of a vertex by increasing degree. Appends the visited vertices to `order`, sets
+// their level (unvisited vertices have level -1) and returns the number of levels.
+inline size_t bfs(
+    CsrData const &graph,
+    CsrIndex const root,
+    std::vector<CsrIndex> const &mask,
+    CsrIndex const label,
+    std::vector<CsrIndex> &level,
+    std::vector<CsrIndex> &order
+)
+{
+  CsrIndex top{0};
+  auto head   = order.size();
+  level[root] = 0;
+  order.push_back(root);
+  while (head < order.size())
+  {
+    auto const v     = order[head++];
+    auto const first = order.size();
+    for (auto k = graph.row_ptr[v]; k < graph.row_ptr[v + 1]; k++)
+    {
+      auto const u = graph.col_idx[k];
+      if (mask[u] == label and level[u] < 0)
+      {
+        level[u] = level[v] + 1;
+        top      = std::max(top, level[u]);
+        order.push_back(u);
+      }
+    }
+    std::sort(
+        order.begin() + static_cast<std::ptrdiff_t>(first),
+        order.end(),
+        [&](CsrIndex const lhs, CsrIndex const rhs)
+        { return degree(graph, lhs) < degree(graph, rhs); }
+    );
+  }
+  return static_cast<size_t>(top) + 1;
+}
+
+// Endpoint of a long shortest path through the component of `start`, found by repeatedly
+// restarting the search from a vertex of minimum degree in the deepest level (George and Liu)
+inline CsrIndex pseudo_peripheral(
+    CsrData const &graph,
+    CsrIndex const start,
+    std::vector<CsrIndex> const &mask,
+    CsrIndex const label,
+    std::vector<CsrIndex> &level
+)
+{
+  std::vector<CsrIndex> order;
+  size_t ecc{0};
+  auto root = start;
+  while (true)
+  {
+    order.clear();
+    auto const levels = bfs(graph, root, mask, label, level, order);
+
+    auto candidate = order.back();
+    for (auto const v : order)
+    {
+      auto const deepest = static_cast<size_t>(level[v]) + 1 == levels;
+      if (deepest and degree(graph, v) < degree(graph, candidate))
+      {
+        candidate = v;
+      }
+    }
+    for (auto const v : order)
+    {
+      level[v] = -1;
+    }
+
+    if (levels <= ecc)
+    {
+      return root;
+    }
+    ecc  = levels;
+    root = candidate;
+  }
+}
+
+inline std::vector<CsrIndex> reverse_cuthill_mckee(CsrData const &a)
+{
+  auto const graph = symmetric_graph(a);
+  auto const n     = graph.row_ptr.size() - 1;
+
+  std::vector<CsrIndex> const mask(n, 0);
+  std::vector<CsrIndex> level(n, -1);
+  std::vector<CsrIndex> by_degree(n);
+  std::vector<CsrIndex> order;
+  order.reserve(n);
+
+  // Every component starts from a pseudo-peripheral vertex, looked for from its vertex of lowest
+  // degree
+  std::iota(by_degree.begin(), by_degree.end(), 0);
+  std::stable_sort(
+      by_degree.begin(),
+      by_degree.end(),
+      [&](CsrIndex const lhs, CsrIndex const rhs)
+      { return degree(graph, lhs) < degree(graph, rhs); }
+  );
+  for (auto const v : by_degree)
+  {
+    if (level[v] < 0)
+    {
+      bfs(graph, pseudo_peripheral(graph, v, mask, 0, level), mask, 0, level, order);
+    }
+  }
+
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+// Orders every connected component of `vertices` as the orderings of the two parts left by a
+// level-set separator, followed by the separator, down to parts of at most `leaf_size` vertices
+// which keep their search order. Vertices with mask[v] == 0 are already ordered.
+inline void dissect(
+    CsrData const &graph,
+    std::vector<CsrIndex> vertices,
+    size_t const leaf_size,
+    std::vector<CsrIndex> &mask,
+    std::vector<CsrIndex> &level,
+    CsrIndex &next_label,
+    std::vector<CsrIndex> &out
+)
+{
+  auto const label = next_label++;
+  for (auto const v : vertices)
+  {
+    mask[v] = label;
+  }
+  std::stable_sort(
+      vertices.begin(),
+      vertices.end(),
+      [&](CsrIndex const lhs, CsrIndex const rhs)
+      { return degree(graph, lhs) < degree(graph, rhs); }
+  );
+
+  std::vector<CsrIndex> order;
+  for (auto const start : vertices)
+  {
+    if (mask[start] != label)
+    {
+      continue;
+    }
+
+    order.clear();
+    auto const levels =
+        bfs(graph, pseudo_peripheral(graph, start, mask, label, level), mask, label, level, order);
+
+    if (order.size() <= leaf_size or levels < 3)
+    {
+      for (auto const v : order)
+      {
+        level[v] = -1;
+        mask[v]  = 0;
+      }
+      out.insert(out.end(), order.cbegin(), order.cend());
+      continue;
+    }
+
+    // Separator at the level splitting the component in halves, never the first or last one
+    std::vector<size_t> counts(levels, 0);
+    for (auto const v : order)
+    {
+      counts[level[v]]++;
+    }
+    size_t mid{0};
+    for (size_t seen{0}; mid + 1 < levels and seen + counts[mid] < order.size() / 2; mid++)
+    {
+      seen += counts[mid];
+    }
+    mid = std::clamp<size_t>(mid, 1, levels - 2);
+
+    std::vector<CsrIndex> lower;
+    std::vector<CsrIndex> separator;
+    std::vector<CsrIndex> upper;
+    for (auto const v : order)
+    {
+      auto const l = static_cast<size_t>(level[v]);
+      if (l < mid)
+      {
+        lower.push_back(v);
+      }
+      else if (l == mid)
+      {
+        separator.push_back(v);
+      }
+      else
+      {
+        upper.push_back(v);
+      }
+      level[v] = -1;
+      mask[v]  = 0;
+    }
+
+    dissect(graph, std::move(lower), leaf_size, mask, level, next_label, out);
+    dissect(graph, std::move(upper), leaf_size, mask, level, next_label, out);
+    out.insert(out.end(), separator.cbegin(), separator.cend());
+  }
+}
+
+inline std::vector<CsrIndex> nested_dissection(CsrData const &a, size_t const leaf_size)
+{
+  auto const graph = symmetric_graph(a);
+  auto const n     = graph.row_ptr.size() - 1;
+
+  std::vector<CsrIndex> mask(n, 0);
+  std::vector<CsrIndex> level(n, -1);
+  std::vector<CsrIndex> vertices(n);
+  std::vector<CsrIndex> order;
+  order.reserve(n);
+  CsrIndex next_label{1};
+
+  std::iota(vertices.begin(), vertices.end(), 0);
+  dissect(graph, std::move(vertices), leaf_size, mask, level, next_label, order);
+  return order;
+}
+
+} // namespace detail
+
+// Largest distance of a non-zero from the diagonal
+inline size_t bandwidth(backend::CsrData const &a)
+{
+  size_t res{0};
+  for (size_t i{0}; i + 1 < a.row_ptr.size(); i++)
+  {
+    for (auto k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++)
+    {
+      auto const col = static_cast<size_t>(a.col_idx[k]);
+      res            = std::max(res, col > i ? col - i : i - col);
+    }
+  }
+  return res;
+}
+
+// Symmetric permutation of a square sparse system, so that index i of the reordered system is
+// index perm[i] of the original one.
+class Reordering
+{
+private:
+  std::vector<backend::CsrIndex> m_perm;
+  std::vector<backend::CsrIndex> m_inverse;
+
+public:
+  explicit Reordering(std::vector<backend::CsrIndex> perm)
+      : m_perm(std::move(perm)), m_inverse(this->m_perm.size())
+  {
+    for (size_t i{0}; i < this->m_perm.size(); i++)
+    {
+      this->m_inverse[this->m_perm[i]] = static_cast<backend::CsrIndex>(i);
+    }
+  }
+
+  // Reverse Cuthill-McKee, which packs the non-zeros in a narrow band around the diagonal
+  static Reordering rcm(backend::CsrData const &a)
+  {
+    return Reordering{detail::reverse_cuthill_mckee(a)};
+  }
+
+  // Nested dissection on level-set separators, which keeps parts of at most `leaf_size` rows
+  // together and orders every separator after the parts it splits
+  static Reordering nested_dissection(backend::CsrData const &a, size_t const leaf_size = 64)
+  {
+    return Reordering{detail::nested_dissection(a, leaf_size)};
+  }
+
+  [[nodiscard]] std::vector<backend::CsrIndex> const &perm() const { return this->m_perm; }
+
+  // P A P^T
+  [[nodiscard]] backend::CsrData apply(backend::CsrData const &a) const
+  {
+    auto const n = this->m_perm.size();
+    backend::CsrData res;
+    res.row_ptr.reserve(n + 1);
+    res.col_idx.reserve(a.col_idx.size());
+    res.values.reserve(a.values.size());
+    res.row_ptr.push_back(0);
+
+    std::vector<std::pair<backend::CsrIndex, float>> row;
+    for (size_t i{0}; i < n; i++)
+    {
+      auto const old = static_cast<size_t>(this->m_perm[i]);
+      row.clear();
+      for (auto k = a.row_ptr[old]; k < a.row_ptr[old + 1]; k++)
+      {
+        row.emplace_back(this->m_inverse[a.col_idx[k]], a.values[k]);
+      }
+      std::sort(row.begin(), row.end());
+      for (auto const &[col, value] : row)
+      {
+        res.col_idx.push_back(col);
+        res.values.push_back(value);
+      }
+      res.row_ptr.push_back(static_cast<backend::CsrIndex>(res.values.size()));
+    }
+
+    return res;
+  }
+
+  // P x, permuted on the host as it is done once per solve
+  [[nodiscard]] Tensor apply(Tensor const &x) const
+  {
+    auto const data = x.cpu();
+    std::vector<float> res(data.size());
+    for (size_t i{0}; i < res.size(); i++)
+    {
+      res[i] = data[this->m_perm[i]];
+    }
+    return {std::move(res), x.shape(), x.get_device()};
+  }
+
+  // P^T x, the inverse of `apply`
+  [[nodiscard]] Tensor restore(Tensor const &x) const
+  {
+    auto const data = x.cpu();
+    std::vector<float> res(data.size());
+    for (size_t i{0}; i < res.size(); i++)
+    {
+      res[this->m_perm[i]] = data[i];
+    }
+    return {std::move(res), x.shape(), x.get_device()};
+  }
+};
+
+// Solves A x = b as `solve(P A P^T, P b, P x0)` on the device of b, returning the solution in the
+// original ordering. `solve` is any solver taking a CsrMatrix, e.g. a lambda calling
+// `conjuaget_gradient`.
+template <class Solve>
+Tensor solve_reordered(
+    backend::CsrData const &a,
+    Tensor const &b,
+    Tensor const &x0,
+    Reordering const &reordering,
+    Solve const &solve
+)
+{
+  auto const n = b.shape().rows;
+  auto pa      = reordering.apply(a);
+  CsrMatrix const op(
+      Shape{n, n},
+      std::move(pa.row_ptr),
+      std::move(pa.col_idx),
+      std::move(pa.values),
+      b.get_device()
+  );
+  return reordering.restore(solve(op, reordering.apply(b), reordering.apply(x0)));
+}
+
+} // namespace gpu_playground
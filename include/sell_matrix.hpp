@@ -0,0 +1,90 @@
+#pragma once
+
+#include <vector>
+
+#include "tensor.hpp"
+
+namespace gpu_playground
+{
+
+// Sparse matrix in sliced ELLPACK (SELL-C-sigma) format, which lets SIMD devices multiply C rows
+// per instruction even when row lengths vary. Devices without SELL kernels store it in CSR.
+class SellMatrix
+{
+private:
+  DevicePtr device;
+  backend::SparseBuffer buffer;
+
+  SellMatrix(Shape shape, backend::CsrData csr, DevicePtr device, size_t const sigma)
+      : device(std::move(device)), buffer(this->device->new_sell(shape, std::move(csr), sigma))
+  {
+  }
+
+public:
+  // Rows sorted together by length, a trade-off between padding and locality of the x accesses
+  static constexpr size_t default_sigma{256};
+
+  SellMatrix()  = delete;
+  ~SellMatrix() = default;
+
+  SellMatrix(SellMatrix const &)            = delete;
+  SellMatrix &operator=(SellMatrix const &) = delete;
+  SellMatrix(SellMatrix &&)                 = default;
+  SellMatrix &operator=(SellMatrix &&)      = default;
+
+  // Same CSR arrays as CsrMatrix
+  SellMatrix(
+      Shape shape,
+      std::vector<backend::CsrIndex> row_ptr,
+      std::vector<backend::CsrIndex> col_idx,
+      std::vector<float> values,
+      DevicePtr device,
+      size_t const sigma = default_sigma
+  )
+      : SellMatrix(
+            shape,
+            backend::CsrData{std::move(row_ptr), std::move(col_idx), std::move(values)},
+            std::move(device),
+            sigma
+        )
+  {
+  }
+
+  static SellMatrix from_triplets(
+      Shape shape,
+      std::vector<backend::Triplet> const &triplets,
+      DevicePtr device,
+      size_t const sigma = default_sigma
+  )
+  {
+    return {shape, backend::csr_from_triplets(shape, triplets), std::move(device), sigma};
+  }
+
+  // Non-zeros of a dense tensor, on the same device
+  static SellMatrix from_dense(Tensor const &a, size_t const sigma = default_sigma)
+  {
+    return {a.shape(), backend::csr_from_dense(a.shape(), a.cpu()), a.get_device(), sigma};
+  }
+
+  // Sparse matrix-vector product with x a column vector, or sparse matrix times a block of
+  // columns, which reads the matrix once for all of them
+  Tensor operator*(Tensor const &x) const
+  {
+    Tensor out = Tensor::empty(Shape{this->buffer.shape().rows, x.shape().cols}, this->device);
+    if (x.shape().cols == 1)
+    {
+      this->device->spmv(this->buffer, x.buffer, out.buffer);
+      return out;
+    }
+    this->device->spmm(this->buffer, x.contiguous().buffer, out.buffer);
+    return out;
+  }
+
+  [[nodiscard]] Shape shape() const { return this->buffer.shape(); }
+
+  [[nodiscard]] size_t nnz() const { return this->buffer.nnz(); }
+
+  [[nodiscard]] DevicePtr get_device() const { return this->device; }
+};
+
+} // namespace gpu_playground
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "buffer.hpp"
+
+namespace gpu_playground::backend
+{
+
+using CsrIndex = std::int32_t;
+
+enum class SparseFormat : std::uint8_t
+{
+  CSR,
+  SELL, // sliced ELLPACK, see `Device::new_sell`
+};
+
+// Non-zero given by its coordinates, duplicates are summed
+struct Triplet
+{
+  CsrIndex row{0};
+  CsrIndex col{0};
+  float value{0.0};
+};
+
+// Compressed sparse row arrays: the non-zeros of row i are values[row_ptr[i] .. row_ptr[i + 1])
+// and sit in columns col_idx[row_ptr[i] .. row_ptr[i + 1]), which are strictly increasing.
+struct CsrData
+{
+  std::vector<CsrIndex> row_ptr;
+  std::vector<CsrIndex> col_idx;
+  std::vector<float> values;
+};
+
+// Buckets the triplets by row, then sorts each row by column and sums duplicates, in time linear
+// in the number of triplets for rows of bounded length.
+inline CsrData csr_from_triplets(Shape const shape, std::vector<Triplet> const &triplets)
+{
+  std::vector<size_t> offsets(shape.rows + 1, 0);
+  for (auto const &triplet : triplets)
+  {
+    offsets[static_cast<size_t>(triplet.row) + 1]++;
+  }
+  for (size_t i{0}; i < shape.rows; i++)
+  {
+    offsets[i + 1] += offsets[i];
+  }
+
+  std::vector<std::pair<CsrIndex, float>> entries(triplets.size());
+  {
+    auto next = offsets;
+    for (auto const &triplet : triplets)
+    {
+      entries[next[static_cast<size_t>(triplet.row)]++] = {triplet.col, triplet.value};
+    }
+  }
+
+  CsrData csr;
+  csr.row_ptr.reserve(shape.rows + 1);
+  csr.col_idx.reserve(entries.size());
+  csr.values.reserve(entries.size());
+  csr.row_ptr.push_back(0);
+  for (size_t i{0}; i < shape.rows; i++)
+  {
+    auto const first = entries.begin() + static_cast<std::ptrdiff_t>(offsets[i]);
+    auto const last  = entries.begin() + static_cast<std::ptrdiff_t>(offsets[i + 1]);
+    std::sort(first, last, [](auto const &lhs, auto const &rhs) { return lhs.first < rhs.first; });
+
+    auto const row_begin = csr.values.size();
+    for (auto it = first; it != last; ++it)
+    {
+      if (csr.values.size() > row_begin and csr.col_idx.back() == it->first)
+      {
+        csr.values.back() += it->second;
+        continue;
+      }
+      csr.col_idx.push_back(it->first);
+      csr.values.push_back(it->second);
+    }
+    csr.row_ptr.push_back(static_cast<CsrIndex>(csr.values.size()));
+  }
+
+  return csr;
+}
+
+// Non-zeros of a row-major dense matrix
+inline CsrData csr_from_dense(Shape const shape, std::vector<float> const &data)
+{
+  CsrData csr;
+  csr.row_ptr.reserve(shape.rows + 1);
+  csr.row_ptr.push_back(0);
+  for (size_t i{0}; i < shape.rows; i++)
+  {
+    for (size_t j{0}; j < shape.cols; j++)
+    {
+      auto const value = data[(i * shape.cols) + j];
+      if (value != 0.0F)
+      {
+        csr.col_idx.push_back(static_cast<CsrIndex>(j));
+        csr.values.push_back(value);
+      }
+    }
+    csr.row_ptr.push_back(static_cast<CsrIndex>(csr.values.size()));
+  }
+
+  return csr;
+}
+
+// Device storage of a sparse matrix, in a format chosen by the device that created it.
+class SparseBuffer
+{
+private:
+  HandlePtr m_handle;
+  Shape m_shape;
+  size_t m_nnz;
+  DeviceType m_device_type;
+  SparseFormat m_format{SparseFormat::CSR};
+
+public:
+  SparseBuffer()                                = delete;
+  SparseBuffer(SparseBuffer const &)            = delete;
+  SparseBuffer &operator=(SparseBuffer const &) = delete;
+  SparseBuffer(SparseBuffer &&)                 = default;
+  SparseBuffer &operator=(SparseBuffer &&)      = default;
+  ~SparseBuffer()                               = default;
+
+  SparseBuffer(HandlePtr handle, Shape shape, size_t nnz, DeviceType device_type)
+      : m_handle(std::move(handle)), m_shape(shape), m_nnz(nnz), m_device_type(device_type)
+  {
+  }
+
+  SparseBuffer(
+      HandlePtr handle, Shape shape, size_t nnz, DeviceType device_type, SparseFormat format
+  )
+      : m_handle(std::move(handle)), m_shape(shape), m_nnz(nnz), m_device_type(device_type),
+        m_format(format)
+  {
+  }
+
+  [[nodiscard]] void *get() { return this->m_handle.get(); }
+
+  [[nodiscard]] void const *get() const { return this->m_handle.get(); }
+
+  [[nodiscard]] Shape shape() const { return this->m_shape; }
+
+  // Number of stored non-zeros
+  [[nodiscard]] size_t nnz() const { return this->m_nnz; }
+
+  [[nodiscard]] DeviceType device_type() const { return this->m_device_type; }
+
+  [[nodiscard]] SparseFormat format() const { return this->m_format; }
+};
+
+// y[i] = row i of `csr` times x, for rows [row_begin, row_end)
+inline void csr_spmv_rows(
+    CsrData const &csr, float const *x, float *y, size_t const row_begin, size_t const row_end
+)
+{
+  for (size_t i{row_begin}; i < row_end; i++)
+  {
+    auto const end = static_cast<size_t>(csr.row_ptr[i + 1]);
+    float sum{0.0};
+    for (auto k = static_cast<size_t>(csr.row_ptr[i]); k < end; k++)
+    {
+      sum += csr.values[k] * x[csr.col_idx[k]];
+    }
+    y[i] = sum;
+  }
+}
+
+// Rows [row_begin, row_end) of Y = csr * X, with X a row-major (cols x s) block and Y (rows x s),
+// so that every non-zero is loaded once for the s columns
+inline void csr_spmm_rows(
+    CsrData const &csr,
+    float const *x,
+    float *y,
+    size_t const s,
+    size_t const row_begin,
+    size_t const row_end
+)
+{
+  for (size_t i{row_begin}; i < row_end; i++)
+  {
+    auto *y_row = y + (i * s);
+    std::fill(y_row, y_row + s, 0.0F);
+    auto const end = static_cast<size_t>(csr.row_ptr[i + 1]);
+    for (auto k = static_cast<size_t>(csr.row_ptr[i]); k < end; k++)
+    {
+      auto const value  = csr.values[k];
+      auto const *x_row = x + (static_cast<size_t>(csr.col_idx[k]) * s);
+      for (size_t j{0}; j < s; j++)
+      {
+        y_row[j] += value * x_row[j];
+      }
+    }
+  }
+}
+
+inline void
+assert_valid_csr([[maybe_unused]] Shape const shape, [[maybe_unused]] CsrData const &csr)
+{
+#ifndef NDEBUG
+  assert(csr.row_ptr.size() == shape.rows + 1 and "Row pointers must have rows + 1 entries");
+  assert(csr.row_ptr.front() == 0 and "Row pointers must start at 0");
+  assert(
+      static_cast<size_t>(csr.row_ptr.back()) == csr.values.size() and
+      "Row pointers must end at the number of non-zeros"
+  );
+  assert(csr.col_idx.size() == csr.values.size() and "Every non-zero must have a column index");
+  for (size_t i{0}; i < shape.rows; i++)
+  {
+    assert(csr.row_ptr[i] <= csr.row_ptr[i + 1] and "Row pointers must be non-decreasing");
+    auto const begin = static_cast<size_t>(csr.row_ptr[i]);
+    auto const end   = static_cast<size_t>(csr.row_ptr[i + 1]);
+    for (size_t k{begin}; k < end; k++)
+    {
+      auto const col = csr.col_idx[k];
+      assert(col >= 0 and static_cast<size_t>(col) < shape.cols and "Column index out of range");
+      assert(
+          (k == begin or csr.col_idx[k - 1] < col) and
+          "Column indices must be strictly increasing within a row"
+      );
+    }
+  }
+#endif
+}
+
+inline void assert_compatible_spmv(
+    [[maybe_unused]] SparseBuffer const &a,
+    [[maybe_unused]] Buffer const &x,
+    [[maybe_unused]] Buffer const &y
+)
+{
+#ifndef NDEBUG
+  assert_valid_buffers(x, y);
+  assert_single_precision(x, y);
+  assert(a.device_type() == x.device_type() and "Buffers are on different devices");
+  assert(x.shape().rows == a.shape().cols and x.shape().cols == 1 and "Input vector shape error");
+  assert(y.shape().rows == a.shape().rows and y.shape().cols == 1 and "Output vector shape error");
+#endif
+}
+
+inline void assert_compatible_spmm(
+    [[maybe_unused]] SparseBuffer const &a,
+    [[maybe_unused]] Buffer const &x,
+    [[maybe_unused]] Buffer const &y
+)
+{
+#ifndef NDEBUG
+  assert_valid_buffers(x, y);
+  assert_single_precision(x, y);
+  assert(a.device_type() == x.device_type() and "Buffers are on different devices");
+  assert(not x.is_transposed() and not y.is_transposed() and "Blocks must be row-major");
+  assert(x.shape().rows == a.shape().cols and "Input block shape error");
+  assert(
+      (y.shape().rows == a.shape().rows and y.shape().cols == x.shape().cols) and
+      "Output block shape error"
+  );
+#endif
+}
+
+} // namespace gpu_playground::backend
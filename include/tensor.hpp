@@ -10,13 +10,165 @@
 namespace gpu_playground
 {
 
+// Element-wise expression built from `Tensor::lazy()`, evaluated in a single fused pass when it
+// is assigned to a Tensor. It references the tensors it was built from, so it must be consumed
+// before they go away, typically within the same statement.
+class LazyTensor
+{
+private:
+  DevicePtr device;
+  backend::Expression expr;
+
+  LazyTensor(DevicePtr device, backend::Expression expr)
+      : device(std::move(device)), expr(std::move(expr))
+  {
+  }
+
+  [[nodiscard]] LazyTensor binary(backend::ExprOp const op, LazyTensor const &other) const
+  {
+    return {this->device, backend::Expression::binary(op, this->expr, other.expr)};
+  }
+
+  // `scalar` must come straight from `lazy()` on a 1x1 tensor
+  [[nodiscard]] LazyTensor sop(backend::ExprOp const op, LazyTensor const &scalar) const
+  {
+#ifndef NDEBUG
+    assert(scalar.expr.code().size() == 1 and "Scalar operand must be a tensor");
+#endif
+    auto const &buffer = *scalar.expr.operands().front();
+    return {
+        this->device,
+        backend::Expression::binary(
+            op, this->expr, backend::Expression::scalar(buffer, this->expr)
+        )
+    };
+  }
+
+public:
+  friend class Tensor;
+
+  friend LazyTensor operator+(LazyTensor const &lhs, LazyTensor const &rhs);
+
+  friend LazyTensor operator-(LazyTensor const &lhs, LazyTensor const &rhs);
+
+  [[nodiscard]] LazyTensor cmul(LazyTensor const &other) const
+  {
+    return this->binary(backend::ExprOp::MUL, other);
+  }
+
+  [[nodiscard]] LazyTensor cdiv(LazyTensor const &other) const
+  {
+    return this->binary(backend::ExprOp::DIV, other);
+  }
+
+  // Quotient that is 0 wherever `other` is 0, e.g. for the step lengths of a solver, which are
+  // 0 / 0 once it has converged exactly
+  [[nodiscard]] LazyTensor cdiv_or_zero(LazyTensor const &other) const
+  {
+    return this->binary(backend::ExprOp::DIV_OR_ZERO, other);
+  }
+
+  [[nodiscard]] LazyTensor sadd(LazyTensor const &other) const
+  {
+    return this->sop(backend::ExprOp::ADD, other);
+  }
+
+  [[nodiscard]] LazyTensor ssub(LazyTensor const &other) const
+  {
+    return this->sop(backend::ExprOp::SUB, other);
+  }
+
+  [[nodiscard]] LazyTensor smul(LazyTensor const &other) const
+  {
+    return this->sop(backend::ExprOp::MUL, other);
+  }
+
+  [[nodiscard]] LazyTensor sdiv(LazyTensor const &other) const
+  {
+    return this->sop(backend::ExprOp::DIV, other);
+  }
+
+  [[nodiscard]] Shape shape() const { return this->expr.shape(); }
+};
+
+inline LazyTensor operator+(LazyTensor const &lhs, LazyTensor const &rhs)
+{
+  return lhs.binary(backend::ExprOp::ADD, rhs);
+}
+
+inline LazyTensor operator-(LazyTensor const &lhs, LazyTensor const &rhs)
+{
+  return lhs.binary(backend::ExprOp::SUB, rhs);
+}
+
 class Tensor
 {
 private:
   DevicePtr device;
   backend::Buffer buffer;
 
+  Tensor(backend::Buffer buffer, DevicePtr device)
+      : device(std::move(device)), buffer(std::move(buffer))
+  {
+  }
+
+  // Uninitialised buffer of the given shape and dtype, stored transposed if requested
+  static backend::Buffer empty_buffer(
+      Device const &device, Shape const shape, bool const transposed, DType const dtype
+  )
+  {
+    if (not transposed)
+    {
+      return device.new_typed_buffer(shape, dtype);
+    }
+    return device.new_typed_buffer(Shape{shape.cols, shape.rows}, dtype).transposed();
+  }
+
+  [[nodiscard]] backend::Buffer empty_like() const
+  {
+    return Tensor::empty_buffer(
+        *this->device, this->buffer.shape(), this->buffer.is_transposed(), this->buffer.dtype()
+    );
+  }
+
+  // Products of F64 tensors are F64, all others are accumulated into F32
+  [[nodiscard]] DType product_dtype() const
+  {
+    return this->buffer.dtype() == DType::F64 ? DType::F64 : DType::F32;
+  }
+
+  // `other` in the layout of this tensor, copied only if the layouts differ
+  [[nodiscard]] backend::Buffer aligned(Tensor const &other) const
+  {
+    if (this->buffer.is_transposed())
+    {
+      return this->device->contiguous(other.buffer.transposed()).transposed();
+    }
+    return this->device->contiguous(other.buffer);
+  }
+
+  // Whether `other` is a row or column vector repeated over this matrix, rather than a tensor of
+  // the same shape
+  [[nodiscard]] bool is_broadcast(Tensor const &other) const
+  {
+    auto const [rows, cols] = this->buffer.shape();
+    return other.buffer.shape().rows != rows or other.buffer.shape().cols != cols;
+  }
+
+  // Gives this tensor its own storage before it is modified in place
+  void detach()
+  {
+    if (this->buffer.is_shared())
+    {
+      *this = Tensor{*this};
+    }
+  }
+
 public:
+  friend class CsrMatrix;
+
+  friend class SellMatrix;
+
   Tensor()  = delete;
   ~Tensor() = default;
 
@@ -28,15 +180,56 @@ public:
   {
   }
 
-  Tensor(Tensor const &other)
-      : device(other.device), buffer(this->device->new_buffer_with_shape(other.buffer.shape()))
+  Tensor(Tensor const &other) : device(other.device), buffer(other.empty_like())
+  {
+    auto storage = this->buffer.storage();
+    this->device->copy_buffer(other.buffer.storage(), storage);
+  }
+
+  Tensor(LazyTensor const &lazy)
+      : device(lazy.device),
+        buffer(Tensor::empty_buffer(
+            *this->device, lazy.shape(), lazy.expr.transposed(), lazy.expr.dtype()
+        ))
   {
-    this->device->copy_buffer(other.buffer, this->buffer);
+    this->device->eval(lazy.expr, this->buffer);
   }
 
   static Tensor zeros(Shape shape, DevicePtr device)
   {
-    return {std::vector<float>(shape.rows * shape.cols, 0.0), shape, std::move(device)};
+    auto buffer = device->new_buffer_with_shape(shape);
+    return {std::move(buffer), std::move(device)};
+  }
+
+  // Tensor with unspecified contents, for results that are about to be overwritten
+  static Tensor empty(Shape shape, DevicePtr device, DType const dtype = DType::F32)
+  {
+    auto buffer = device->new_typed_buffer(shape, dtype);
+    return {std::move(buffer), std::move(device)};
+  }
+
+  // F64 tensor holding `data`, on a device that supports F64
+  static Tensor from_f64(std::vector<double> data, Shape shape, DevicePtr device)
+  {
+    auto buffer = device->new_f64_buffer(std::move(data), shape);
+    return {std::move(buffer), std::move(device)};
+  }
+
+  // F32 tensor whose zeroed row-major elements are written on the host by fill(data): in place on
+  // devices whose buffers live in host memory, through a host copy on the others
+  template <class Fill>
+  static Tensor filled(Shape shape, DevicePtr device, Fill const &fill)
+  {
+    auto buffer = device->new_buffer_with_shape(shape);
+    if (auto *data = device->host_data(buffer); data != nullptr)
+    {
+      fill(data);
+      return {std::move(buffer), std::move(device)};
+    }
+
+    std::vector<float> host(shape.rows * shape.cols, 0.0);
+    fill(host.data());
+    return {std::move(host), shape, std::move(device)};
   }
 
   static Tensor ones(Shape shape, DevicePtr device)
@@ -66,9 +259,31 @@ public:
       return;
     }
 
-    auto const data  = this->cpu();
     auto const shape = this->buffer.shape();
-    *this            = Tensor(data, shape, std::move(device));
+    auto const dtype = this->buffer.dtype();
+    if (dtype == DType::F64)
+    {
+      *this = Tensor::from_f64(this->cpu_f64(), shape, std::move(device));
+      return;
+    }
+
+    *this = Tensor(this->cpu(), shape, std::move(device));
+    if (dtype != DType::F32)
+    {
+      *this = this->to_dtype(dtype);
+    }
+  }
+
+  // Copy of this tensor with elements of `dtype`, rounded to nearest even when narrowed. F16 and
+  // BF16 tensors only take part in products, `dot`, copies and conversions, which read them in
+  // float, and cannot be transposed unless they are vectors. F64 tensors only combine with F64
+  // tensors.
+  [[nodiscard]] Tensor to_dtype(DType const dtype) const
+  {
+    auto const from = this->device->contiguous(this->buffer);
+    Tensor out{this->device->new_typed_buffer(from.shape(), dtype), this->device};
+    this->device->convert(from, out.buffer);
+    return out;
   }
 
   Tensor &operator=(Tensor const &other)
@@ -79,21 +294,87 @@ public:
     }
 
     this->device = other.device;
-    this->device->copy_buffer(other.buffer, this->buffer);
+    if (this->buffer.dtype() != other.buffer.dtype())
+    {
+      this->buffer = other.empty_like();
+    }
+    else if (this->buffer.is_shared())
+    {
+      this->buffer = this->empty_like();
+    }
+
+    auto storage = this->buffer.storage();
+    if (this->buffer.is_transposed() == other.buffer.is_transposed())
+    {
+      this->device->copy_buffer(other.buffer.storage(), storage);
+    }
+    else
+    {
+      this->device->transpose(other.buffer.storage(), storage);
+    }
 
     return *this;
   }
 
+  // Evaluates `lazy` into this tensor, which may also appear in the expression. The result gets
+  // new storage when its dtype, shape or layout differs from this tensor's.
+  Tensor &operator=(LazyTensor const &lazy)
+  {
+    auto const [rows, cols] = this->buffer.shape();
+    if (this->buffer.dtype() != lazy.expr.dtype() or lazy.shape().rows != rows or
+        lazy.shape().cols != cols or this->buffer.is_transposed() != lazy.expr.transposed())
+    {
+      return *this = Tensor{lazy};
+    }
+
+    this->detach();
+    this->device->eval(lazy.expr, this->buffer);
+
+    return *this;
+  }
+
+  // `rhs` is either of the same shape or a row or column vector, repeated over this matrix. The
+  // same goes for -=, cmul and cdiv.
   Tensor &operator+=(Tensor const &rhs)
   {
-    this->device->add(this->buffer, rhs.buffer, this->buffer);
+    this->detach();
+    if (this->is_broadcast(rhs))
+    {
+      this->device->broadcast(backend::ExprOp::ADD, this->buffer, rhs.buffer, this->buffer);
+      return *this;
+    }
+    this->device->add(this->buffer, this->aligned(rhs), this->buffer);
 
     return *this;
   }
 
   Tensor &operator-=(Tensor const &rhs)
   {
-    this->device->sub(this->buffer, rhs.buffer, this->buffer);
+    this->detach();
+    if (this->is_broadcast(rhs))
+    {
+      this->device->broadcast(backend::ExprOp::SUB, this->buffer, rhs.buffer, this->buffer);
+      return *this;
+    }
+    this->device->sub(this->buffer, this->aligned(rhs), this->buffer);
+
+    return *this;
+  }
+
+  // this = alpha * x + this, with alpha a 1x1 tensor
+  Tensor &axpy(Tensor const &alpha, Tensor const &x)
+  {
+    this->detach();
+    this->device->axpy(alpha.buffer, this->aligned(x), this->buffer);
+
+    return *this;
+  }
+
+  // this = alpha * x + beta * this, with alpha and beta 1x1 tensors
+  Tensor &axpby(Tensor const &alpha, Tensor const &x, Tensor const &beta)
+  {
+    this->detach();
+    this->device->axpby(alpha.buffer, this->aligned(x), beta.buffer, this->buffer);
 
     return *this;
   }
@@ -104,69 +385,167 @@ public:
 
   Tensor operator*(Tensor const &other) const
   {
-    Tensor out =
-        Tensor::zeros(Shape{this->buffer.shape().rows, other.buffer.shape().cols}, this->device);
+    Tensor out = Tensor::empty(
+        Shape{this->buffer.shape().rows, other.buffer.shape().cols},
+        this->device,
+        this->product_dtype()
+    );
     this->device->mul(this->buffer, other.buffer, out.buffer);
     return out;
   }
 
+  // Stack of `batch` products, where this tensor stacks the batch of (m x k) left operands by
+  // rows into a (batch * m x k) matrix and `other` the (k x n) right operands. Both must be
+  // row-major.
+  [[nodiscard]] Tensor batched_mul(Tensor const &other, size_t const batch) const
+  {
+    Tensor out =
+        Tensor::empty(Shape{this->buffer.shape().rows, other.buffer.shape().cols}, this->device);
+    this->device->batched_mul(this->buffer, other.buffer, out.buffer, batch);
+    return out;
+  }
+
+  // Solutions of the batch of SPD systems A_i x_i = b_i by conjugate gradient from the initial
+  // guesses x0, where this row-major tensor stacks the (n x n) matrices A_i by rows and b the
+  // right-hand sides
+  [[nodiscard]] Tensor batched_cg(
+      Tensor const &b, Tensor const &x0, size_t const batch, size_t const max_iter, float const tol
+  ) const
+  {
+    Tensor x{x0};
+    this->device->batched_cg(this->buffer, b.buffer, x.buffer, batch, max_iter, tol);
+    return x;
+  }
+
+  // Solutions of the same systems by Cholesky factorisation
+  [[nodiscard]] Tensor batched_cholesky(Tensor const &b, size_t const batch) const
+  {
+    Tensor x = Tensor::empty(b.buffer.shape(), this->device);
+    this->device->batched_cholesky(this->buffer, b.buffer, x.buffer, batch);
+    return x;
+  }
+
   [[nodiscard]] Tensor cmul(Tensor const &other) const
   {
-    Tensor out = Tensor::zeros(this->buffer.shape(), this->device);
-    this->device->cmul(this->buffer, other.buffer, out.buffer);
+    Tensor out{this->empty_like(), this->device};
+    if (this->is_broadcast(other))
+    {
+      this->device->broadcast(backend::ExprOp::MUL, this->buffer, other.buffer, out.buffer);
+      return out;
+    }
+    this->device->cmul(this->buffer, this->aligned(other), out.buffer);
     return out;
   }
 
   [[nodiscard]] Tensor cdiv(Tensor const &other) const
   {
-    Tensor out = Tensor::zeros(this->buffer.shape(), this->device);
-    this->device->cdiv(this->buffer, other.buffer, out.buffer);
+    Tensor out{this->empty_like(), this->device};
+    if (this->is_broadcast(other))
+    {
+      this->device->broadcast(backend::ExprOp::DIV, this->buffer, other.buffer, out.buffer);
+      return out;
+    }
+    this->device->cdiv(this->buffer, this->aligned(other), out.buffer);
     return out;
   }
 
   [[nodiscard]] Tensor sadd(Tensor const &other) const
   {
-    Tensor out = Tensor::zeros(this->buffer.shape(), this->device);
+    Tensor out{this->empty_like(), this->device};
     this->device->sadd(this->buffer, other.buffer, out.buffer);
     return out;
   }
 
   [[nodiscard]] Tensor ssub(Tensor const &other) const
   {
-    Tensor out = Tensor::zeros(this->buffer.shape(), this->device);
+    Tensor out{this->empty_like(), this->device};
     this->device->ssub(this->buffer, other.buffer, out.buffer);
     return out;
   }
 
   [[nodiscard]] Tensor smul(Tensor const &other) const
   {
-    Tensor out = Tensor::zeros(this->buffer.shape(), this->device);
+    Tensor out{this->empty_like(), this->device};
     this->device->smul(this->buffer, other.buffer, out.buffer);
     return out;
   }
 
   [[nodiscard]] Tensor sdiv(Tensor const &other) const
   {
-    Tensor out = Tensor::zeros(this->buffer.shape(), this->device);
+    Tensor out{this->empty_like(), this->device};
     this->device->sdiv(this->buffer, other.buffer, out.buffer);
     return out;
   }
 
+  [[nodiscard]] Tensor dot(Tensor const &other) const
+  {
+    Tensor out = Tensor::empty(Shape{1, 1}, this->device, this->product_dtype());
+    this->device->dot(this->buffer, this->aligned(other), out.buffer);
+    return out;
+  }
+
+  // Transposed view sharing the storage of this tensor, copied only once either is modified
   [[nodiscard]] Tensor transpose() const
   {
+#ifndef NDEBUG
     auto const [rows, cols] = this->buffer.shape();
-    Tensor out              = Tensor::zeros(Shape{cols, rows}, this->device);
-    this->device->transpose(this->buffer, out.buffer);
-    return out;
+    assert(
+        (not is_reduced(this->buffer.dtype()) or rows == 1 or cols == 1) and
+        "Reduced precision matrices cannot be transposed"
+    );
+#endif
+    return {this->buffer.transposed(), this->device};
+  }
+
+  // Row-major copy of a transposed view, or a view of any other tensor
+  [[nodiscard]] Tensor contiguous() const
+  {
+    return {this->device->contiguous(this->buffer), this->device};
+  }
+
+  [[nodiscard]] LazyTensor lazy() const
+  {
+    return {this->device, backend::Expression::load(this->buffer)};
   }
 
   friend std::ostream &operator<<(std::ostream &os, Tensor const &t);
 
-  [[nodiscard]] std::vector<float> cpu() const { return this->device->cpu(this->buffer); }
+  [[nodiscard]] std::vector<float> cpu() const
+  {
+    return this->device->cpu(this->device->contiguous(this->buffer));
+  }
+
+  // Host copy as doubles, exact for F64 tensors
+  [[nodiscard]] std::vector<double> cpu_f64() const
+  {
+    return this->device->cpu_f64(this->device->contiguous(this->buffer));
+  }
+
+  // Value of a 1x1 tensor, waiting for the device but without copying through `cpu()`
+  [[nodiscard]] float item() const
+  {
+#ifndef NDEBUG
+    assert(this->buffer.size() == 1 and "Only 1x1 tensors have an item");
+#endif
+    return this->device->read_scalar(this->buffer);
+  }
+
+  // Same as `item`, exact for F64 tensors
+  [[nodiscard]] double item_f64() const
+  {
+#ifndef NDEBUG
+    assert(this->buffer.size() == 1 and "Only 1x1 tensors have an item");
+#endif
+    return this->device->read_scalar_f64(this->buffer);
+  }
 
   void sync() const { this->device->sync(this->buffer); }
 
   [[nodiscard]] Shape shape() const { return this->buffer.shape(); }
+
+  [[nodiscard]] DType dtype() const { return this->buffer.dtype(); }
+
+  [[nodiscard]] DevicePtr get_device() const { return this->device; }
 };
 
 inline Tensor operator+(Tensor lhs, Tensor const &rhs)
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gpu_playground
+{
+
+// Work-stealing thread pool shared by the CPU backends.
+//
+// Every worker owns a deque of tasks: it pops its own tasks from the back and steals from the
+// front of the other deques when it runs out. The thread calling `parallel_for` takes part in
+// the work as well, so nested calls from inside a task cannot deadlock.
+class ThreadPool
+{
+private:
+  using RangeFn = std::function<void(size_t, size_t)>;
+
+  struct Job
+  {
+    RangeFn const *fn{nullptr};
+    std::atomic<size_t> remaining{0};
+  };
+
+  struct Task
+  {
+    Job *job{nullptr};
+    size_t begin{0};
+    size_t end{0};
+  };
+
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  size_t m_num_threads;
+  std::vector<std::unique_ptr<Queue>> m_queues;
+  std::vector<std::thread> m_workers;
+  std::atomic<size_t> m_pending{0};
+  std::atomic<size_t> m_next_queue{0};
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_stop{false};
+
+  // Index of the queue owned by the calling thread, or m_queues.size() for external threads.
+  [[nodiscard]] size_t own_queue() const
+  {
+    auto const &[pool, index] = ThreadPool::worker_identity();
+    return pool == this ? index : this->m_queues.size();
+  }
+
+  static std::pair<ThreadPool const *, size_t> &worker_identity()
+  {
+    thread_local std::pair<ThreadPool const *, size_t> identity{nullptr, 0};
+    return identity;
+  }
+
+  bool pop(size_t const index, Task &task)
+  {
+    auto &queue = *this->m_queues[index];
+    std::lock_guard<std::mutex> const lock(queue.mutex);
+    if (queue.tasks.empty())
+    {
+      return false;
+    }
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+  }
+
+  bool steal(size_t const index, Task &task)
+  {
+    auto &queue = *this->m_queues[index];
+    std::lock_guard<std::mutex> const lock(queue.mutex);
+    if (queue.tasks.empty())
+    {
+      return false;
+    }
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+  }
+
+  bool try_run_one(size_t const own)
+  {
+    Task task;
+    bool found = own < this->m_queues.size() and this->pop(own, task);
+
+    auto const count = this->m_queues.size();
+    auto const start = own < count ? own + 1 : this->m_next_queue.load(std::memory_order_relaxed);
+    for (size_t i{0}; i < count and not found; i++)
+    {
+      found = this->steal((start + i) % count, task);
+    }
+
+    if (not found)
+    {
+      return false;
+    }
+
+    this->m_pending.fetch_sub(1, std::memory_order_relaxed);
+    (*task.job->fn)(task.begin, task.end);
+    task.job->remaining.fetch_sub(1, std::memory_order_acq_rel);
+
+    return true;
+  }
+
+  void worker_loop(size_t const index)
+  {
+    ThreadPool::worker_identity() = {this, index};
+
+    while (true)
+    {
+      if (this->try_run_one(index))
+      {
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(this->m_mutex);
+      this->m_cv.wait(
+          lock, [this]() { return this->m_stop or this->m_pending.load() > 0; }
+      );
+      if (this->m_stop and this->m_pending.load() == 0)
+      {
+        return;
+      }
+    }
+  }
+
+public:
+  // `num_threads` counts the calling thread, so a pool of N threads spawns N - 1 workers.
+  explicit ThreadPool(size_t const num_threads) : m_num_threads(std::max<size_t>(num_threads, 1))
+  {
+    for (size_t i{0}; i + 1 < this->m_num_threads; i++)
+    {
+      this->m_queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i{0}; i < this->m_queues.size(); i++)
+    {
+      this->m_workers.emplace_back([this, i]() { this->worker_loop(i); });
+    }
+  }
+
+  ThreadPool(ThreadPool const &)            = delete;
+  ThreadPool &operator=(ThreadPool const &) = delete;
+  ThreadPool(ThreadPool &&)                 = delete;
+  ThreadPool &operator=(ThreadPool &&)      = delete;
+
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> const lock(this->m_mutex);
+      this->m_stop = true;
+    }
+    this->m_cv.notify_all();
+    for (auto &worker : this->m_workers)
+    {
+      worker.join();
+    }
+  }
+
+  [[nodiscard]] size_t num_threads() const { return this->m_num_threads; }
+
+  // Splits [begin, end) into chunks whose size is a multiple of `grain` (except for the last
+  // one) and runs `fn(chunk_begin, chunk_end)` on each of them, returning once all are done.
+  void parallel_for(size_t const begin, size_t const end, size_t const grain, RangeFn const &fn)
+  {
+    if (begin >= end)
+    {
+      return;
+    }
+
+    auto const range       = end - begin;
+    auto const safe_grain  = std::max<size_t>(grain, 1);
+    auto const max_chunks  = this->m_num_threads * 4;
+    auto const target      = (range + max_chunks - 1) / max_chunks;
+    auto const chunk       = ((std::max(target, safe_grain) + safe_grain - 1) / safe_grain) * safe_grain;
+    auto const num_chunks  = (range + chunk - 1) / chunk;
+
+    if (num_chunks == 1 or this->m_queues.empty())
+    {
+      fn(begin, end);
+      return;
+    }
+
+    Job job;
+    job.fn = &fn;
+    job.remaining.store(num_chunks, std::memory_order_relaxed);
+
+    auto const count = this->m_queues.size();
+    auto const first = this->m_next_queue.fetch_add(1, std::memory_order_relaxed) % count;
+    for (size_t c{0}; c < num_chunks; c++)
+    {
+      Task const task{&job, begin + (c * chunk), std::min(end, begin + ((c + 1) * chunk))};
+      auto &queue = *this->m_queues[(first + c) % count];
+      {
+        std::lock_guard<std::mutex> const lock(queue.mutex);
+        queue.tasks.push_back(task);
+      }
+      this->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    {
+      std::lock_guard<std::mutex> const lock(this->m_mutex);
+    }
+    this->m_cv.notify_all();
+
+    auto const own = this->own_queue();
+    while (job.remaining.load(std::memory_order_acquire) > 0)
+    {
+      if (not this->try_run_one(own))
+      {
+        std::this_thread::yield();
+      }
+    }
+  }
+};
+
+namespace detail
+{
+
+inline size_t default_num_threads()
+{
+  auto const hw = std::thread::hardware_concurrency();
+  return hw == 0 ? 1 : hw;
+}
+
+inline std::unique_ptr<ThreadPool> &thread_pool_instance()
+{
+  static std::unique_ptr<ThreadPool> pool{
+      std::make_unique<ThreadPool>(detail::default_num_threads())
+  };
+  return pool;
+}
+
+inline std::atomic<size_t> g_grain_size{size_t{1} << 14};
+
+inline std::atomic<size_t> g_parallel_threshold{size_t{1} << 16};
+
+} // namespace detail
+
+inline ThreadPool &thread_pool() { return *detail::thread_pool_instance(); }
+
+// Replaces the shared pool, must not be called while work is running on it.
+inline void set_num_threads(size_t const num_threads)
+{
+  detail::thread_pool_instance() = std::make_unique<ThreadPool>(num_threads);
+}
+
+inline size_t num_threads() { return thread_pool().num_threads(); }
+
+// Minimum number of elements handed to a single task.
+inline void set_grain_size(size_t const grain_size)
+{
+  detail::g_grain_size.store(std::max<size_t>(grain_size, 1));
+}
+
+inline size_t grain_size() { return detail::g_grain_size.load(); }
+
+// Number of elements below which operations stay on the calling thread.
+inline void set_parallel_threshold(size_t const threshold)
+{
+  detail::g_parallel_threshold.store(threshold);
+}
+
+inline size_t parallel_threshold() { return detail::g_parallel_threshold.load(); }
+
+// Runs `fn` over [begin, end) on the shared pool, or inline if the range is below the parallel
+// threshold.
+template <class Fn>
+void parallel_for(size_t const begin, size_t const end, size_t const grain, Fn const &fn)
+{
+  if (end - begin < parallel_threshold() or num_threads() == 1)
+  {
+    fn(begin, end);
+    return;
+  }
+  thread_pool().parallel_for(begin, end, grain, fn);
+}
+
+template <class Fn>
+void parallel_for(size_t const begin, size_t const end, Fn const &fn)
+{
+  parallel_for(begin, end, grain_size(), fn);
+}
+
+} // namespace gpu_playground
@@ -1,5 +1,7 @@
+#include <cstdint>
 #include <cuda_runtime.h>
 #include <iostream>
+#include <limits>
 
 #include "mat_add.cu"
 #include "mat_sub.cu"
@@ -9,6 +11,9 @@
 #include "mat_ssub.cu"
 #include "mat_smul.cu"
 #include "mat_sdiv.cu"
+#include "mat_dot.cu"
+#include "mat_axpy.cu"
+#include "mat_axpby.cu"
 #include "mat_mul.cu"
 #include "mat_trans.cu"
 
@@ -38,6 +43,7 @@ struct CUDADevice::Impl
   int device{0};
   cudaDeviceProp prop{};
   cudaStream_t stream{};
+  cudaMemPool_t pool{};
 
   Impl()
   {
@@ -45,6 +51,12 @@ struct CUDADevice::Impl
     CHECK(cudaGetDeviceProperties(&(this->prop), this->device));
     CHECK(cudaStreamCreate(&(this->stream)));
 
+    // Keep freed blocks in the stream-ordered pool instead of returning them to the driver at
+    // every synchronisation, so that cudaMallocAsync recycles them.
+    CHECK(cudaDeviceGetDefaultMemPool(&(this->pool), this->device));
+    auto threshold = std::numeric_limits<std::uint64_t>::max();
+    CHECK(cudaMemPoolSetAttribute(this->pool, cudaMemPoolAttrReleaseThreshold, &threshold));
+
     std::cout << "Using GPU: " << this->prop.name << '\n';
   }
 
@@ -100,6 +112,13 @@ void CUDADevice::mul(Buffer const &a, Buffer const &b, Buffer &c) const
 {
   assert_compatible_mul(a, b, c);
 
+  // The kernel only reads row-major operands
+  if (a.is_transposed() or b.is_transposed())
+  {
+    this->mul(this->contiguous(a), this->contiguous(b), c);
+    return;
+  }
+
   auto const *cu_a = static_cast<CUDABuffer const *>(a.get());
   auto const *cu_b = static_cast<CUDABuffer const *>(b.get());
   auto *cu_c       = static_cast<CUDABuffer *>(c.get());
@@ -223,15 +242,91 @@ void CUDADevice::sdiv(Buffer const &a, Buffer const &b, Buffer &c) const
   CHECK(cudaGetLastError());
 }
 
+void CUDADevice::dot(Buffer const &a, Buffer const &b, Buffer &c) const
+{
+  assert_compatible_dot(a, b, c);
+
+  auto const *cu_a = static_cast<CUDABuffer const *>(a.get());
+  auto const *cu_b = static_cast<CUDABuffer const *>(b.get());
+  auto *cu_c       = static_cast<CUDABuffer *>(c.get());
+
+  int const N         = a.size();
+  int const blockSize = 256;
+
+  mat_dot<<<1, blockSize, 0, this->pimpl->stream>>>(cu_a->buffer, cu_b->buffer, cu_c->buffer, N);
+  CHECK(cudaGetLastError());
+}
+
+void CUDADevice::axpy(Buffer const &alpha, Buffer const &x, Buffer &y) const
+{
+  assert_compatible_axpy(alpha, x, y);
+
+  auto const *cu_alpha = static_cast<CUDABuffer const *>(alpha.get());
+  auto const *cu_x     = static_cast<CUDABuffer const *>(x.get());
+  auto *cu_y           = static_cast<CUDABuffer *>(y.get());
+
+  int const N         = x.size();
+  int const blockSize = 256;
+  int const gridSize  = (N + blockSize - 1) / blockSize;
+
+  mat_axpy<<<gridSize, blockSize, 0, this->pimpl->stream>>>(
+      cu_alpha->buffer, cu_x->buffer, cu_y->buffer, N
+  );
+  CHECK(cudaGetLastError());
+}
+
+void CUDADevice::axpby(Buffer const &alpha, Buffer const &x, Buffer const &beta, Buffer &y) const
+{
+  assert_compatible_axpby(alpha, x, beta, y);
+
+  auto const *cu_alpha = static_cast<CUDABuffer const *>(alpha.get());
+  auto const *cu_x     = static_cast<CUDABuffer const *>(x.get());
+  auto const *cu_beta  = static_cast<CUDABuffer const *>(beta.get());
+  auto *cu_y           = static_cast<CUDABuffer *>(y.get());
+
+  int const N         = x.size();
+  int const blockSize = 256;
+  int const gridSize  = (N + blockSize - 1) / blockSize;
+
+  mat_axpby<<<gridSize, blockSize, 0, this->pimpl->stream>>>(
+      cu_alpha->buffer, cu_x->buffer, cu_beta->buffer, cu_y->buffer, N
+  );
+  CHECK(cudaGetLastError());
+}
+
 Buffer CUDADevice::new_buffer(std::vector<float> data, Shape shape) const
 {
-  auto const bytes = data.size() * sizeof(float);
-  CUDABuffer cu_buffer{};
-  CHECK(cudaMallocAsync(&(cu_buffer.buffer), bytes, this->pimpl->stream));
+  auto buffer = this->new_empty_buffer(shape);
   CHECK(cudaMemcpyAsync(
-      cu_buffer.buffer, data.data(), bytes, cudaMemcpyHostToDevice, this->pimpl->stream
+      static_cast<CUDABuffer *>(buffer.get())->buffer,
+      data.data(),
+      data.size() * sizeof(float),
+      cudaMemcpyHostToDevice,
+      this->pimpl->stream
+  ));
+
+  return buffer;
+}
+
+Buffer CUDADevice::new_buffer_with_shape(Shape shape) const
+{
+  auto buffer = this->new_empty_buffer(shape);
+  CHECK(cudaMemsetAsync(
+      static_cast<CUDABuffer *>(buffer.get())->buffer,
+      0,
+      buffer.size() * sizeof(float),
+      this->pimpl->stream
   ));
 
+  return buffer;
+}
+
+Buffer CUDADevice::new_empty_buffer(Shape shape) const
+{
+  auto const bytes = shape.rows * shape.cols * sizeof(float);
+  CUDABuffer cu_buffer{};
+  CHECK(cudaMallocAsync(&(cu_buffer.buffer), bytes, this->pimpl->stream));
+
   return Buffer{
       HandlePtr{
           new CUDABuffer(cu_buffer),
@@ -247,6 +342,25 @@ Buffer CUDADevice::new_buffer(std::vector<float> data, Shape shape) const
   };
 }
 
+// The pool does not count hits and misses, only the memory it holds on to.
+AllocatorStats CUDADevice::allocator_stats() const
+{
+  std::uint64_t reserved{0};
+  std::uint64_t used{0};
+  CHECK(cudaMemPoolGetAttribute(this->pimpl->pool, cudaMemPoolAttrReservedMemCurrent, &reserved));
+  CHECK(cudaMemPoolGetAttribute(this->pimpl->pool, cudaMemPoolAttrUsedMemCurrent, &used));
+
+  AllocatorStats stats;
+  stats.bytes_cached = reserved - used;
+  return stats;
+}
+
+void CUDADevice::trim() const
+{
+  CHECK(cudaStreamSynchronize(this->pimpl->stream));
+  CHECK(cudaMemPoolTrimTo(this->pimpl->pool, 0));
+}
+
 void CUDADevice::copy_buffer(Buffer const &from, Buffer &to) const
 {
   assert_compatible_copy(from, to);
@@ -292,6 +406,20 @@ std::vector<float> CUDADevice::cpu(Buffer const &buffer) const
   return result;
 }
 
+float CUDADevice::read_scalar(Buffer const &buffer) const
+{
+  auto const *cu_ptr = static_cast<CUDABuffer const *>(buffer.get());
+
+  float result{0.0};
+  CHECK(cudaMemcpyAsync(
+      &result, cu_ptr->buffer, sizeof(float), cudaMemcpyDeviceToHost, this->pimpl->stream
+  ));
+
+  CHECK(cudaStreamSynchronize(this->pimpl->stream));
+
+  return result;
+}
+
 void CUDADevice::sync(Buffer const &buffer) const
 {
   CHECK(cudaStreamSynchronize(this->pimpl->stream));
@@ -41,14 +41,30 @@ public:
 
   void sdiv(Buffer const &a, Buffer const &b, Buffer &c) const override;
 
+  void dot(Buffer const &a, Buffer const &b, Buffer &c) const override;
+
+  void axpy(Buffer const &alpha, Buffer const &x, Buffer &y) const override;
+
+  void axpby(Buffer const &alpha, Buffer const &x, Buffer const &beta, Buffer &y) const override;
+
   [[nodiscard]] Buffer new_buffer(std::vector<float> data, Shape shape) const override;
 
+  [[nodiscard]] Buffer new_buffer_with_shape(Shape shape) const override;
+
+  [[nodiscard]] Buffer new_empty_buffer(Shape shape) const override;
+
+  [[nodiscard]] AllocatorStats allocator_stats() const override;
+
+  void trim() const override;
+
   void copy_buffer(Buffer const &from, Buffer &to) const override;
 
   void transpose(Buffer const &from, Buffer &to) const override;
 
   [[nodiscard]] std::vector<float> cpu(Buffer const &buffer) const override;
 
+  [[nodiscard]] float read_scalar(Buffer const &buffer) const override;
+
   void sync(Buffer const &buffer) const override;
 };
 
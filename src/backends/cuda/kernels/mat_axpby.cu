@@ -0,0 +1,8 @@
+__global__ void mat_axpby(const float* alpha, const float* x, const float* beta, float* y, int n)
+{
+    int i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i < n)
+    {
+      y[i] = fma(alpha[0], x[i], beta[0] * y[i]);
+    }
+}
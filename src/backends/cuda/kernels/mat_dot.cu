@@ -0,0 +1,26 @@
+__global__ void mat_dot(const float* a, const float* b, float* c, int n)
+{
+    __shared__ float partial[256];
+
+    float support{0.0};
+    for (int i = threadIdx.x; i < n; i += blockDim.x)
+    {
+      support = fma(a[i], b[i], support);
+    }
+    partial[threadIdx.x] = support;
+    __syncthreads();
+
+    for (int stride = blockDim.x / 2; stride > 0; stride /= 2)
+    {
+      if (threadIdx.x < stride)
+      {
+        partial[threadIdx.x] += partial[threadIdx.x + stride];
+      }
+      __syncthreads();
+    }
+
+    if (threadIdx.x == 0)
+    {
+      c[0] = partial[0];
+    }
+}
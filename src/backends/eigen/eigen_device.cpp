@@ -1,5 +1,6 @@
 #include "buffer.hpp"
 #include <Eigen/Dense>
+#include <cmath>
 #include <memory>
 
 #include "eigen_device.hpp"
@@ -7,19 +8,160 @@
 namespace gpu_playground::backend
 {
 
-using EigenBuffer = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
-
 namespace
 {
 
+template <class T>
+using EigenMap = Eigen::Map<EigenMatrix<T>>;
+template <class T>
+using EigenConstMap = Eigen::Map<EigenMatrix<T> const>;
+using EigenVector   = Eigen::Matrix<float, Eigen::Dynamic, 1>;
+
+// Buffers are mapped with the shape of their storage, which for vector views differs from the
+// shape the EigenBuffer was allocated with. T is float for F32 buffers and double for F64 ones.
+template <class T = float>
+EigenConstMap<T> eigen_map(Buffer const &buffer)
+{
+  auto const [rows, cols] = buffer.storage_shape();
+  return {
+      static_cast<EigenMatrix<T> const *>(buffer.get())->data(),
+      static_cast<Eigen::Index>(rows),
+      static_cast<Eigen::Index>(cols)
+  };
+}
+
+template <class T = float>
+EigenMap<T> eigen_map(Buffer &buffer)
+{
+  auto const [rows, cols] = buffer.storage_shape();
+  return {
+      static_cast<EigenMatrix<T> *>(buffer.get())->data(),
+      static_cast<Eigen::Index>(rows),
+      static_cast<Eigen::Index>(cols)
+  };
+}
+
+// Buffer of `dtype` elements on storage from `cache`, sized to the elements of `shape`
+template <class Storage>
+Buffer new_storage(
+    CachingAllocator<Storage> const &cache,
+    Shape const shape,
+    DeviceType const type,
+    DType const dtype
+)
+{
+  auto const rows = static_cast<Eigen::Index>(shape.rows);
+  auto const cols = static_cast<Eigen::Index>(shape.cols);
+  auto const make = [rows, cols]([[maybe_unused]] size_t const bytes) -> Storage *
+  { return new Storage(rows, cols); };
+  return Buffer{
+      cache.allocate(
+          shape.rows * shape.cols * sizeof(typename Storage::Scalar),
+          make,
+          [rows, cols](Storage &storage) -> void { storage.resize(rows, cols); }
+      ),
+      shape,
+      type,
+      dtype
+  };
+}
+
+// F16 and BF16 storage seen as matrices of the 16-bit type its bits encode, Eigen::half or
+// Eigen::bfloat16, or of the raw bits
+template <class T>
+Eigen::Map<EigenMatrix<T> const> reduced_map(Buffer const &buffer)
+{
+  static_assert(sizeof(T) == sizeof(uint16_t), "Reduced precision elements take 16 bits");
+  auto const [rows, cols] = buffer.storage_shape();
+  auto const *data        = static_cast<EigenReducedBuffer const *>(buffer.get())->data();
+  return {
+      reinterpret_cast<T const *>(data),
+      static_cast<Eigen::Index>(rows),
+      static_cast<Eigen::Index>(cols)
+  };
+}
+
+template <class T>
+Eigen::Map<EigenMatrix<T>> reduced_map(Buffer &buffer)
+{
+  static_assert(sizeof(T) == sizeof(uint16_t), "Reduced precision elements take 16 bits");
+  auto const [rows, cols] = buffer.storage_shape();
+  auto *data              = static_cast<EigenReducedBuffer *>(buffer.get())->data();
+  return {
+      reinterpret_cast<T *>(data), static_cast<Eigen::Index>(rows), static_cast<Eigen::Index>(cols)
+  };
+}
+
+// Calls fn with the storage of `buffer` as a float expression, which widens F16 and BF16
+// elements as they are read
+template <class Fn>
+void visit_float(Buffer const &buffer, Fn const &fn)
+{
+  switch (buffer.dtype())
+  {
+  case DType::F16:
+    fn(reduced_map<Eigen::half>(buffer).cast<float>());
+    break;
+  case DType::BF16:
+    fn(reduced_map<Eigen::bfloat16>(buffer).cast<float>());
+    break;
+  default:
+    fn(eigen_map(buffer));
+    break;
+  }
+}
+
+// Float copy of `buffer` in the shape it is seen with
+EigenBuffer to_float(Buffer const &buffer)
+{
+  EigenBuffer out;
+  visit_float(
+      buffer,
+      [&](auto const &eigen_buffer)
+      {
+        if (buffer.is_transposed())
+        {
+          out = eigen_buffer.transpose();
+          return;
+        }
+        out = eigen_buffer;
+      }
+  );
+  return out;
+}
+
+// Products with an F16 or BF16 operand. A reduced precision matrix times a vector is widened as
+// the coefficient-based product reads it, other operands are widened once into float matrices.
+void mixed_mul(Buffer const &a, Buffer const &b, Buffer &c)
+{
+  auto eigen_c = eigen_map(c);
+  if (b.shape().cols == 1 and a.dtype() != DType::F32)
+  {
+    visit_float(
+        a,
+        [&](auto const &eigen_a)
+        {
+          visit_float(
+              b, [&](auto const &eigen_b) { eigen_c.noalias() = eigen_a.lazyProduct(eigen_b); }
+          );
+        }
+    );
+    return;
+  }
+  eigen_c.noalias() = to_float(a) * to_float(b);
+}
+
 struct Add
 {
-  [[nodiscard]] EigenBuffer operator()(EigenBuffer const &a, EigenBuffer const &b) const
+  template <class T>
+  [[nodiscard]] EigenMatrix<T>
+  operator()(EigenConstMap<T> const &a, EigenConstMap<T> const &b) const
   {
     return a + b;
   }
 
-  [[nodiscard]] EigenBuffer operator()(EigenBuffer const &a, float const b) const
+  template <class T>
+  [[nodiscard]] EigenMatrix<T> operator()(EigenConstMap<T> const &a, T const b) const
   {
     return a.array() + b;
   }
@@ -27,12 +169,15 @@ struct Add
 
 struct Sub
 {
-  [[nodiscard]] EigenBuffer operator()(EigenBuffer const &a, EigenBuffer const &b) const
+  template <class T>
+  [[nodiscard]] EigenMatrix<T>
+  operator()(EigenConstMap<T> const &a, EigenConstMap<T> const &b) const
   {
     return a - b;
   }
 
-  [[nodiscard]] EigenBuffer operator()(EigenBuffer const &a, float const b) const
+  template <class T>
+  [[nodiscard]] EigenMatrix<T> operator()(EigenConstMap<T> const &a, T const b) const
   {
     return a.array() - b;
   }
@@ -40,22 +185,34 @@ struct Sub
 
 struct Mul
 {
-  [[nodiscard]] EigenBuffer operator()(EigenBuffer const &a, EigenBuffer const &b) const
+  template <class T>
+  [[nodiscard]] EigenMatrix<T>
+  operator()(EigenConstMap<T> const &a, EigenConstMap<T> const &b) const
   {
     return a.cwiseProduct(b);
   }
 
-  [[nodiscard]] EigenBuffer operator()(EigenBuffer const &a, float const b) const { return a * b; }
+  template <class T>
+  [[nodiscard]] EigenMatrix<T> operator()(EigenConstMap<T> const &a, T const b) const
+  {
+    return a * b;
+  }
 };
 
 struct Div
 {
-  [[nodiscard]] EigenBuffer operator()(EigenBuffer const &a, EigenBuffer const &b) const
+  template <class T>
+  [[nodiscard]] EigenMatrix<T>
+  operator()(EigenConstMap<T> const &a, EigenConstMap<T> const &b) const
   {
     return a.cwiseQuotient(b);
   }
 
-  [[nodiscard]] EigenBuffer operator()(EigenBuffer const &a, float const b) const { return a / b; }
+  template <class T>
+  [[nodiscard]] EigenMatrix<T> operator()(EigenConstMap<T> const &a, T const b) const
+  {
+    return a / b;
+  }
 };
 
 template <class Op>
@@ -63,11 +220,18 @@ void cwisem_op(Buffer const &a, Buffer const &b, Buffer &c, Op const &op)
 {
   assert_same_shape(a, b, c);
 
-  auto const &eigen_a = *static_cast<EigenBuffer const *>(a.get());
-  auto const &eigen_b = *static_cast<EigenBuffer const *>(b.get());
-  auto &eigen_c       = *static_cast<EigenBuffer *>(c.get());
-
-  eigen_c = op(eigen_a, eigen_b);
+  visit_precision(
+      a.dtype(),
+      [&](auto const precision)
+      {
+        using T            = typename decltype(precision)::type;
+        auto const eigen_a = eigen_map<T>(a);
+        auto const eigen_b = eigen_map<T>(b);
+        auto eigen_c       = eigen_map<T>(c);
+
+        eigen_c = op(eigen_a, eigen_b);
+      }
+  );
 }
 
 template <class Op>
@@ -75,12 +239,49 @@ void cwises_op(Buffer const &a, Buffer const &b, Buffer &c, Op const &op)
 {
   assert_compatible_sop(a, b, c);
 
-  auto const &eigen_a = *static_cast<EigenBuffer const *>(a.get());
-  auto const &eigen_b = *static_cast<EigenBuffer const *>(b.get());
-  auto &eigen_c       = *static_cast<EigenBuffer *>(c.get());
+  visit_precision(
+      a.dtype(),
+      [&](auto const precision)
+      {
+        using T            = typename decltype(precision)::type;
+        auto const eigen_a = eigen_map<T>(a);
+        auto const eigen_b = eigen_map<T>(b);
+        auto eigen_c       = eigen_map<T>(c);
+
+        auto const scalar_b = eigen_b(0);
+        eigen_c             = op(eigen_a, scalar_b);
+      }
+  );
+}
+
+template <class T>
+void expr_kernel(ExprOp const op, T const *a, T const *b, T *c, size_t const n)
+{
+  using Array = Eigen::Array<T, Eigen::Dynamic, 1>;
 
-  auto const scalar_b = eigen_b(0);
-  eigen_c             = op(eigen_a, scalar_b);
+  auto const size = static_cast<Eigen::Index>(n);
+  Eigen::Map<Array const> const eigen_a(a, size);
+  Eigen::Map<Array const> const eigen_b(b, size);
+  Eigen::Map<Array> eigen_c(c, size);
+
+  switch (op)
+  {
+  case ExprOp::ADD:
+    eigen_c = eigen_a + eigen_b;
+    break;
+  case ExprOp::SUB:
+    eigen_c = eigen_a - eigen_b;
+    break;
+  case ExprOp::MUL:
+    eigen_c = eigen_a * eigen_b;
+    break;
+  case ExprOp::DIV_OR_ZERO:
+    eigen_c = (eigen_b == T{0.0}).select(T{0.0}, eigen_a / eigen_b);
+    break;
+  default:
+    eigen_c = eigen_a / eigen_b;
+    break;
+  }
 }
 
 } // namespace
@@ -99,11 +300,40 @@ void EigenDevice::mul(Buffer const &a, Buffer const &b, Buffer &c) const
 {
   assert_compatible_mul(a, b, c);
 
-  auto const &eigen_a = *static_cast<EigenBuffer const *>(a.get());
-  auto const &eigen_b = *static_cast<EigenBuffer const *>(b.get());
-  auto &eigen_c       = *static_cast<EigenBuffer *>(c.get());
+  if (is_reduced(a.dtype()) or is_reduced(b.dtype()))
+  {
+    mixed_mul(a, b, c);
+    return;
+  }
 
-  eigen_c = eigen_a * eigen_b;
+  visit_precision(
+      c.dtype(),
+      [&](auto const precision)
+      {
+        using T            = typename decltype(precision)::type;
+        auto const eigen_a = eigen_map<T>(a);
+        auto const eigen_b = eigen_map<T>(b);
+        auto eigen_c       = eigen_map<T>(c);
+
+        // Transposed operands are multiplied through transposed expressions, without a copy
+        if (a.is_transposed() and b.is_transposed())
+        {
+          eigen_c.noalias() = eigen_a.transpose() * eigen_b.transpose();
+        }
+        else if (a.is_transposed())
+        {
+          eigen_c.noalias() = eigen_a.transpose() * eigen_b;
+        }
+        else if (b.is_transposed())
+        {
+          eigen_c.noalias() = eigen_a * eigen_b.transpose();
+        }
+        else
+        {
+          eigen_c.noalias() = eigen_a * eigen_b;
+        }
+      }
+  );
 }
 
 void EigenDevice::cmul(Buffer const &a, Buffer const &b, Buffer &c) const
@@ -136,51 +366,465 @@ void EigenDevice::sdiv(Buffer const &a, Buffer const &b, Buffer &c) const
   cwises_op(a, b, c, Div{});
 }
 
+void EigenDevice::dot(Buffer const &a, Buffer const &b, Buffer &c) const
+{
+  assert_compatible_dot(a, b, c);
+
+  if (c.dtype() == DType::F64)
+  {
+    eigen_map<double>(c)(0) = eigen_map<double>(a).cwiseProduct(eigen_map<double>(b)).sum();
+    return;
+  }
+
+  auto eigen_c = eigen_map(c);
+
+  // F16 and BF16 operands are widened as the reduction reads them
+  visit_float(
+      a,
+      [&](auto const &eigen_a)
+      {
+        visit_float(
+            b, [&](auto const &eigen_b) { eigen_c(0) = eigen_a.cwiseProduct(eigen_b).sum(); }
+        );
+      }
+  );
+}
+
+void EigenDevice::axpy(Buffer const &alpha, Buffer const &x, Buffer &y) const
+{
+  assert_compatible_axpy(alpha, x, y);
+
+  visit_precision(
+      x.dtype(),
+      [&](auto const precision)
+      {
+        using T                = typename decltype(precision)::type;
+        auto const eigen_alpha = eigen_map<T>(alpha);
+        auto const eigen_x     = eigen_map<T>(x);
+        auto eigen_y           = eigen_map<T>(y);
+
+        eigen_y += eigen_alpha(0) * eigen_x;
+      }
+  );
+}
+
+void EigenDevice::axpby(Buffer const &alpha, Buffer const &x, Buffer const &beta, Buffer &y) const
+{
+  assert_compatible_axpby(alpha, x, beta, y);
+
+  visit_precision(
+      x.dtype(),
+      [&](auto const precision)
+      {
+        using T                = typename decltype(precision)::type;
+        auto const eigen_alpha = eigen_map<T>(alpha);
+        auto const eigen_x     = eigen_map<T>(x);
+        auto const eigen_beta  = eigen_map<T>(beta);
+        auto eigen_y           = eigen_map<T>(y);
+
+        eigen_y = (eigen_alpha(0) * eigen_x) + (eigen_beta(0) * eigen_y);
+      }
+  );
+}
+
+void EigenDevice::batched_cg(
+    Buffer const &a,
+    Buffer const &b,
+    Buffer &x,
+    size_t const batch,
+    size_t const max_iter,
+    float const tol
+) const
+{
+  assert_compatible_batched_solve(a, b, x, batch);
+
+  auto const *data_a = static_cast<EigenBuffer const *>(a.get())->data();
+  auto const *data_b = static_cast<EigenBuffer const *>(b.get())->data();
+  auto *data_x       = static_cast<EigenBuffer *>(x.get())->data();
+
+  auto const n = static_cast<Eigen::Index>(a.shape().cols);
+  EigenVector r(n);
+  EigenVector p(n);
+  EigenVector ap(n);
+  for (Eigen::Index s{0}; s < static_cast<Eigen::Index>(batch); s++)
+  {
+    Eigen::Map<EigenBuffer const> const eigen_a(data_a + (s * n * n), n, n);
+    Eigen::Map<EigenVector const> const eigen_b(data_b + (s * n), n);
+    Eigen::Map<EigenVector> eigen_x(data_x + (s * n), n);
+
+    r.noalias() = eigen_b - (eigen_a * eigen_x);
+    p           = r;
+    auto rr     = r.squaredNorm();
+    for (size_t iter{0}; iter < max_iter and std::sqrt(rr) >= tol; iter++)
+    {
+      ap.noalias()     = eigen_a * p;
+      auto const alpha = rr / p.dot(ap);
+
+      eigen_x += alpha * p;
+      r -= alpha * ap;
+
+      auto const rr_next = r.squaredNorm();
+      p                  = r + ((rr_next / rr) * p);
+      rr                 = rr_next;
+    }
+  }
+}
+
+void EigenDevice::batched_cholesky(
+    Buffer const &a, Buffer const &b, Buffer &x, size_t const batch
+) const
+{
+  assert_compatible_batched_solve(a, b, x, batch);
+
+  auto const *data_a = static_cast<EigenBuffer const *>(a.get())->data();
+  auto const *data_b = static_cast<EigenBuffer const *>(b.get())->data();
+  auto *data_x       = static_cast<EigenBuffer *>(x.get())->data();
+
+  auto const n = static_cast<Eigen::Index>(a.shape().cols);
+  Eigen::LLT<EigenBuffer> llt(n);
+  for (Eigen::Index s{0}; s < static_cast<Eigen::Index>(batch); s++)
+  {
+    Eigen::Map<EigenBuffer const> const eigen_a(data_a + (s * n * n), n, n);
+    Eigen::Map<EigenVector const> const eigen_b(data_b + (s * n), n);
+    Eigen::Map<EigenVector> eigen_x(data_x + (s * n), n);
+
+    llt.compute(eigen_a);
+    eigen_x = llt.solve(eigen_b);
+  }
+}
+
+void EigenDevice::spmv(SparseBuffer const &a, Buffer const &x, Buffer &y) const
+{
+  assert_compatible_spmv(a, x, y);
+
+  auto const &eigen_a = *static_cast<EigenSparse const *>(a.get());
+  auto const eigen_x  = eigen_map(x);
+  auto eigen_y        = eigen_map(y);
+
+  eigen_y.noalias() = eigen_a * eigen_x;
+}
+
+void EigenDevice::spmm(SparseBuffer const &a, Buffer const &x, Buffer &y) const
+{
+  assert_compatible_spmm(a, x, y);
+
+  auto const &eigen_a = *static_cast<EigenSparse const *>(a.get());
+  auto const eigen_x  = eigen_map(x);
+  auto eigen_y        = eigen_map(y);
+
+  eigen_y.noalias() = eigen_a * eigen_x;
+}
+
+void EigenDevice::batched_mul(Buffer const &a, Buffer const &b, Buffer &c, size_t const batch) const
+{
+  assert_compatible_batched_mul(a, b, c, batch);
+
+  auto const *data_a = static_cast<EigenBuffer const *>(a.get())->data();
+  auto const *data_b = static_cast<EigenBuffer const *>(b.get())->data();
+  auto *data_c       = static_cast<EigenBuffer *>(c.get())->data();
+
+  auto const m = static_cast<Eigen::Index>(a.shape().rows / batch);
+  auto const k = static_cast<Eigen::Index>(a.shape().cols);
+  auto const n = static_cast<Eigen::Index>(b.shape().cols);
+  for (Eigen::Index s{0}; s < static_cast<Eigen::Index>(batch); s++)
+  {
+    Eigen::Map<EigenBuffer const> const a_s(data_a + (s * m * k), m, k);
+    Eigen::Map<EigenBuffer const> const b_s(data_b + (s * k * n), k, n);
+    Eigen::Map<EigenBuffer> c_s(data_c + (s * m * n), m, n);
+    c_s.noalias() = a_s * b_s;
+  }
+}
+
+void EigenDevice::broadcast(ExprOp const op, Buffer const &a, Buffer const &b, Buffer &c) const
+{
+  assert_compatible_broadcast(a, b, c);
+
+  visit_precision(
+      a.dtype(),
+      [&](auto const precision)
+      {
+        using T            = typename decltype(precision)::type;
+        auto const eigen_a = eigen_map<T>(a);
+        auto eigen_c       = eigen_map<T>(c);
+        auto const *data_b = static_cast<EigenMatrix<T> const *>(b.get())->data();
+
+        // Eigen repeats the vector over the matrix without expanding it
+        auto const apply = [&](auto const &broadcast_a, auto const &vector)
+        {
+          switch (op)
+          {
+          case ExprOp::ADD:
+            eigen_c.array() = broadcast_a + vector;
+            break;
+          case ExprOp::SUB:
+            eigen_c.array() = broadcast_a - vector;
+            break;
+          case ExprOp::MUL:
+            eigen_c.array() = broadcast_a * vector;
+            break;
+          default:
+            eigen_c.array() = broadcast_a / vector;
+            break;
+          }
+        };
+
+        if (broadcast_per_row(a, b))
+        {
+          Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1> const> const column(
+              data_b, eigen_a.rows()
+          );
+          apply(eigen_a.array().colwise(), column);
+        }
+        else
+        {
+          Eigen::Map<Eigen::Array<T, 1, Eigen::Dynamic> const> const row(data_b, eigen_a.cols());
+          apply(eigen_a.array().rowwise(), row);
+        }
+      }
+  );
+}
+
+void EigenDevice::eval(Expression const &expr, Buffer &out) const
+{
+  assert_compatible_eval(expr, out);
+
+  visit_precision(
+      out.dtype(),
+      [&](auto const precision)
+      {
+        using T = typename decltype(precision)::type;
+        std::vector<T const *> inputs;
+        inputs.reserve(expr.operands().size());
+        for (auto const *operand : expr.operands())
+        {
+          inputs.push_back(static_cast<EigenMatrix<T> const *>(operand->get())->data());
+        }
+        auto eigen_out = eigen_map<T>(out);
+
+        eval_chunked(expr, inputs, eigen_out.data(), 0, out.size(), expr_kernel<T>);
+      }
+  );
+}
+
 Buffer EigenDevice::new_buffer(std::vector<float> data, Shape shape) const
 {
-  return Buffer{
-      HandlePtr{
-          new EigenBuffer(
-              Eigen::Map<EigenBuffer>(
-                  data.data(),
-                  static_cast<Eigen::Index>(shape.rows),
-                  static_cast<Eigen::Index>(shape.cols)
-              )
-          ),
-          [](void *ptr) -> void
-          { std::default_delete<EigenBuffer>{}(static_cast<EigenBuffer *>(ptr)); }
-      },
-      shape,
-      EigenDevice::s_type
+  auto buffer = this->new_empty_buffer(shape);
+  *static_cast<EigenBuffer *>(buffer.get()) = Eigen::Map<EigenBuffer>(
+      data.data(), static_cast<Eigen::Index>(shape.rows), static_cast<Eigen::Index>(shape.cols)
+  );
+  return buffer;
+}
+
+Buffer EigenDevice::new_f64_buffer(std::vector<double> data, Shape shape) const
+{
+  auto buffer = this->new_typed_buffer(shape, DType::F64);
+  *static_cast<EigenDoubleBuffer *>(buffer.get()) = Eigen::Map<EigenDoubleBuffer>(
+      data.data(), static_cast<Eigen::Index>(shape.rows), static_cast<Eigen::Index>(shape.cols)
+  );
+  return buffer;
+}
+
+Buffer EigenDevice::new_buffer_with_shape(Shape shape) const
+{
+  auto buffer = this->new_empty_buffer(shape);
+  static_cast<EigenBuffer *>(buffer.get())->setZero();
+  return buffer;
+}
+
+Buffer EigenDevice::new_empty_buffer(Shape shape) const
+{
+  return new_storage(this->m_cache, shape, EigenDevice::s_type, DType::F32);
+}
+
+Buffer EigenDevice::new_typed_buffer(Shape shape, DType dtype) const
+{
+  switch (dtype)
+  {
+  case DType::F32:
+    return this->new_empty_buffer(shape);
+  case DType::F64:
+    return new_storage(this->m_double_cache, shape, EigenDevice::s_type, dtype);
+  default:
+    return new_storage(this->m_reduced_cache, shape, EigenDevice::s_type, dtype);
+  }
+}
+
+void EigenDevice::convert(Buffer const &from, Buffer &to) const
+{
+  assert_compatible_convert(from, to);
+
+  if (from.dtype() == to.dtype())
+  {
+    this->copy_buffer(from, to);
+    return;
+  }
+  if (to.dtype() == DType::F64)
+  {
+    visit_float(
+        from,
+        [&](auto const &eigen_from) { eigen_map<double>(to) = eigen_from.template cast<double>(); }
+    );
+    return;
+  }
+
+  // Eigen::half and Eigen::bfloat16 round to nearest even, F64 elements are rounded to float first
+  auto const narrow = [&](auto const &eigen_from)
+  {
+    switch (to.dtype())
+    {
+    case DType::F16:
+      reduced_map<Eigen::half>(to) = eigen_from.template cast<Eigen::half>();
+      break;
+    case DType::BF16:
+      reduced_map<Eigen::bfloat16>(to) = eigen_from.template cast<Eigen::bfloat16>();
+      break;
+    default:
+      eigen_map(to) = eigen_from;
+      break;
+    }
   };
+  if (from.dtype() == DType::F64)
+  {
+    narrow(eigen_map<double>(from).cast<float>());
+    return;
+  }
+  visit_float(from, narrow);
+}
+
+SparseBuffer EigenDevice::new_csr(Shape shape, CsrData csr) const
+{
+  assert_valid_csr(shape, csr);
+
+  auto const nnz = csr.values.size();
+  Eigen::Map<EigenSparse const> const map(
+      static_cast<Eigen::Index>(shape.rows),
+      static_cast<Eigen::Index>(shape.cols),
+      static_cast<Eigen::Index>(nnz),
+      csr.row_ptr.data(),
+      csr.col_idx.data(),
+      csr.values.data()
+  );
+  return SparseBuffer{std::make_shared<EigenSparse>(map), shape, nnz, EigenDevice::s_type};
+}
+
+AllocatorStats EigenDevice::allocator_stats() const
+{
+  auto stats = this->m_cache.stats();
+  stats += this->m_reduced_cache.stats();
+  stats += this->m_double_cache.stats();
+  return stats;
+}
+
+void EigenDevice::trim() const
+{
+  this->m_cache.trim();
+  this->m_reduced_cache.trim();
+  this->m_double_cache.trim();
 }
 
 void EigenDevice::copy_buffer(Buffer const &from, Buffer &to) const
 {
   assert_compatible_copy(from, to);
 
-  auto const &eigen_from = *static_cast<EigenBuffer const *>(from.get());
-  auto &eigen_to         = *static_cast<EigenBuffer *>(to.get());
+  if (is_reduced(from.dtype()))
+  {
+    reduced_map<uint16_t>(to) = reduced_map<uint16_t>(from);
+    return;
+  }
 
-  eigen_to = eigen_from;
+  visit_precision(
+      from.dtype(),
+      [&](auto const precision)
+      {
+        using T               = typename decltype(precision)::type;
+        auto const eigen_from = eigen_map<T>(from);
+        auto eigen_to         = eigen_map<T>(to);
+
+        eigen_to = eigen_from;
+      }
+  );
 }
 
 void EigenDevice::transpose(Buffer const &from, Buffer &to) const
 {
   assert_compatible_transpose(from, to);
 
-  auto const &eigen_from = *static_cast<EigenBuffer const *>(from.get());
-  auto &eigen_to         = *static_cast<EigenBuffer *>(to.get());
-
-  eigen_to = eigen_from.transpose();
+  visit_precision(
+      from.dtype(),
+      [&](auto const precision)
+      {
+        using T               = typename decltype(precision)::type;
+        auto const eigen_from = eigen_map<T>(from);
+        auto eigen_to         = eigen_map<T>(to);
+
+        eigen_to = eigen_from.transpose();
+      }
+  );
 }
 
 std::vector<float> EigenDevice::cpu(Buffer const &buffer) const
 {
-  auto const &eigen_buffer = *static_cast<EigenBuffer const *>(buffer.get());
+  if (buffer.dtype() != DType::F32)
+  {
+    std::vector<float> host(buffer.size());
+    auto const [rows, cols] = buffer.storage_shape();
+    EigenMap<float> eigen_host(
+        host.data(), static_cast<Eigen::Index>(rows), static_cast<Eigen::Index>(cols)
+    );
+    if (buffer.dtype() == DType::F64)
+    {
+      eigen_host = eigen_map<double>(buffer).cast<float>();
+      return host;
+    }
+    visit_float(buffer, [&](auto const &eigen_buffer) { eigen_host = eigen_buffer; });
+    return host;
+  }
+
+  auto const eigen_buffer = eigen_map(buffer);
   return {eigen_buffer.data(), std::next(eigen_buffer.data(), eigen_buffer.size())};
 }
 
+std::vector<double> EigenDevice::cpu_f64(Buffer const &buffer) const
+{
+  if (buffer.dtype() == DType::F64)
+  {
+    auto const eigen_buffer = eigen_map<double>(buffer);
+    return {eigen_buffer.data(), std::next(eigen_buffer.data(), eigen_buffer.size())};
+  }
+
+  auto const host = this->cpu(buffer);
+  return {host.cbegin(), host.cend()};
+}
+
+float EigenDevice::read_scalar(Buffer const &buffer) const
+{
+  if (buffer.dtype() == DType::F64)
+  {
+    return static_cast<float>(*static_cast<EigenDoubleBuffer const *>(buffer.get())->data());
+  }
+  if (buffer.dtype() != DType::F32)
+  {
+    float value{0.0};
+    visit_float(buffer, [&value](auto const &eigen_buffer) { value = eigen_buffer(0, 0); });
+    return value;
+  }
+  return *static_cast<EigenBuffer const *>(buffer.get())->data();
+}
+
+double EigenDevice::read_scalar_f64(Buffer const &buffer) const
+{
+  if (buffer.dtype() == DType::F64)
+  {
+    return *static_cast<EigenDoubleBuffer const *>(buffer.get())->data();
+  }
+  return this->read_scalar(buffer);
+}
+
+float *EigenDevice::host_data(Buffer &buffer) const
+{
+  return static_cast<EigenBuffer *>(buffer.get())->data();
+}
+
 void EigenDevice::sync([[maybe_unused]] Buffer const &buffer) const {}
 
 } // namespace gpu_playground::backend
@@ -74,6 +74,9 @@ struct MetalDevice::Impl
     this->add_ps("mat_smul");
     this->add_ps("mat_sdiv");
     this->add_ps("mat_trans");
+    this->add_ps("mat_dot");
+    this->add_ps("mat_axpy");
+    this->add_ps("mat_axpby");
   }
 
   Impl(Impl const &)            = delete;
@@ -197,6 +200,13 @@ void MetalDevice::sub(Buffer const &a, Buffer const &b, Buffer &c) const
 
 void MetalDevice::mul(Buffer const &a, Buffer const &b, Buffer &c) const
 {
+  // The kernel only reads row-major operands
+  if (a.is_transposed() or b.is_transposed())
+  {
+    this->mul(this->contiguous(a), this->contiguous(b), c);
+    return;
+  }
+
   @autoreleasepool
   {
     assert_compatible_mul(a, b, c);
@@ -264,6 +274,115 @@ void MetalDevice::sdiv(Buffer const &a, Buffer const &b, Buffer &c) const
   this->pimpl->cwises_op(a, b, c, "mat_sdiv");
 }
 
+void MetalDevice::dot(Buffer const &a, Buffer const &b, Buffer &c) const
+{
+  @autoreleasepool
+  {
+    assert_compatible_dot(a, b, c);
+
+    auto const n = static_cast<uint32_t>(a.size());
+
+    auto const *mtl_a = static_cast<MetalBuffer const *>(a.get());
+    auto const *mtl_b = static_cast<MetalBuffer const *>(b.get());
+    auto *mtl_c       = static_cast<MetalBuffer *>(c.get());
+
+    id<MTLCommandBuffer> cmd = [this->pimpl->queue commandBuffer];
+    [cmd retain];
+
+    id<MTLComputeCommandEncoder> enc = [cmd computeCommandEncoder];
+
+    [enc setComputePipelineState:this->pimpl->ps["mat_dot"]];
+    [enc setBuffer:mtl_a->buffer offset:0 atIndex:0];
+    [enc setBuffer:mtl_b->buffer offset:0 atIndex:1];
+    [enc setBuffer:mtl_c->buffer offset:0 atIndex:2];
+    [enc setBytes:&n length:sizeof(n) atIndex:3];
+
+    // A single threadgroup reduces the whole vector, its size must match the shader scratch
+    MTLSize const tgSize = MTLSizeMake(256, 1, 1);
+
+    [enc dispatchThreadgroups:MTLSizeMake(1, 1, 1) threadsPerThreadgroup:tgSize];
+
+    [enc endEncoding];
+    [cmd commit];
+
+    cmd_swap(mtl_c->last_cmd, cmd);
+  }
+}
+
+void MetalDevice::axpy(Buffer const &alpha, Buffer const &x, Buffer &y) const
+{
+  @autoreleasepool
+  {
+    assert_compatible_axpy(alpha, x, y);
+
+    auto const *mtl_alpha = static_cast<MetalBuffer const *>(alpha.get());
+    auto const *mtl_x     = static_cast<MetalBuffer const *>(x.get());
+    auto *mtl_y           = static_cast<MetalBuffer *>(y.get());
+
+    id<MTLCommandBuffer> cmd = [this->pimpl->queue commandBuffer];
+    [cmd retain];
+
+    id<MTLComputeCommandEncoder> enc = [cmd computeCommandEncoder];
+
+    auto const &ps = this->pimpl->ps["mat_axpy"];
+    [enc setComputePipelineState:ps];
+    [enc setBuffer:mtl_alpha->buffer offset:0 atIndex:0];
+    [enc setBuffer:mtl_x->buffer offset:0 atIndex:1];
+    [enc setBuffer:mtl_y->buffer offset:0 atIndex:2];
+
+    NSUInteger const n = x.size();
+
+    MTLSize const gridSize        = MTLSizeMake(n, 1, 1);
+    NSUInteger const tgSize       = std::min<NSUInteger>(ps.maxTotalThreadsPerThreadgroup, n);
+    MTLSize const threadgroupSize = MTLSizeMake(tgSize, 1, 1);
+
+    [enc dispatchThreads:gridSize threadsPerThreadgroup:threadgroupSize];
+
+    [enc endEncoding];
+    [cmd commit];
+
+    cmd_swap(mtl_y->last_cmd, cmd);
+  }
+}
+
+void MetalDevice::axpby(Buffer const &alpha, Buffer const &x, Buffer const &beta, Buffer &y) const
+{
+  @autoreleasepool
+  {
+    assert_compatible_axpby(alpha, x, beta, y);
+
+    auto const *mtl_alpha = static_cast<MetalBuffer const *>(alpha.get());
+    auto const *mtl_x     = static_cast<MetalBuffer const *>(x.get());
+    auto const *mtl_beta  = static_cast<MetalBuffer const *>(beta.get());
+    auto *mtl_y           = static_cast<MetalBuffer *>(y.get());
+
+    id<MTLCommandBuffer> cmd = [this->pimpl->queue commandBuffer];
+    [cmd retain];
+
+    id<MTLComputeCommandEncoder> enc = [cmd computeCommandEncoder];
+
+    auto const &ps = this->pimpl->ps["mat_axpby"];
+    [enc setComputePipelineState:ps];
+    [enc setBuffer:mtl_alpha->buffer offset:0 atIndex:0];
+    [enc setBuffer:mtl_x->buffer offset:0 atIndex:1];
+    [enc setBuffer:mtl_beta->buffer offset:0 atIndex:2];
+    [enc setBuffer:mtl_y->buffer offset:0 atIndex:3];
+
+    NSUInteger const n = x.size();
+
+    MTLSize const gridSize        = MTLSizeMake(n, 1, 1);
+    NSUInteger const tgSize       = std::min<NSUInteger>(ps.maxTotalThreadsPerThreadgroup, n);
+    MTLSize const threadgroupSize = MTLSizeMake(tgSize, 1, 1);
+
+    [enc dispatchThreads:gridSize threadsPerThreadgroup:threadgroupSize];
+
+    [enc endEncoding];
+    [cmd commit];
+
+    cmd_swap(mtl_y->last_cmd, cmd);
+  }
+}
+
 Buffer MetalDevice::new_buffer(std::vector<float> data, Shape shape) const
 {
   assert(this->pimpl->device != nil);
@@ -362,6 +481,15 @@ std::vector<float> MetalDevice::cpu(Buffer const &buffer) const
   return result;
 }
 
+float MetalDevice::read_scalar(Buffer const &buffer) const
+{
+  auto const *mtl_buf = static_cast<MetalBuffer const *>(buffer.get());
+
+  cmd_wait_release(mtl_buf->last_cmd);
+
+  return *static_cast<float const *>(mtl_buf->buffer.contents);
+}
+
 void MetalDevice::sync(Buffer const &buffer) const
 {
   auto const *mtl_buf = static_cast<MetalBuffer const *>(buffer.get());
@@ -0,0 +1,37 @@
+#include <metal_stdlib>
+
+using namespace metal;
+
+kernel void mat_dot(
+    const device float* a,
+    const device float* b,
+    device float* c,
+    constant uint& n,
+    uint id [[thread_position_in_threadgroup]],
+    uint size [[threads_per_threadgroup]]
+)
+{
+    threadgroup float partial[256];
+
+    float support{0.0};
+    for (uint i = id; i < n; i += size)
+    {
+      support = fma(a[i], b[i], support);
+    }
+    partial[id] = support;
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    for (uint stride = size / 2; stride > 0; stride /= 2)
+    {
+      if (id < stride)
+      {
+        partial[id] += partial[id + stride];
+      }
+      threadgroup_barrier(mem_flags::mem_threadgroup);
+    }
+
+    if (id == 0)
+    {
+      c[0] = partial[0];
+    }
+}
@@ -1,63 +1,241 @@
+#include <algorithm>
 #include <cmath>
+#include <utility>
 
 #include "serial_device.hpp"
 
 namespace gpu_playground::backend
 {
 
-using SerialBuffer = std::vector<float>;
-
 namespace
 {
 
 struct Add
 {
-  [[nodiscard]] constexpr float operator()(float const a, float const b) const { return a + b; }
+  template <class T>
+  [[nodiscard]] constexpr T operator()(T const a, T const b) const
+  {
+    return a + b;
+  }
 };
 
 struct Sub
 {
-  [[nodiscard]] constexpr float operator()(float const a, float const b) const { return a - b; }
+  template <class T>
+  [[nodiscard]] constexpr T operator()(T const a, T const b) const
+  {
+    return a - b;
+  }
 };
 
 struct Mul
 {
-  [[nodiscard]] constexpr float operator()(float const a, float const b) const { return a * b; }
+  template <class T>
+  [[nodiscard]] constexpr T operator()(T const a, T const b) const
+  {
+    return a * b;
+  }
 };
 
 struct Div
 {
-  [[nodiscard]] constexpr float operator()(float const a, float const b) const { return a / b; }
+  template <class T>
+  [[nodiscard]] constexpr T operator()(T const a, T const b) const
+  {
+    return a / b;
+  }
 };
 
-template <class Op>
-void cwisem_op(Buffer const &a, Buffer const &b, Buffer &c, Op const &op)
+struct DivOrZero
 {
-  assert_same_shape(a, b, c);
+  template <class T>
+  [[nodiscard]] constexpr T operator()(T const a, T const b) const
+  {
+    return b == T{0.0} ? T{0.0} : a / b;
+  }
+};
 
-  auto const &serial_a = *static_cast<SerialBuffer const *>(a.get());
-  auto const &serial_b = *static_cast<SerialBuffer const *>(b.get());
-  auto &serial_c       = *static_cast<SerialBuffer *>(c.get());
+// Storage of a buffer of T elements, float for F32 and double for F64
+template <class T>
+std::vector<T> const &storage(Buffer const &buffer)
+{
+  return *static_cast<std::vector<T> const *>(buffer.get());
+}
+
+template <class T>
+std::vector<T> &storage(Buffer &buffer)
+{
+  return *static_cast<std::vector<T> *>(buffer.get());
+}
+
+// Elements of a buffer read in their own precision for F32 and F64, and as floats for F16 and BF16
+template <class T>
+struct Elements
+{
+  T const *data;
 
-  for (size_t i{0}; i < a.size(); i++)
+  [[nodiscard]] T operator[](size_t const i) const { return this->data[i]; }
+};
+
+template <DType dtype>
+struct ReducedElements
+{
+  uint16_t const *data;
+
+  [[nodiscard]] float operator[](size_t const i) const
   {
-    serial_c[i] = op(serial_a[i], serial_b[i]);
+    return reduced_to_float(dtype, this->data[i]);
+  }
+};
+
+// Calls fn with the elements of `buffer`, so that kernels are instantiated once per dtype
+template <class Fn>
+void visit_elements(Buffer const &buffer, Fn const &fn)
+{
+  auto const *reduced = static_cast<SerialReducedBuffer const *>(buffer.get());
+  switch (buffer.dtype())
+  {
+  case DType::F16:
+    fn(ReducedElements<DType::F16>{reduced->data()});
+    break;
+  case DType::BF16:
+    fn(ReducedElements<DType::BF16>{reduced->data()});
+    break;
+  case DType::F64:
+    fn(Elements<double>{storage<double>(buffer).data()});
+    break;
+  default:
+    fn(Elements<float>{storage<float>(buffer).data()});
+    break;
   }
 }
 
+// Buffer of `dtype` elements on storage from `cache`, sized to the elements of `shape`
+template <class Storage>
+Buffer new_storage(
+    CachingAllocator<Storage> const &cache,
+    Shape const shape,
+    DeviceType const type,
+    DType const dtype
+)
+{
+  using T         = typename Storage::value_type;
+  auto const size = shape.rows * shape.cols;
+  auto const make = [size](size_t const bytes) -> Storage *
+  {
+    auto *data = new Storage();
+    data->reserve(bytes / sizeof(T));
+    data->resize(size);
+    return data;
+  };
+  return Buffer{
+      cache.allocate(size * sizeof(T), make, [size](Storage &data) -> void { data.resize(size); }),
+      shape,
+      type,
+      dtype
+  };
+}
+
+template <class Op>
+void cwisem_op(Buffer const &a, Buffer const &b, Buffer &c, Op const &op)
+{
+  assert_same_shape(a, b, c);
+
+  visit_precision(
+      a.dtype(),
+      [&](auto const precision)
+      {
+        using T              = typename decltype(precision)::type;
+        auto const &serial_a = storage<T>(a);
+        auto const &serial_b = storage<T>(b);
+        auto &serial_c       = storage<T>(c);
+
+        for (size_t i{0}; i < a.size(); i++)
+        {
+          serial_c[i] = op(serial_a[i], serial_b[i]);
+        }
+      }
+  );
+}
+
 template <class Op>
 void cwises_op(Buffer const &a, Buffer const &b, Buffer &c, Op const &op)
 {
   assert_compatible_sop(a, b, c);
 
-  auto const &serial_a = *static_cast<SerialBuffer const *>(a.get());
-  auto const &serial_b = *static_cast<SerialBuffer const *>(b.get());
-  auto &serial_c       = *static_cast<SerialBuffer *>(c.get());
+  visit_precision(
+      a.dtype(),
+      [&](auto const precision)
+      {
+        using T              = typename decltype(precision)::type;
+        auto const &serial_a = storage<T>(a);
+        auto &serial_c       = storage<T>(c);
+
+        auto const scalar_b = storage<T>(b).front();
+        for (size_t i{0}; i < a.size(); i++)
+        {
+          serial_c[i] = op(serial_a[i], scalar_b);
+        }
+      }
+  );
+}
 
-  auto const scalar_b = serial_b.front();
-  for (size_t i{0}; i < a.size(); i++)
+template <class Op>
+void broadcast_op(Buffer const &a, Buffer const &b, Buffer &c, Op const &op)
+{
+  assert_compatible_broadcast(a, b, c);
+
+  auto const [rows, cols] = a.storage_shape();
+  auto const per_row      = broadcast_per_row(a, b);
+  visit_precision(
+      a.dtype(),
+      [&](auto const precision)
+      {
+        using T              = typename decltype(precision)::type;
+        auto const &serial_a = storage<T>(a);
+        auto const &serial_b = storage<T>(b);
+        auto &serial_c       = storage<T>(c);
+
+        for (size_t i{0}; i < rows; i++)
+        {
+          for (size_t j{0}; j < cols; j++)
+          {
+            serial_c[(i * cols) + j] = op(serial_a[(i * cols) + j], serial_b[per_row ? i : j]);
+          }
+        }
+      }
+  );
+}
+
+template <class T, class Op>
+void chunk_op(T const *a, T const *b, T *c, size_t const n, Op const &op)
+{
+  for (size_t i{0}; i < n; i++)
+  {
+    c[i] = op(a[i], b[i]);
+  }
+}
+
+template <class T>
+void expr_kernel(ExprOp const op, T const *a, T const *b, T *c, size_t const n)
+{
+  switch (op)
   {
-    serial_c[i] = op(serial_a[i], scalar_b);
+  case ExprOp::ADD:
+    chunk_op(a, b, c, n, Add{});
+    break;
+  case ExprOp::SUB:
+    chunk_op(a, b, c, n, Sub{});
+    break;
+  case ExprOp::MUL:
+    chunk_op(a, b, c, n, Mul{});
+    break;
+  case ExprOp::DIV_OR_ZERO:
+    chunk_op(a, b, c, n, DivOrZero{});
+    break;
+  default:
+    chunk_op(a, b, c, n, Div{});
+    break;
   }
 }
 
@@ -77,22 +255,88 @@ void SerialDevice::mul(Buffer const &a, Buffer const &b, Buffer &c) const
 {
   assert_compatible_mul(a, b, c);
 
+  auto const [m, k] = a.shape();
+  auto const n      = b.shape().cols;
+
+  // Transposed operands are read through their strides
+  auto const [a_rs, a_cs] = a.is_transposed() ? std::pair{size_t{1}, m} : std::pair{k, size_t{1}};
+  auto const [b_rs, b_cs] = b.is_transposed() ? std::pair{size_t{1}, k} : std::pair{n, size_t{1}};
+
+  // F16 and BF16 operands are widened as they are read, the sums are accumulated in float, or in
+  // double for F64 operands
+  visit_elements(
+      a,
+      [&](auto const serial_a)
+      {
+        visit_elements(
+            b,
+            [&](auto const serial_b)
+            {
+              using T        = decltype(serial_a[0] * serial_b[0]);
+              auto &serial_c = storage<T>(c);
+
+              // Matrix-vector products keep the running sum in a register instead of in C
+              if (n == 1)
+              {
+                for (size_t i{0}; i < m; i++)
+                {
+                  T acc{0.0};
+                  for (size_t p{0}; p < k; p++)
+                  {
+                    acc = std::fma(serial_a[(i * a_rs) + (p * a_cs)], serial_b[p], acc);
+                  }
+                  serial_c[i] = acc;
+                }
+                return;
+              }
+
+              std::fill(serial_c.begin(), serial_c.end(), T{0.0});
+              for (size_t i{0}; i < m; i++)
+              {
+                for (size_t p{0}; p < k; p++)
+                {
+                  auto const a_ip = serial_a[(i * a_rs) + (p * a_cs)];
+
+                  for (size_t j{0}; j < n; j++)
+                  {
+                    serial_c[(i * n) + j] =
+                        std::fma(a_ip, serial_b[(p * b_rs) + (j * b_cs)], serial_c[(i * n) + j]);
+                  }
+                }
+              }
+            }
+        );
+      }
+  );
+}
+
+void SerialDevice::batched_mul(Buffer const &a, Buffer const &b, Buffer &c, size_t const batch) const
+{
+  assert_compatible_batched_mul(a, b, c, batch);
+
   auto const &serial_a = *static_cast<SerialBuffer const *>(a.get());
   auto const &serial_b = *static_cast<SerialBuffer const *>(b.get());
   auto &serial_c       = *static_cast<SerialBuffer *>(c.get());
 
-  auto const [m, k] = a.shape();
-  auto const n      = b.shape().cols;
+  auto const m = a.shape().rows / batch;
+  auto const k = a.shape().cols;
+  auto const n = b.shape().cols;
 
-  for (size_t i{0}; i < m; i++)
+  std::fill(serial_c.begin(), serial_c.end(), 0.0F);
+  for (size_t s{0}; s < batch; s++)
   {
-    for (size_t p{0}; p < k; p++)
+    auto const *a_s = serial_a.data() + (s * m * k);
+    auto const *b_s = serial_b.data() + (s * k * n);
+    auto *c_s       = serial_c.data() + (s * m * n);
+    for (size_t i{0}; i < m; i++)
     {
-      auto const a_ip = serial_a[(i * k) + p];
-
-      for (size_t j{0}; j < n; j++)
+      for (size_t p{0}; p < k; p++)
       {
-        serial_c[(i * n) + j] = std::fma(a_ip, serial_b[(p * n) + j], serial_c[(i * n) + j]);
+        auto const a_ip = a_s[(i * k) + p];
+        for (size_t j{0}; j < n; j++)
+        {
+          c_s[(i * n) + j] = std::fma(a_ip, b_s[(p * n) + j], c_s[(i * n) + j]);
+        }
       }
     }
   }
@@ -128,51 +372,370 @@ void SerialDevice::sdiv(Buffer const &a, Buffer const &b, Buffer &c) const
   cwises_op(a, b, c, Div{});
 }
 
+void SerialDevice::dot(Buffer const &a, Buffer const &b, Buffer &c) const
+{
+  assert_compatible_dot(a, b, c);
+
+  visit_elements(
+      a,
+      [&](auto const serial_a)
+      {
+        visit_elements(
+            b,
+            [&](auto const serial_b)
+            {
+              using T = decltype(serial_a[0] * serial_b[0]);
+              T acc{0.0};
+              for (size_t i{0}; i < a.size(); i++)
+              {
+                acc = std::fma(serial_a[i], serial_b[i], acc);
+              }
+              storage<T>(c).front() = acc;
+            }
+        );
+      }
+  );
+}
+
+void SerialDevice::axpy(Buffer const &alpha, Buffer const &x, Buffer &y) const
+{
+  assert_compatible_axpy(alpha, x, y);
+
+  visit_precision(
+      x.dtype(),
+      [&](auto const precision)
+      {
+        using T              = typename decltype(precision)::type;
+        auto const &serial_x = storage<T>(x);
+        auto &serial_y       = storage<T>(y);
+
+        auto const scalar_alpha = storage<T>(alpha).front();
+        for (size_t i{0}; i < x.size(); i++)
+        {
+          serial_y[i] = std::fma(scalar_alpha, serial_x[i], serial_y[i]);
+        }
+      }
+  );
+}
+
+void SerialDevice::axpby(Buffer const &alpha, Buffer const &x, Buffer const &beta, Buffer &y) const
+{
+  assert_compatible_axpby(alpha, x, beta, y);
+
+  visit_precision(
+      x.dtype(),
+      [&](auto const precision)
+      {
+        using T              = typename decltype(precision)::type;
+        auto const &serial_x = storage<T>(x);
+        auto &serial_y       = storage<T>(y);
+
+        auto const scalar_alpha = storage<T>(alpha).front();
+        auto const scalar_beta  = storage<T>(beta).front();
+        for (size_t i{0}; i < x.size(); i++)
+        {
+          serial_y[i] = std::fma(scalar_alpha, serial_x[i], scalar_beta * serial_y[i]);
+        }
+      }
+  );
+}
+
+void SerialDevice::batched_cg(
+    Buffer const &a,
+    Buffer const &b,
+    Buffer &x,
+    size_t const batch,
+    size_t const max_iter,
+    float const tol
+) const
+{
+  assert_compatible_batched_solve(a, b, x, batch);
+
+  auto const &serial_a = *static_cast<SerialBuffer const *>(a.get());
+  auto const &serial_b = *static_cast<SerialBuffer const *>(b.get());
+  auto &serial_x       = *static_cast<SerialBuffer *>(x.get());
+
+  batched_cg_systems(
+      serial_a.data(), serial_b.data(), serial_x.data(), a.shape().cols, 0, batch, max_iter, tol
+  );
+}
+
+void SerialDevice::batched_cholesky(
+    Buffer const &a, Buffer const &b, Buffer &x, size_t const batch
+) const
+{
+  assert_compatible_batched_solve(a, b, x, batch);
+
+  auto const &serial_a = *static_cast<SerialBuffer const *>(a.get());
+  auto const &serial_b = *static_cast<SerialBuffer const *>(b.get());
+  auto &serial_x       = *static_cast<SerialBuffer *>(x.get());
+
+  batched_cholesky_systems(
+      serial_a.data(), serial_b.data(), serial_x.data(), a.shape().cols, 0, batch
+  );
+}
+
+void SerialDevice::spmv(SparseBuffer const &a, Buffer const &x, Buffer &y) const
+{
+  assert_compatible_spmv(a, x, y);
+
+  auto const &csr      = *static_cast<CsrData const *>(a.get());
+  auto const &serial_x = *static_cast<SerialBuffer const *>(x.get());
+  auto &serial_y       = *static_cast<SerialBuffer *>(y.get());
+
+  csr_spmv_rows(csr, serial_x.data(), serial_y.data(), 0, a.shape().rows);
+}
+
+void SerialDevice::spmm(SparseBuffer const &a, Buffer const &x, Buffer &y) const
+{
+  assert_compatible_spmm(a, x, y);
+
+  auto const &csr      = *static_cast<CsrData const *>(a.get());
+  auto const &serial_x = *static_cast<SerialBuffer const *>(x.get());
+  auto &serial_y       = *static_cast<SerialBuffer *>(y.get());
+
+  csr_spmm_rows(csr, serial_x.data(), serial_y.data(), x.shape().cols, 0, a.shape().rows);
+}
+
+void SerialDevice::broadcast(ExprOp const op, Buffer const &a, Buffer const &b, Buffer &c) const
+{
+  switch (op)
+  {
+  case ExprOp::ADD:
+    broadcast_op(a, b, c, Add{});
+    break;
+  case ExprOp::SUB:
+    broadcast_op(a, b, c, Sub{});
+    break;
+  case ExprOp::MUL:
+    broadcast_op(a, b, c, Mul{});
+    break;
+  default:
+    broadcast_op(a, b, c, Div{});
+    break;
+  }
+}
+
+void SerialDevice::eval(Expression const &expr, Buffer &out) const
+{
+  assert_compatible_eval(expr, out);
+
+  visit_precision(
+      out.dtype(),
+      [&](auto const precision)
+      {
+        using T = typename decltype(precision)::type;
+        std::vector<T const *> inputs;
+        inputs.reserve(expr.operands().size());
+        for (auto const *operand : expr.operands())
+        {
+          inputs.push_back(storage<T>(*operand).data());
+        }
+
+        eval_chunked(expr, inputs, storage<T>(out).data(), 0, out.size(), expr_kernel<T>);
+      }
+  );
+}
+
 Buffer SerialDevice::new_buffer(std::vector<float> data, Shape shape) const
 {
-  return Buffer{
-      HandlePtr{
-          new SerialBuffer(std::move(data)),
-          [](void *ptr) -> void
-          { std::default_delete<SerialBuffer>{}(static_cast<SerialBuffer *>(ptr)); }
-      },
-      shape,
-      SerialDevice::s_type
-  };
+  auto buffer = this->new_empty_buffer(shape);
+  std::copy(data.cbegin(), data.cend(), static_cast<SerialBuffer *>(buffer.get())->begin());
+  return buffer;
+}
+
+Buffer SerialDevice::new_f64_buffer(std::vector<double> data, Shape shape) const
+{
+  auto buffer = this->new_typed_buffer(shape, DType::F64);
+  std::copy(data.cbegin(), data.cend(), storage<double>(buffer).begin());
+  return buffer;
+}
+
+Buffer SerialDevice::new_buffer_with_shape(Shape shape) const
+{
+  auto buffer = this->new_empty_buffer(shape);
+  auto &serial_buffer = *static_cast<SerialBuffer *>(buffer.get());
+  std::fill(serial_buffer.begin(), serial_buffer.end(), 0.0F);
+  return buffer;
+}
+
+Buffer SerialDevice::new_empty_buffer(Shape shape) const
+{
+  return new_storage(this->m_cache, shape, SerialDevice::s_type, DType::F32);
+}
+
+Buffer SerialDevice::new_typed_buffer(Shape shape, DType dtype) const
+{
+  switch (dtype)
+  {
+  case DType::F32:
+    return this->new_empty_buffer(shape);
+  case DType::F64:
+    return new_storage(this->m_double_cache, shape, SerialDevice::s_type, dtype);
+  default:
+    return new_storage(this->m_reduced_cache, shape, SerialDevice::s_type, dtype);
+  }
+}
+
+void SerialDevice::convert(Buffer const &from, Buffer &to) const
+{
+  assert_compatible_convert(from, to);
+
+  if (not is_reduced(to.dtype()))
+  {
+    visit_precision(
+        to.dtype(),
+        [&](auto const precision)
+        {
+          using T         = typename decltype(precision)::type;
+          auto &serial_to = storage<T>(to);
+          visit_elements(
+              from,
+              [&](auto const serial_from)
+              {
+                for (size_t i{0}; i < from.size(); i++)
+                {
+                  serial_to[i] = static_cast<T>(serial_from[i]);
+                }
+              }
+          );
+        }
+    );
+    return;
+  }
+
+  // F64 elements are rounded to float on the way
+  auto &serial_to = *static_cast<SerialReducedBuffer *>(to.get());
+  visit_elements(
+      from,
+      [&](auto const serial_from)
+      {
+        for (size_t i{0}; i < from.size(); i++)
+        {
+          serial_to[i] = float_to_reduced(to.dtype(), static_cast<float>(serial_from[i]));
+        }
+      }
+  );
+}
+
+AllocatorStats SerialDevice::allocator_stats() const
+{
+  auto stats = this->m_cache.stats();
+  stats += this->m_reduced_cache.stats();
+  stats += this->m_double_cache.stats();
+  return stats;
+}
+
+void SerialDevice::trim() const
+{
+  this->m_cache.trim();
+  this->m_reduced_cache.trim();
+  this->m_double_cache.trim();
 }
 
 void SerialDevice::copy_buffer(Buffer const &from, Buffer &to) const
 {
   assert_compatible_copy(from, to);
 
-  auto const &serial_from = *static_cast<SerialBuffer const *>(from.get());
-  auto &serial_to         = *static_cast<SerialBuffer *>(to.get());
+  if (is_reduced(from.dtype()))
+  {
+    *static_cast<SerialReducedBuffer *>(to.get()) =
+        *static_cast<SerialReducedBuffer const *>(from.get());
+    return;
+  }
 
-  serial_to = serial_from;
+  visit_precision(
+      from.dtype(),
+      [&](auto const precision)
+      {
+        using T        = typename decltype(precision)::type;
+        storage<T>(to) = storage<T>(from);
+      }
+  );
 }
 
 void SerialDevice::transpose(Buffer const &from, Buffer &to) const
 {
   assert_compatible_transpose(from, to);
 
-  auto const &serial_from = *static_cast<SerialBuffer const *>(from.get());
-  auto &serial_to         = *static_cast<SerialBuffer *>(to.get());
-
   auto const [rows, cols] = from.shape();
-  for (size_t i{0}; i < rows; i++)
+  visit_precision(
+      from.dtype(),
+      [&](auto const precision)
+      {
+        using T                 = typename decltype(precision)::type;
+        auto const &serial_from = storage<T>(from);
+        auto &serial_to         = storage<T>(to);
+
+        for (size_t i{0}; i < rows; i++)
+        {
+          for (size_t j{0}; j < cols; j++)
+          {
+            serial_to[(j * rows) + i] = serial_from[(i * cols) + j];
+          }
+        }
+      }
+  );
+}
+
+std::vector<float> SerialDevice::cpu(Buffer const &buffer) const
+{
+  if (buffer.dtype() == DType::F32)
   {
-    for (size_t j{0}; j < cols; j++)
-    {
-      serial_to[(j * rows) + i] = serial_from[(i * cols) + j];
-    }
+    return storage<float>(buffer);
   }
+
+  std::vector<float> host(buffer.size());
+  visit_elements(
+      buffer,
+      [&](auto const serial)
+      {
+        for (size_t i{0}; i < host.size(); i++)
+        {
+          host[i] = static_cast<float>(serial[i]);
+        }
+      }
+  );
+  return host;
 }
 
-std::vector<float> SerialDevice::cpu(Buffer const &buffer) const
+std::vector<double> SerialDevice::cpu_f64(Buffer const &buffer) const
 {
-  return *static_cast<SerialBuffer const *>(buffer.get());
+  if (buffer.dtype() == DType::F64)
+  {
+    return storage<double>(buffer);
+  }
+
+  std::vector<double> host(buffer.size());
+  visit_elements(
+      buffer,
+      [&](auto const serial)
+      {
+        for (size_t i{0}; i < host.size(); i++)
+        {
+          host[i] = serial[i];
+        }
+      }
+  );
+  return host;
+}
+
+float SerialDevice::read_scalar(Buffer const &buffer) const
+{
+  float value{0.0};
+  visit_elements(buffer, [&value](auto const serial) { value = static_cast<float>(serial[0]); });
+  return value;
+}
+
+double SerialDevice::read_scalar_f64(Buffer const &buffer) const
+{
+  double value{0.0};
+  visit_elements(buffer, [&value](auto const serial) { value = serial[0]; });
+  return value;
 }
 
+float *SerialDevice::host_data(Buffer &buffer) const { return storage<float>(buffer).data(); }
+
 void SerialDevice::sync([[maybe_unused]] Buffer const &buffer) const {}
 
 } // namespace gpu_playground::backend
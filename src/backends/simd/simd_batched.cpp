@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <vector>
+
+#include <xsimd/xsimd.hpp>
+
+#include "simd_batched.hpp"
+#include "thread_pool.hpp"
+
+namespace gpu_playground::backend
+{
+
+namespace
+{
+
+using Batch       = xsimd::batch<float>;
+using GroupBuffer = std::vector<float, xsimd::aligned_allocator<float>>;
+
+constexpr size_t simd_size = Batch::size;
+
+// Interleaves `count` floats per system of the systems [first, first + simd_size): entry e of
+// lane l goes to dst[(e * simd_size) + l]. Lanes past the batch are zero.
+void pack(
+    float const *src, size_t const count, size_t const first, size_t const batch, float *dst
+)
+{
+  for (size_t l{0}; l < simd_size; l++)
+  {
+    auto const s = first + l;
+    for (size_t e{0}; e < count; e++)
+    {
+      dst[(e * simd_size) + l] = s < batch ? src[(s * count) + e] : 0.0F;
+    }
+  }
+}
+
+void unpack(
+    float const *src, size_t const count, size_t const first, size_t const batch, float *dst
+)
+{
+  for (size_t l{0}; l < simd_size and first + l < batch; l++)
+  {
+    for (size_t e{0}; e < count; e++)
+    {
+      dst[((first + l) * count) + e] = src[(e * simd_size) + l];
+    }
+  }
+}
+
+// Lanes past the batch get the identity, so that they solve a well-posed zero system
+void pack_matrices(
+    float const *a, size_t const n, size_t const first, size_t const batch, float *dst
+)
+{
+  pack(a, n * n, first, batch, dst);
+  for (size_t l{0}; l < simd_size; l++)
+  {
+    if (first + l >= batch)
+    {
+      for (size_t i{0}; i < n; i++)
+      {
+        dst[(((i * n) + i) * simd_size) + l] = 1.0F;
+      }
+    }
+  }
+}
+
+Batch load(float const *group, size_t const i)
+{
+  return Batch::load_aligned(group + (i * simd_size));
+}
+
+void store(Batch const value, float *group, size_t const i)
+{
+  value.store_aligned(group + (i * simd_size));
+}
+
+// out = A v for every lane of the group
+void group_mat_vec(float const *a, float const *v, float *out, size_t const n)
+{
+  for (size_t i{0}; i < n; i++)
+  {
+    Batch acc(0.0F);
+    for (size_t j{0}; j < n; j++)
+    {
+      acc = xsimd::fma(load(a, (i * n) + j), load(v, j), acc);
+    }
+    store(acc, out, i);
+  }
+}
+
+// Runs body(begin, end) over the groups of systems, split between threads when the batch holds
+// enough work, with `cost` the multiply-adds of one system
+template <class Body>
+void run_groups(size_t const batch, size_t const cost, Body const &body)
+{
+  auto const groups = (batch + simd_size - 1) / simd_size;
+  if (batch * cost < parallel_threshold())
+  {
+    body(0, groups);
+    return;
+  }
+  auto const grain = grain_size() / std::max<size_t>(cost * simd_size, 1);
+  thread_pool().parallel_for(0, groups, std::max<size_t>(grain, 1), body);
+}
+
+} // namespace
+
+void batched_cg(
+    size_t const batch,
+    size_t const n,
+    float const *a,
+    float const *b,
+    float *x,
+    size_t const max_iter,
+    float const tol
+)
+{
+  run_groups(
+      batch,
+      n * n,
+      [&](size_t const group_begin, size_t const group_end)
+      {
+        GroupBuffer a_g(n * n * simd_size);
+        GroupBuffer b_g(n * simd_size);
+        GroupBuffer x_g(n * simd_size);
+        GroupBuffer r(n * simd_size);
+        GroupBuffer p(n * simd_size);
+        GroupBuffer ap(n * simd_size);
+        Batch const tol_batch(tol);
+
+        for (size_t g{group_begin}; g < group_end; g++)
+        {
+          auto const first = g * simd_size;
+          pack_matrices(a, n, first, batch, a_g.data());
+          pack(b, n, first, batch, b_g.data());
+          pack(x, n, first, batch, x_g.data());
+
+          group_mat_vec(a_g.data(), x_g.data(), ap.data(), n);
+          Batch rr(0.0F);
+          for (size_t i{0}; i < n; i++)
+          {
+            auto const r_i = load(b_g.data(), i) - load(ap.data(), i);
+            store(r_i, r.data(), i);
+            store(r_i, p.data(), i);
+            rr = xsimd::fma(r_i, r_i, rr);
+          }
+
+          // Converged lanes keep their x, r and p, whatever their alpha and beta turn out to be
+          for (size_t iter{0}; iter < max_iter; iter++)
+          {
+            auto const active = xsimd::sqrt(rr) >= tol_batch;
+            if (not xsimd::any(active))
+            {
+              break;
+            }
+
+            group_mat_vec(a_g.data(), p.data(), ap.data(), n);
+            Batch pap(0.0F);
+            for (size_t i{0}; i < n; i++)
+            {
+              pap = xsimd::fma(load(p.data(), i), load(ap.data(), i), pap);
+            }
+            auto const alpha = rr / pap;
+
+            Batch rr_next(0.0F);
+            for (size_t i{0}; i < n; i++)
+            {
+              auto const x_i = load(x_g.data(), i);
+              auto const r_i = load(r.data(), i);
+              auto const x_next =
+                  xsimd::select(active, xsimd::fma(alpha, load(p.data(), i), x_i), x_i);
+              auto const r_next =
+                  xsimd::select(active, xsimd::fnma(alpha, load(ap.data(), i), r_i), r_i);
+              store(x_next, x_g.data(), i);
+              store(r_next, r.data(), i);
+              rr_next = xsimd::fma(r_next, r_next, rr_next);
+            }
+            auto const beta = rr_next / rr;
+            for (size_t i{0}; i < n; i++)
+            {
+              auto const p_i = load(p.data(), i);
+              auto const r_i = load(r.data(), i);
+              store(xsimd::select(active, xsimd::fma(beta, p_i, r_i), p_i), p.data(), i);
+            }
+            rr = rr_next;
+          }
+
+          unpack(x_g.data(), n, first, batch, x);
+        }
+      }
+  );
+}
+
+void batched_cholesky(size_t const batch, size_t const n, float const *a, float const *b, float *x)
+{
+  run_groups(
+      batch,
+      (n * n * n / 3) + (n * n),
+      [&](size_t const group_begin, size_t const group_end)
+      {
+        GroupBuffer l(n * n * simd_size);
+        GroupBuffer x_g(n * simd_size);
+
+        for (size_t g{group_begin}; g < group_end; g++)
+        {
+          auto const first = g * simd_size;
+          pack_matrices(a, n, first, batch, l.data());
+          pack(b, n, first, batch, x_g.data());
+
+          // A = L L^T, with L overwriting the lower triangle
+          for (size_t j{0}; j < n; j++)
+          {
+            auto diag = load(l.data(), (j * n) + j);
+            for (size_t k{0}; k < j; k++)
+            {
+              auto const l_jk = load(l.data(), (j * n) + k);
+              diag            = xsimd::fnma(l_jk, l_jk, diag);
+            }
+            diag = xsimd::sqrt(diag);
+            store(diag, l.data(), (j * n) + j);
+            for (size_t i{j + 1}; i < n; i++)
+            {
+              auto value = load(l.data(), (i * n) + j);
+              for (size_t k{0}; k < j; k++)
+              {
+                auto const l_ik = load(l.data(), (i * n) + k);
+                value           = xsimd::fnma(l_ik, load(l.data(), (j * n) + k), value);
+              }
+              store(value / diag, l.data(), (i * n) + j);
+            }
+          }
+
+          // L y = b, then L^T x = y
+          for (size_t i{0}; i < n; i++)
+          {
+            auto value = load(x_g.data(), i);
+            for (size_t k{0}; k < i; k++)
+            {
+              value = xsimd::fnma(load(l.data(), (i * n) + k), load(x_g.data(), k), value);
+            }
+            store(value / load(l.data(), (i * n) + i), x_g.data(), i);
+          }
+          for (size_t i{n}; i-- > 0;)
+          {
+            auto value = load(x_g.data(), i);
+            for (size_t k{i + 1}; k < n; k++)
+            {
+              value = xsimd::fnma(load(l.data(), (k * n) + i), load(x_g.data(), k), value);
+            }
+            store(value / load(l.data(), (i * n) + i), x_g.data(), i);
+          }
+
+          unpack(x_g.data(), n, first, batch, x);
+        }
+      }
+  );
+}
+
+} // namespace gpu_playground::backend
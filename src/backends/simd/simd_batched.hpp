@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+namespace gpu_playground::backend
+{
+
+// Solvers for batches of small dense SPD systems A_s x_s = b_s, with the row-major (n x n)
+// matrices A_s stored one after the other in a and the vectors in b and x. Groups of one SIMD
+// width of systems are interleaved so that every lane solves its own system, and the groups are
+// split between threads.
+
+// Conjugate gradient from the initial guesses in x. The systems of a group iterate in lockstep,
+// each one frozen by its lane mask once its residual norm is below `tol`.
+void batched_cg(
+    size_t batch, size_t n, float const *a, float const *b, float *x, size_t max_iter, float tol
+);
+
+// Cholesky factorisation and triangular solves. A system that is not positive definite gets NaN
+// in its solution.
+void batched_cholesky(size_t batch, size_t n, float const *a, float const *b, float *x);
+
+} // namespace gpu_playground::backend
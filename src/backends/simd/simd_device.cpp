@@ -1,113 +1,571 @@
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <numeric>
 
 #include <memory>
 #include <xsimd/xsimd.hpp>
 
+#include "thread_pool.hpp"
+
+#include "simd_batched.hpp"
 #include "simd_device.hpp"
+#include "simd_gemm.hpp"
+#include "simd_kernels.hpp"
+#include "simd_reduced.hpp"
+#include "simd_sparse.hpp"
 
 namespace gpu_playground::backend
 {
 
-using SIMDBuffer = std::vector<float, xsimd::aligned_allocator<float>>;
-
 namespace
 {
 
 struct Add
 {
-  [[nodiscard]] xsimd::batch<float>
-  operator()(xsimd::batch<float> const a, xsimd::batch<float> const b) const
+  template <class T>
+  [[nodiscard]] xsimd::batch<T> operator()(xsimd::batch<T> const a, xsimd::batch<T> const b) const
   {
     return a + b;
   }
 
-  [[nodiscard]] constexpr float operator()(float const a, float const b) const { return a + b; }
+  template <class T>
+  [[nodiscard]] constexpr T operator()(T const a, T const b) const
+  {
+    return a + b;
+  }
 };
 
 struct Sub
 {
-  [[nodiscard]] xsimd::batch<float>
-  operator()(xsimd::batch<float> const a, xsimd::batch<float> const b) const
+  template <class T>
+  [[nodiscard]] xsimd::batch<T> operator()(xsimd::batch<T> const a, xsimd::batch<T> const b) const
   {
     return a - b;
   }
 
-  [[nodiscard]] constexpr float operator()(float const a, float const b) const { return a - b; }
+  template <class T>
+  [[nodiscard]] constexpr T operator()(T const a, T const b) const
+  {
+    return a - b;
+  }
 };
 
 struct Mul
 {
-  [[nodiscard]] xsimd::batch<float>
-  operator()(xsimd::batch<float> const a, xsimd::batch<float> const b) const
+  template <class T>
+  [[nodiscard]] xsimd::batch<T> operator()(xsimd::batch<T> const a, xsimd::batch<T> const b) const
   {
     return a * b;
   }
 
-  [[nodiscard]] constexpr float operator()(float const a, float const b) const { return a * b; }
+  template <class T>
+  [[nodiscard]] constexpr T operator()(T const a, T const b) const
+  {
+    return a * b;
+  }
 };
 
 struct Div
 {
-  [[nodiscard]] xsimd::batch<float>
-  operator()(xsimd::batch<float> const a, xsimd::batch<float> const b) const
+  template <class T>
+  [[nodiscard]] xsimd::batch<T> operator()(xsimd::batch<T> const a, xsimd::batch<T> const b) const
   {
     return a / b;
   }
 
-  [[nodiscard]] constexpr float operator()(float const a, float const b) const { return a / b; }
+  template <class T>
+  [[nodiscard]] constexpr T operator()(T const a, T const b) const
+  {
+    return a / b;
+  }
 };
 
+struct DivOrZero
+{
+  template <class T>
+  [[nodiscard]] xsimd::batch<T> operator()(xsimd::batch<T> const a, xsimd::batch<T> const b) const
+  {
+    xsimd::batch<T> const zero(T{0.0});
+    return xsimd::select(b == zero, zero, a / b);
+  }
+
+  template <class T>
+  [[nodiscard]] constexpr T operator()(T const a, T const b) const
+  {
+    return b == T{0.0} ? T{0.0} : a / b;
+  }
+};
+
+// Elements in a batch of T, twice as many floats as doubles
+template <class T>
+constexpr size_t simd_width = xsimd::batch<T>::size;
+
+constexpr size_t simd_size = simd_width<float>;
+
+static_assert(simd_size % simd_width<double> == 0, "Float batches must hold whole double batches");
+
+// Grain size rounded up to whole batches, so that every chunk starts on an aligned element. Float
+// batches are the widest, so the chunks are aligned for doubles too.
+size_t simd_grain_size() { return ((grain_size() + simd_size - 1) / simd_size) * simd_size; }
+
+// Storage of a buffer of T elements, float for F32 and double for F64
+template <class T>
+SIMDStorage<T> const &storage(Buffer const &buffer)
+{
+  return *static_cast<SIMDStorage<T> const *>(buffer.get());
+}
+
+template <class T>
+SIMDStorage<T> &storage(Buffer &buffer)
+{
+  return *static_cast<SIMDStorage<T> *>(buffer.get());
+}
+
+// Buffer of `dtype` elements on storage from `cache`, sized to the elements of `shape`
+template <class Storage>
+Buffer new_storage(
+    CachingAllocator<Storage> const &cache,
+    Shape const shape,
+    DeviceType const type,
+    DType const dtype
+)
+{
+  using T         = typename Storage::value_type;
+  auto const size = shape.rows * shape.cols;
+  auto const make = [size](size_t const bytes) -> Storage *
+  {
+    auto *data = new Storage();
+    data->reserve(bytes / sizeof(T));
+    data->resize(size);
+    return data;
+  };
+  return Buffer{
+      cache.allocate(size * sizeof(T), make, [size](Storage &data) -> void { data.resize(size); }),
+      shape,
+      type,
+      dtype
+  };
+}
+
+// Elements of `buffer`, floats or 16-bit values depending on its dtype
+void const *element_data(Buffer const &buffer)
+{
+  if (buffer.dtype() == DType::F32)
+  {
+    return static_cast<SIMDBuffer const *>(buffer.get())->data();
+  }
+  return static_cast<SIMDReducedBuffer const *>(buffer.get())->data();
+}
+
+// Float elements of `buffer`, widened into `scratch` when it holds F16 or BF16 elements
+float const *float_data(Buffer const &buffer, SIMDBuffer &scratch)
+{
+  if (buffer.dtype() == DType::F32)
+  {
+    return static_cast<SIMDBuffer const *>(buffer.get())->data();
+  }
+
+  scratch.resize(buffer.size());
+  auto const *reduced = static_cast<uint16_t const *>(element_data(buffer));
+  parallel_for(
+      0,
+      buffer.size(),
+      simd_grain_size(),
+      [&](size_t const begin, size_t const end)
+      { widen(buffer.dtype(), reduced, scratch.data(), begin, end); }
+  );
+  return scratch.data();
+}
+
+template <class Storage>
+void copy_storage(Buffer const &from, Buffer &to)
+{
+  auto const &simd_from = *static_cast<Storage const *>(from.get());
+  auto &simd_to         = *static_cast<Storage *>(to.get());
+
+  parallel_for(
+      0,
+      from.size(),
+      simd_grain_size(),
+      [&](size_t const begin, size_t const end)
+      {
+        std::copy(
+            std::next(simd_from.cbegin(), static_cast<std::ptrdiff_t>(begin)),
+            std::next(simd_from.cbegin(), static_cast<std::ptrdiff_t>(end)),
+            std::next(simd_to.begin(), static_cast<std::ptrdiff_t>(begin))
+        );
+      }
+  );
+}
+
 template <class Op>
 void cwisem_op(Buffer const &a, Buffer const &b, Buffer &c, Op const &op)
 {
   assert_same_shape(a, b, c);
 
-  auto const &simd_a = *static_cast<SIMDBuffer const *>(a.get());
-  auto const &simd_b = *static_cast<SIMDBuffer const *>(b.get());
-  auto &simd_c       = *static_cast<SIMDBuffer *>(c.get());
+  visit_precision(
+      a.dtype(),
+      [&](auto const precision)
+      {
+        using T            = typename decltype(precision)::type;
+        auto const &simd_a = storage<T>(a);
+        auto const &simd_b = storage<T>(b);
+        auto &simd_c       = storage<T>(c);
+
+        parallel_for(
+            0,
+            a.size(),
+            simd_grain_size(),
+            [&](size_t const begin, size_t const end)
+            {
+              size_t const vec_end = end - ((end - begin) % simd_width<T>);
+
+              for (size_t i{begin}; i < vec_end; i += simd_width<T>)
+              {
+                auto const ba   = xsimd::load_aligned(&simd_a[i]);
+                auto const bb   = xsimd::load_aligned(&simd_b[i]);
+                auto const bres = op(ba, bb);
+                bres.store_aligned(&simd_c[i]);
+              }
+              for (size_t i{vec_end}; i < end; i++)
+              {
+                simd_c[i] = op(simd_a[i], simd_b[i]);
+              }
+            }
+        );
+      }
+  );
+}
 
-  size_t const size          = a.size();
-  constexpr size_t simd_size = xsimd::simd_type<float>::size;
-  size_t const vec_size      = size - (size % simd_size);
+template <class Op>
+void cwises_op(Buffer const &a, Buffer const &b, Buffer &c, Op const &op)
+{
+  assert_compatible_sop(a, b, c);
+
+  visit_precision(
+      a.dtype(),
+      [&](auto const precision)
+      {
+        using T            = typename decltype(precision)::type;
+        auto const &simd_a = storage<T>(a);
+        auto &simd_c       = storage<T>(c);
+
+        auto const sb = storage<T>(b).front();
+        auto const bb = xsimd::broadcast(sb);
+        parallel_for(
+            0,
+            a.size(),
+            simd_grain_size(),
+            [&](size_t const begin, size_t const end)
+            {
+              size_t const vec_end = end - ((end - begin) % simd_width<T>);
+
+              for (size_t i{begin}; i < vec_end; i += simd_width<T>)
+              {
+                auto const ba   = xsimd::load_aligned(&simd_a[i]);
+                auto const bres = op(ba, bb);
+                bres.store_aligned(&simd_c[i]);
+              }
+              for (size_t i{vec_end}; i < end; i++)
+              {
+                simd_c[i] = op(simd_a[i], sb);
+              }
+            }
+        );
+      }
+  );
+}
+
+template <class T, class Op>
+void chunk_op(T const *a, T const *b, T *c, size_t const n, Op const &op)
+{
+  using Batch = xsimd::batch<T>;
 
-  for (size_t i{0}; i < vec_size; i += simd_size)
+  auto const vec_size = n - (n % simd_width<T>);
+  for (size_t i{0}; i < vec_size; i += simd_width<T>)
   {
-    auto const ba   = xsimd::load_aligned(&simd_a[i]);
-    auto const bb   = xsimd::load_aligned(&simd_b[i]);
-    auto const bres = op(ba, bb);
-    bres.store_aligned(&simd_c[i]);
+    op(Batch::load_unaligned(a + i), Batch::load_unaligned(b + i)).store_unaligned(c + i);
   }
-  for (size_t i{vec_size}; i < size; i++)
+  for (size_t i{vec_size}; i < n; i++)
   {
-    simd_c[i] = op(simd_a[i], simd_b[i]);
+    c[i] = op(a[i], b[i]);
   }
 }
 
+// The vector stays in registers when it holds one value per row, and is read again from L1 for
+// every row otherwise
 template <class Op>
-void cwises_op(Buffer const &a, Buffer const &b, Buffer &c, Op const &op)
+void broadcast_op(Buffer const &a, Buffer const &b, Buffer &c, Op const &op)
 {
-  assert_compatible_sop(a, b, c);
+  assert_compatible_broadcast(a, b, c);
 
-  auto const &simd_a = *static_cast<SIMDBuffer const *>(a.get());
-  auto const &simd_b = *static_cast<SIMDBuffer const *>(b.get());
-  auto &simd_c       = *static_cast<SIMDBuffer *>(c.get());
+  auto const [rows, cols] = a.storage_shape();
+  auto const per_row      = broadcast_per_row(a, b);
+  visit_precision(
+      a.dtype(),
+      [&](auto const precision)
+      {
+        using T            = typename decltype(precision)::type;
+        using Batch        = xsimd::batch<T>;
+        auto const &simd_a = storage<T>(a);
+        auto const &simd_b = storage<T>(b);
+        auto &simd_c       = storage<T>(c);
+
+        auto const vec_cols = cols - (cols % simd_width<T>);
+        auto const body     = [&](size_t const begin, size_t const end)
+        {
+          for (size_t i{begin}; i < end; i++)
+          {
+            auto const *row_a = &simd_a[i * cols];
+            auto *row_c       = &simd_c[i * cols];
+            if (not per_row)
+            {
+              chunk_op(row_a, simd_b.data(), row_c, cols, op);
+              continue;
+            }
+
+            auto const sb = simd_b[i];
+            auto const bb = xsimd::broadcast(sb);
+            for (size_t j{0}; j < vec_cols; j += simd_width<T>)
+            {
+              op(Batch::load_unaligned(row_a + j), bb).store_unaligned(row_c + j);
+            }
+            for (size_t j{vec_cols}; j < cols; j++)
+            {
+              row_c[j] = op(row_a[j], sb);
+            }
+          }
+        };
+
+        if (a.size() < parallel_threshold())
+        {
+          body(0, rows);
+          return;
+        }
+        thread_pool().parallel_for(0, rows, std::max<size_t>(grain_size() / cols, 1), body);
+      }
+  );
+}
+
+template <class T>
+void expr_kernel(ExprOp const op, T const *a, T const *b, T *c, size_t const n)
+{
+  switch (op)
+  {
+  case ExprOp::ADD:
+    chunk_op(a, b, c, n, Add{});
+    break;
+  case ExprOp::SUB:
+    chunk_op(a, b, c, n, Sub{});
+    break;
+  case ExprOp::MUL:
+    chunk_op(a, b, c, n, Mul{});
+    break;
+  case ExprOp::DIV_OR_ZERO:
+    chunk_op(a, b, c, n, DivOrZero{});
+    break;
+  default:
+    chunk_op(a, b, c, n, Div{});
+    break;
+  }
+}
+
+// Row i of `csr` times x, with the entries of x gathered one batch of column indices at a time
+float csr_row_dot(CsrData const &csr, float const *x, size_t const i)
+{
+  using Batch      = xsimd::batch<float>;
+  using IndexBatch = xsimd::batch<CsrIndex>;
+  static_assert(IndexBatch::size == simd_size, "Index and value batches must have the same size");
 
-  size_t const size          = a.size();
-  constexpr size_t simd_size = xsimd::simd_type<float>::size;
-  size_t const vec_size      = size - (size % simd_size);
+  auto const begin = static_cast<size_t>(csr.row_ptr[i]);
+  auto const end   = static_cast<size_t>(csr.row_ptr[i + 1]);
 
-  auto const sb = simd_b.front();
-  auto const bb = xsimd::broadcast(sb);
-  for (size_t i{0}; i < vec_size; i += simd_size)
+  Batch acc(0.0F);
+  size_t k{begin};
+  for (; k + simd_size <= end; k += simd_size)
   {
-    auto const ba   = xsimd::load_aligned(&simd_a[i]);
-    auto const bres = op(ba, bb);
-    bres.store_aligned(&simd_c[i]);
+    auto const cols = IndexBatch::load_unaligned(&csr.col_idx[k]);
+    acc = xsimd::fma(Batch::load_unaligned(&csr.values[k]), Batch::gather(x, cols), acc);
   }
-  for (size_t i{vec_size}; i < size; i++)
+
+  float res = xsimd::reduce_add(acc);
+  for (; k < end; k++)
   {
-    simd_c[i] = op(simd_a[i], sb);
+    res = std::fma(csr.values[k], x[csr.col_idx[k]], res);
   }
+  return res;
+}
+
+// Runs body(begin, end) over the items (rows, or chunks of rows for SELL) whose stored entries
+// start at offsets[0 .. count], each entry costing `cols` multiply-adds. The items are split on
+// their offsets into ranges of about grain_size() multiply-adds each, so that a few long rows do
+// not leave one thread with most of the work. Every item also weighs one entry, for empty rows.
+template <class Offsets, class Body>
+void run_sparse(Offsets const &offsets, size_t const cols, Body const &body)
+{
+  auto const count  = offsets.size() - 1;
+  auto const weight = [&](size_t const i)
+  { return static_cast<size_t>(offsets[i] - offsets[0]) + i; };
+  auto const total = weight(count);
+  auto const work  = total * cols;
+  if (work < parallel_threshold() or count < 2)
+  {
+    body(0, count);
+    return;
+  }
+
+  auto const ranges = std::clamp<size_t>(work / grain_size(), 1, count);
+  // First item of range r, found by bisection of the weights, which strictly increase
+  auto const bound = [&](size_t const r)
+  {
+    auto const target = (total * r) / ranges;
+    size_t lo{0};
+    size_t hi{count};
+    while (lo < hi)
+    {
+      auto const mid = lo + ((hi - lo) / 2);
+      if (weight(mid) < target)
+      {
+        lo = mid + 1;
+      }
+      else
+      {
+        hi = mid;
+      }
+    }
+    return lo;
+  };
+  thread_pool().parallel_for(
+      0,
+      ranges,
+      1,
+      [&](size_t const first, size_t const last)
+      {
+        for (size_t r{first}; r < last; r++)
+        {
+          body(bound(r), bound(r + 1));
+        }
+      }
+  );
+}
+
+// Side of the cache blocks walked by the transpose, so that the rows read and the rows written
+// by a block both stay in L1.
+constexpr size_t TRANSPOSE_BLOCK = 64;
+
+static_assert(TRANSPOSE_BLOCK % simd_size == 0, "TRANSPOSE_BLOCK must be a multiple of simd_size");
+
+// Transposes rows [row_begin, row_end) of a row-major (rows x cols) matrix, one cache block at a
+// time. Blocks are made of square tiles of one batch per row transposed in registers, the ragged
+// edges are copied element by element.
+template <class T>
+void transpose_rows(
+    T const *from,
+    T *to,
+    size_t const rows,
+    size_t const cols,
+    size_t const row_begin,
+    size_t const row_end
+)
+{
+  using Batch = xsimd::batch<T>;
+
+  for (size_t ib{row_begin}; ib < row_end; ib += TRANSPOSE_BLOCK)
+  {
+    auto const i_end = std::min(ib + TRANSPOSE_BLOCK, row_end);
+    for (size_t jb{0}; jb < cols; jb += TRANSPOSE_BLOCK)
+    {
+      auto const j_end = std::min(jb + TRANSPOSE_BLOCK, cols);
+
+      size_t i{ib};
+      for (; i + simd_width<T> <= i_end; i += simd_width<T>)
+      {
+        size_t j{jb};
+        for (; j + simd_width<T> <= j_end; j += simd_width<T>)
+        {
+          std::array<Batch, simd_width<T>> tile;
+          for (size_t r{0}; r < simd_width<T>; r++)
+          {
+            tile[r] = Batch::load_unaligned(from + ((i + r) * cols) + j);
+          }
+          xsimd::transpose(tile.data(), tile.data() + simd_width<T>);
+          for (size_t r{0}; r < simd_width<T>; r++)
+          {
+            tile[r].store_unaligned(to + ((j + r) * rows) + i);
+          }
+        }
+        for (; j < j_end; j++)
+        {
+          for (size_t r{0}; r < simd_width<T>; r++)
+          {
+            to[(j * rows) + i + r] = from[((i + r) * cols) + j];
+          }
+        }
+      }
+      for (; i < i_end; i++)
+      {
+        for (size_t j{jb}; j < j_end; j++)
+        {
+          to[(j * rows) + i] = from[(i * cols) + j];
+        }
+      }
+    }
+  }
+}
+
+// C = A * B for contiguous A, B and C of T elements, with A and B laid out as in `a` and `b`
+template <class T>
+void product(Buffer const &a, Buffer const &b, T const *data_a, T const *data_b, T *data_c)
+{
+  auto const [m, k] = a.shape();
+  auto const n      = b.shape().cols;
+
+  // Transposed operands are packed straight from their strides
+  auto const op_a = a.is_transposed() ? GemmOperand{data_a, 1, m} : GemmOperand{data_a, k, 1};
+  auto const op_b = b.is_transposed() ? GemmOperand{data_b, 1, k} : GemmOperand{data_b, n, 1};
+
+  // Matrix-vector products are bandwidth bound, so they skip the packing of the GEMM
+  if (n == 1)
+  {
+    gemv(m, k, op_a, data_b, data_c);
+    return;
+  }
+  if (m == 1)
+  {
+    gemv(n, k, GemmOperand{op_b.data, op_b.cs, op_b.rs}, data_a, data_c);
+    return;
+  }
+
+  gemm(m, n, k, op_a, op_b, data_c, n);
+}
+
+// Sum of range_dot(begin, end) over [0, size), as partial sums over fixed-size blocks so that the
+// result does not depend on the thread count
+template <class T, class RangeDot>
+T blocked_dot(size_t const size, RangeDot const &range_dot)
+{
+  size_t const block = simd_grain_size();
+  size_t const count = (size + block - 1) / block;
+  if (count <= 1)
+  {
+    return range_dot(0, size);
+  }
+
+  std::vector<T> partial(count);
+  parallel_for(
+      0,
+      size,
+      block,
+      [&](size_t const begin, size_t const end)
+      {
+        for (size_t first{begin}; first < end; first += block)
+        {
+          partial[first / block] = range_dot(first, std::min(first + block, end));
+        }
+      }
+  );
+  return std::accumulate(partial.cbegin(), partial.cend(), T{0.0});
 }
 
 } // namespace
@@ -126,36 +584,83 @@ void SIMDDevice::mul(Buffer const &a, Buffer const &b, Buffer &c) const
 {
   assert_compatible_mul(a, b, c);
 
+  if (c.dtype() == DType::F64)
+  {
+    product(
+        a, b, storage<double>(a).data(), storage<double>(b).data(), storage<double>(c).data()
+    );
+    return;
+  }
+
+  auto &simd_c = *static_cast<SIMDBuffer *>(c.get());
+
+  auto const [m, k] = a.shape();
+  auto const n      = b.shape().cols;
+
+  // An F16 or BF16 matrix times a vector is widened in registers as the GEMV streams it, other
+  // reduced precision operands are widened once before a float product
+  SIMDBuffer a_scratch;
+  SIMDBuffer b_scratch;
+  auto const *data_b = float_data(b, b_scratch);
+  if (n == 1 and a.dtype() != DType::F32)
+  {
+    auto const *reduced_a = static_cast<uint16_t const *>(element_data(a));
+    reduced_gemv(a.dtype(), m, k, reduced_a, data_b, simd_c.data());
+    return;
+  }
+  product(a, b, float_data(a, a_scratch), data_b, simd_c.data());
+}
+
+void SIMDDevice::batched_mul(Buffer const &a, Buffer const &b, Buffer &c, size_t const batch) const
+{
+  assert_compatible_batched_mul(a, b, c, batch);
+
   auto const &simd_a = *static_cast<SIMDBuffer const *>(a.get());
   auto const &simd_b = *static_cast<SIMDBuffer const *>(b.get());
   auto &simd_c       = *static_cast<SIMDBuffer *>(c.get());
 
-  auto const [m, k]          = a.shape();
-  auto const n               = b.shape().cols;
-  constexpr size_t simd_size = xsimd::simd_type<float>::size;
-  size_t const n_simd        = n - (n % simd_size);
+  batched_gemm(
+      batch,
+      a.shape().rows / batch,
+      b.shape().cols,
+      a.shape().cols,
+      simd_a.data(),
+      simd_b.data(),
+      simd_c.data()
+  );
+}
 
-  for (size_t i{0}; i < m; i++)
-  {
-    for (size_t p = 0; p < k; ++p)
-    {
-      auto const a_ip = xsimd::broadcast(simd_a[(i * k) + p]);
+void SIMDDevice::batched_cg(
+    Buffer const &a,
+    Buffer const &b,
+    Buffer &x,
+    size_t const batch,
+    size_t const max_iter,
+    float const tol
+) const
+{
+  assert_compatible_batched_solve(a, b, x, batch);
 
-      for (size_t j{0}; j < n_simd; j += simd_size)
-      {
-        auto c       = xsimd::load_aligned(&simd_c[(i * n) + j]);
-        auto const b = xsimd::load_aligned(&simd_b[(p * n) + j]);
-        c            = xsimd::fma(a_ip, b, c);
-        c.store_aligned(&simd_c[(i * n) + j]);
-      }
+  auto const &simd_a = *static_cast<SIMDBuffer const *>(a.get());
+  auto const &simd_b = *static_cast<SIMDBuffer const *>(b.get());
+  auto &simd_x       = *static_cast<SIMDBuffer *>(x.get());
 
-      for (size_t j{n_simd}; j < n; j++)
-      {
-        simd_c[(i * n) + j] =
-            std::fma(simd_a[(i * k) + p], simd_b[(p * n) + j], simd_c[(i * n) + j]);
-      }
-    }
-  }
+  backend::batched_cg(
+      batch, a.shape().cols, simd_a.data(), simd_b.data(), simd_x.data(), max_iter, tol
+  );
+}
+
+void SIMDDevice::batched_cholesky(
+    Buffer const &a, Buffer const &b, Buffer &x, size_t const batch
+) const
+{
+  assert_compatible_batched_solve(a, b, x, batch);
+
+  auto const &simd_a = *static_cast<SIMDBuffer const *>(a.get());
+  auto const &simd_b = *static_cast<SIMDBuffer const *>(b.get());
+  auto &simd_x       = *static_cast<SIMDBuffer *>(x.get());
+
+  backend::batched_cholesky(batch, a.shape().cols, simd_a.data(), simd_b.data(), simd_x.data());
 }
 
 void SIMDDevice::cmul(Buffer const &a, Buffer const &b, Buffer &c) const
@@ -188,53 +693,494 @@ void SIMDDevice::sdiv(Buffer const &a, Buffer const &b, Buffer &c) const
   cwises_op(a, b, c, Div{});
 }
 
+void SIMDDevice::dot(Buffer const &a, Buffer const &b, Buffer &c) const
+{
+  assert_compatible_dot(a, b, c);
+
+  if (c.dtype() == DType::F64)
+  {
+    auto const *data_a         = storage<double>(a).data();
+    auto const *data_b         = storage<double>(b).data();
+    storage<double>(c).front() = blocked_dot<double>(
+        a.size(),
+        [&](size_t const begin, size_t const end)
+        { return dot_range(ContiguousLoad{data_a}, ContiguousLoad{data_b}, begin, end); }
+    );
+    return;
+  }
+
+  // F16 and BF16 operands are widened in registers as they are loaded
+  auto const *data_a   = element_data(a);
+  auto const *data_b   = element_data(b);
+  auto const mixed     = a.dtype() != DType::F32 or b.dtype() != DType::F32;
+  auto const range_dot = [&](size_t const begin, size_t const end)
+  {
+    if (mixed)
+    {
+      return mixed_dot(a.dtype(), data_a, b.dtype(), data_b, begin, end);
+    }
+    return dot_range(
+        FloatLoad{static_cast<float const *>(data_a)},
+        FloatLoad{static_cast<float const *>(data_b)},
+        begin,
+        end
+    );
+  };
+
+  storage<float>(c).front() = blocked_dot<float>(a.size(), range_dot);
+}
+
+void SIMDDevice::axpy(Buffer const &alpha, Buffer const &x, Buffer &y) const
+{
+  assert_compatible_axpy(alpha, x, y);
+
+  visit_precision(
+      x.dtype(),
+      [&](auto const precision)
+      {
+        using T            = typename decltype(precision)::type;
+        auto const &simd_x = storage<T>(x);
+        auto &simd_y       = storage<T>(y);
+
+        auto const sa = storage<T>(alpha).front();
+        auto const ba = xsimd::broadcast(sa);
+        parallel_for(
+            0,
+            x.size(),
+            simd_grain_size(),
+            [&](size_t const begin, size_t const end)
+            {
+              size_t const vec_end = end - ((end - begin) % simd_width<T>);
+
+              for (size_t i{begin}; i < vec_end; i += simd_width<T>)
+              {
+                auto const bx = xsimd::load_aligned(&simd_x[i]);
+                auto const by = xsimd::load_aligned(&simd_y[i]);
+                xsimd::fma(ba, bx, by).store_aligned(&simd_y[i]);
+              }
+              for (size_t i{vec_end}; i < end; i++)
+              {
+                simd_y[i] = std::fma(sa, simd_x[i], simd_y[i]);
+              }
+            }
+        );
+      }
+  );
+}
+
+void SIMDDevice::axpby(Buffer const &alpha, Buffer const &x, Buffer const &beta, Buffer &y) const
+{
+  assert_compatible_axpby(alpha, x, beta, y);
+
+  visit_precision(
+      x.dtype(),
+      [&](auto const precision)
+      {
+        using T            = typename decltype(precision)::type;
+        auto const &simd_x = storage<T>(x);
+        auto &simd_y       = storage<T>(y);
+
+        auto const sa = storage<T>(alpha).front();
+        auto const sb = storage<T>(beta).front();
+        auto const ba = xsimd::broadcast(sa);
+        auto const bb = xsimd::broadcast(sb);
+        parallel_for(
+            0,
+            x.size(),
+            simd_grain_size(),
+            [&](size_t const begin, size_t const end)
+            {
+              size_t const vec_end = end - ((end - begin) % simd_width<T>);
+
+              for (size_t i{begin}; i < vec_end; i += simd_width<T>)
+              {
+                auto const bx = xsimd::load_aligned(&simd_x[i]);
+                auto const by = xsimd::load_aligned(&simd_y[i]);
+                xsimd::fma(ba, bx, bb * by).store_aligned(&simd_y[i]);
+              }
+              for (size_t i{vec_end}; i < end; i++)
+              {
+                simd_y[i] = std::fma(sa, simd_x[i], sb * simd_y[i]);
+              }
+            }
+        );
+      }
+  );
+}
+
+void SIMDDevice::spmv(SparseBuffer const &a, Buffer const &x, Buffer &y) const
+{
+  assert_compatible_spmv(a, x, y);
+
+  auto const &simd_x = *static_cast<SIMDBuffer const *>(x.get());
+  auto &simd_y       = *static_cast<SIMDBuffer *>(y.get());
+
+  if (a.format() == SparseFormat::SELL)
+  {
+    auto const &sell = *static_cast<SellData const *>(a.get());
+    run_sparse(
+        sell.chunk_ptr,
+        1,
+        [&](size_t const begin, size_t const end)
+        { sell_spmv(sell, simd_x.data(), simd_y.data(), begin, end); }
+    );
+    return;
+  }
+
+  auto const &csr = *static_cast<CsrData const *>(a.get());
+  run_sparse(
+      csr.row_ptr,
+      1,
+      [&](size_t const begin, size_t const end)
+      {
+        for (size_t i{begin}; i < end; i++)
+        {
+          simd_y[i] = csr_row_dot(csr, simd_x.data(), i);
+        }
+      }
+  );
+}
+
+void SIMDDevice::spmm(SparseBuffer const &a, Buffer const &x, Buffer &y) const
+{
+  assert_compatible_spmm(a, x, y);
+
+  auto const &simd_x = *static_cast<SIMDBuffer const *>(x.get());
+  auto &simd_y       = *static_cast<SIMDBuffer *>(y.get());
+  auto const s       = x.shape().cols;
+
+  if (a.format() == SparseFormat::SELL)
+  {
+    auto const &sell = *static_cast<SellData const *>(a.get());
+    run_sparse(
+        sell.chunk_ptr,
+        s,
+        [&](size_t const begin, size_t const end)
+        { sell_spmm(sell, simd_x.data(), simd_y.data(), s, begin, end); }
+    );
+    return;
+  }
+
+  auto const &csr = *static_cast<CsrData const *>(a.get());
+  run_sparse(
+      csr.row_ptr,
+      s,
+      [&](size_t const begin, size_t const end)
+      { csr_spmm(csr, simd_x.data(), simd_y.data(), s, begin, end); }
+  );
+}
+
+void SIMDDevice::broadcast(ExprOp const op, Buffer const &a, Buffer const &b, Buffer &c) const
+{
+  switch (op)
+  {
+  case ExprOp::ADD:
+    broadcast_op(a, b, c, Add{});
+    break;
+  case ExprOp::SUB:
+    broadcast_op(a, b, c, Sub{});
+    break;
+  case ExprOp::MUL:
+    broadcast_op(a, b, c, Mul{});
+    break;
+  default:
+    broadcast_op(a, b, c, Div{});
+    break;
+  }
+}
+
+void SIMDDevice::eval(Expression const &expr, Buffer &out) const
+{
+  assert_compatible_eval(expr, out);
+
+  visit_precision(
+      out.dtype(),
+      [&](auto const precision)
+      {
+        using T = typename decltype(precision)::type;
+        std::vector<T const *> inputs;
+        inputs.reserve(expr.operands().size());
+        for (auto const *operand : expr.operands())
+        {
+          inputs.push_back(storage<T>(*operand).data());
+        }
+        auto *data_out = storage<T>(out).data();
+
+        parallel_for(
+            0,
+            out.size(),
+            simd_grain_size(),
+            [&](size_t const begin, size_t const end)
+            { eval_chunked(expr, inputs, data_out, begin, end, expr_kernel<T>); }
+        );
+      }
+  );
+}
+
 Buffer SIMDDevice::new_buffer(std::vector<float> data, Shape shape) const
 {
-  auto const size = data.size();
-  return Buffer{
-      HandlePtr{
-          new SIMDBuffer(data.cbegin(), data.cend()),
-          [](void *ptr) -> void
-          { std::default_delete<SIMDBuffer>{}(static_cast<SIMDBuffer *>(ptr)); }
-      },
+  auto buffer = this->new_empty_buffer(shape);
+  std::copy(data.cbegin(), data.cend(), static_cast<SIMDBuffer *>(buffer.get())->begin());
+  return buffer;
+}
+
+Buffer SIMDDevice::new_f64_buffer(std::vector<double> data, Shape shape) const
+{
+  auto buffer = this->new_typed_buffer(shape, DType::F64);
+  std::copy(data.cbegin(), data.cend(), storage<double>(buffer).begin());
+  return buffer;
+}
+
+Buffer SIMDDevice::new_buffer_with_shape(Shape shape) const
+{
+  auto buffer = this->new_empty_buffer(shape);
+  auto &simd_buffer = *static_cast<SIMDBuffer *>(buffer.get());
+  std::fill(simd_buffer.begin(), simd_buffer.end(), 0.0F);
+  return buffer;
+}
+
+Buffer SIMDDevice::new_empty_buffer(Shape shape) const
+{
+  return new_storage(this->m_cache, shape, SIMDDevice::s_type, DType::F32);
+}
+
+SparseBuffer SIMDDevice::new_sell(Shape shape, CsrData csr, size_t sigma) const
+{
+  assert_valid_csr(shape, csr);
+
+  auto const nnz = csr.values.size();
+  return SparseBuffer{
+      std::make_shared<SellData>(sell_from_csr(csr, shape.rows, sigma)),
       shape,
+      nnz,
       SIMDDevice::s_type,
+      SparseFormat::SELL
   };
 }
 
+Buffer SIMDDevice::new_typed_buffer(Shape shape, DType dtype) const
+{
+  switch (dtype)
+  {
+  case DType::F32:
+    return this->new_empty_buffer(shape);
+  case DType::F64:
+    return new_storage(this->m_double_cache, shape, SIMDDevice::s_type, dtype);
+  default:
+    return new_storage(this->m_reduced_cache, shape, SIMDDevice::s_type, dtype);
+  }
+}
+
+void SIMDDevice::convert(Buffer const &from, Buffer &to) const
+{
+  assert_compatible_convert(from, to);
+
+  if (from.dtype() == to.dtype())
+  {
+    this->copy_buffer(from, to);
+    return;
+  }
+
+  // F64 elements go through float to and from the other dtypes, in plain loops that the compiler
+  // vectorises
+  if (to.dtype() == DType::F64)
+  {
+    SIMDBuffer scratch;
+    auto const *src = float_data(from, scratch);
+    auto *dst       = storage<double>(to).data();
+    parallel_for(
+        0,
+        from.size(),
+        simd_grain_size(),
+        [&](size_t const begin, size_t const end)
+        { std::copy(src + begin, src + end, dst + begin); }
+    );
+    return;
+  }
+  if (from.dtype() == DType::F64)
+  {
+    auto const *src = storage<double>(from).data();
+    auto const f32  = to.dtype() == DType::F32;
+    SIMDBuffer scratch(f32 ? 0 : from.size());
+    auto *dst     = f32 ? storage<float>(to).data() : scratch.data();
+    auto *reduced = f32 ? nullptr : static_cast<SIMDReducedBuffer *>(to.get())->data();
+    parallel_for(
+        0,
+        from.size(),
+        simd_grain_size(),
+        [&](size_t const begin, size_t const end)
+        {
+          std::transform(
+              src + begin,
+              src + end,
+              dst + begin,
+              [](double const value) { return static_cast<float>(value); }
+          );
+          if (not f32)
+          {
+            narrow(to.dtype(), dst, reduced, begin, end);
+          }
+        }
+    );
+    return;
+  }
+
+  if (to.dtype() == DType::F32)
+  {
+    auto const *src = static_cast<uint16_t const *>(element_data(from));
+    auto *dst       = static_cast<SIMDBuffer *>(to.get())->data();
+    parallel_for(
+        0,
+        from.size(),
+        simd_grain_size(),
+        [&](size_t const begin, size_t const end) { widen(from.dtype(), src, dst, begin, end); }
+    );
+    return;
+  }
+
+  // Between F16 and BF16 the elements go through float, which holds both exactly
+  SIMDBuffer scratch;
+  auto const *src = float_data(from, scratch);
+  auto *dst       = static_cast<SIMDReducedBuffer *>(to.get())->data();
+  parallel_for(
+      0,
+      from.size(),
+      simd_grain_size(),
+      [&](size_t const begin, size_t const end) { narrow(to.dtype(), src, dst, begin, end); }
+  );
+}
+
+AllocatorStats SIMDDevice::allocator_stats() const
+{
+  auto stats = this->m_cache.stats();
+  stats += this->m_reduced_cache.stats();
+  stats += this->m_double_cache.stats();
+  return stats;
+}
+
+void SIMDDevice::trim() const
+{
+  this->m_cache.trim();
+  this->m_reduced_cache.trim();
+  this->m_double_cache.trim();
+}
+
 void SIMDDevice::copy_buffer(Buffer const &from, Buffer &to) const
 {
   assert_compatible_copy(from, to);
 
-  auto const &simd_from = *static_cast<SIMDBuffer const *>(from.get());
-  auto &simd_to         = *static_cast<SIMDBuffer *>(to.get());
-
-  simd_to = simd_from;
+  switch (from.dtype())
+  {
+  case DType::F32:
+    copy_storage<SIMDBuffer>(from, to);
+    break;
+  case DType::F64:
+    copy_storage<SIMDDoubleBuffer>(from, to);
+    break;
+  default:
+    copy_storage<SIMDReducedBuffer>(from, to);
+    break;
+  }
 }
 
 void SIMDDevice::transpose(Buffer const &from, Buffer &to) const
 {
   assert_compatible_transpose(from, to);
 
-  auto const &simd_from = *static_cast<SIMDBuffer const *>(from.get());
-  auto &simd_to         = *static_cast<SIMDBuffer *>(to.get());
-
   auto const [rows, cols] = from.shape();
-  for (size_t i{0}; i < rows; i++)
+  auto const body         = [&](size_t const row_begin, size_t const row_end)
   {
-    for (size_t j{0}; j < cols; j++)
-    {
-      simd_to[(j * rows) + i] = simd_from[(i * cols) + j];
-    }
+    visit_precision(
+        from.dtype(),
+        [&](auto const precision)
+        {
+          using T = typename decltype(precision)::type;
+          transpose_rows(
+              storage<T>(from).data(), storage<T>(to).data(), rows, cols, row_begin, row_end
+          );
+        }
+    );
+  };
+
+  if (from.size() < parallel_threshold())
+  {
+    body(0, rows);
+    return;
   }
+
+  // Chunks of whole blocks, so that no block is split between two threads
+  auto const block_rows = std::max<size_t>(grain_size() / cols, 1);
+  thread_pool().parallel_for(
+      0,
+      rows,
+      ((block_rows + TRANSPOSE_BLOCK - 1) / TRANSPOSE_BLOCK) * TRANSPOSE_BLOCK,
+      body
+  );
 }
 
 std::vector<float> SIMDDevice::cpu(Buffer const &buffer) const
 {
-  auto simd_buffer = *static_cast<SIMDBuffer const *>(buffer.get());
+  if (buffer.dtype() == DType::F64)
+  {
+    auto const &simd_buffer = storage<double>(buffer);
+    std::vector<float> host(buffer.size());
+    std::transform(
+        simd_buffer.cbegin(),
+        simd_buffer.cend(),
+        host.begin(),
+        [](double const value) { return static_cast<float>(value); }
+    );
+    return host;
+  }
+  if (buffer.dtype() != DType::F32)
+  {
+    std::vector<float> host(buffer.size());
+    auto const *reduced = static_cast<uint16_t const *>(element_data(buffer));
+    widen(buffer.dtype(), reduced, host.data(), 0, host.size());
+    return host;
+  }
+
+  auto const &simd_buffer = *static_cast<SIMDBuffer const *>(buffer.get());
   return {simd_buffer.cbegin(), simd_buffer.cend()};
 }
 
+std::vector<double> SIMDDevice::cpu_f64(Buffer const &buffer) const
+{
+  if (buffer.dtype() == DType::F64)
+  {
+    auto const &simd_buffer = storage<double>(buffer);
+    return {simd_buffer.cbegin(), simd_buffer.cend()};
+  }
+
+  auto const host = this->cpu(buffer);
+  return {host.cbegin(), host.cend()};
+}
+
+float SIMDDevice::read_scalar(Buffer const &buffer) const
+{
+  if (buffer.dtype() == DType::F64)
+  {
+    return static_cast<float>(storage<double>(buffer).front());
+  }
+  if (buffer.dtype() != DType::F32)
+  {
+    auto const front = static_cast<SIMDReducedBuffer const *>(buffer.get())->front();
+    return reduced_to_float(buffer.dtype(), front);
+  }
+  return static_cast<SIMDBuffer const *>(buffer.get())->front();
+}
+
+double SIMDDevice::read_scalar_f64(Buffer const &buffer) const
+{
+  if (buffer.dtype() == DType::F64)
+  {
+    return storage<double>(buffer).front();
+  }
+  return this->read_scalar(buffer);
+}
+
+float *SIMDDevice::host_data(Buffer &buffer) const { return storage<float>(buffer).data(); }
+
 void SIMDDevice::sync(Buffer const &buffer) const {}
 
 } // namespace gpu_playground::backend
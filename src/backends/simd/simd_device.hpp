@@ -1,14 +1,33 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
+#include <xsimd/xsimd.hpp>
+
 #include "device.hpp"
 
 namespace gpu_playground::backend
 {
 
+template <class T>
+using SIMDStorage = std::vector<T, xsimd::aligned_allocator<T>>;
+
+using SIMDBuffer = SIMDStorage<float>;
+
+// Storage of F16 and BF16 buffers
+using SIMDReducedBuffer = SIMDStorage<uint16_t>;
+
+// Storage of F64 buffers
+using SIMDDoubleBuffer = SIMDStorage<double>;
+
 class SIMDDevice final : public Device
 {
 private:
   static constexpr DeviceType s_type{DeviceType::SIMD};
+  CachingAllocator<SIMDBuffer> m_cache;
+  CachingAllocator<SIMDReducedBuffer> m_reduced_cache;
+  CachingAllocator<SIMDDoubleBuffer> m_double_cache;
 
 public:
   SIMDDevice() = default;
@@ -40,14 +59,66 @@ public:
 
   void sdiv(Buffer const &a, Buffer const &b, Buffer &c) const override;
 
+  void dot(Buffer const &a, Buffer const &b, Buffer &c) const override;
+
+  void axpy(Buffer const &alpha, Buffer const &x, Buffer &y) const override;
+
+  void axpby(Buffer const &alpha, Buffer const &x, Buffer const &beta, Buffer &y) const override;
+
+  void spmv(SparseBuffer const &a, Buffer const &x, Buffer &y) const override;
+
+  void spmm(SparseBuffer const &a, Buffer const &x, Buffer &y) const override;
+
+  void
+  batched_mul(Buffer const &a, Buffer const &b, Buffer &c, size_t batch) const override;
+
+  void batched_cg(
+      Buffer const &a, Buffer const &b, Buffer &x, size_t batch, size_t max_iter, float tol
+  ) const override;
+
+  void batched_cholesky(Buffer const &a, Buffer const &b, Buffer &x, size_t batch) const override;
+
+  void broadcast(ExprOp op, Buffer const &a, Buffer const &b, Buffer &c) const override;
+
+  void eval(Expression const &expr, Buffer &out) const override;
+
   [[nodiscard]] Buffer new_buffer(std::vector<float> data, Shape shape) const override;
 
+  [[nodiscard]] Buffer new_f64_buffer(std::vector<double> data, Shape shape) const override;
+
+  [[nodiscard]] Buffer new_buffer_with_shape(Shape shape) const override;
+
+  [[nodiscard]] Buffer new_empty_buffer(Shape shape) const override;
+
+  [[nodiscard]] bool supports_dtype([[maybe_unused]] DType dtype) const override
+  {
+    return true;
+  }
+
+  [[nodiscard]] Buffer new_typed_buffer(Shape shape, DType dtype) const override;
+
+  void convert(Buffer const &from, Buffer &to) const override;
+
+  [[nodiscard]] SparseBuffer new_sell(Shape shape, CsrData csr, size_t sigma) const override;
+
+  [[nodiscard]] AllocatorStats allocator_stats() const override;
+
+  void trim() const override;
+
   void copy_buffer(Buffer const &from, Buffer &to) const override;
 
   void transpose(Buffer const &from, Buffer &to) const override;
 
   [[nodiscard]] std::vector<float> cpu(Buffer const &buffer) const override;
 
+  [[nodiscard]] std::vector<double> cpu_f64(Buffer const &buffer) const override;
+
+  [[nodiscard]] float read_scalar(Buffer const &buffer) const override;
+
+  [[nodiscard]] double read_scalar_f64(Buffer const &buffer) const override;
+
+  [[nodiscard]] float *host_data(Buffer &buffer) const override;
+
   void sync(Buffer const &buffer) const override;
 };
 
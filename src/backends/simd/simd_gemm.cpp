@@ -0,0 +1,523 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include <xsimd/xsimd.hpp>
+
+#include "simd_gemm.hpp"
+#include "simd_kernels.hpp"
+#include "thread_pool.hpp"
+
+namespace gpu_playground::backend
+{
+
+namespace
+{
+
+template <class T>
+using Batch = xsimd::batch<T>;
+
+template <class T>
+using PackBuffer = std::vector<T, xsimd::aligned_allocator<T>>;
+
+template <class T>
+constexpr size_t simd_size = Batch<T>::size;
+
+// Register tile: MR rows by NR columns of C, kept in MR * NB accumulators. NR is in elements, so
+// a double tile is half as wide as a float one.
+constexpr size_t MR = 6;
+constexpr size_t NB = 2;
+template <class T>
+constexpr size_t NR = NB * simd_size<T>;
+
+// Cache blocks: a KC x NR sliver of packed B lives in L1, an MC x KC block of packed A in L2
+// and a KC x NC panel of packed B in L3.
+constexpr size_t KC = 256;
+constexpr size_t MC = 144;
+constexpr size_t NC = 3072;
+
+// Rows of A packed at once and shared by all threads.
+constexpr size_t MB = 16 * MC;
+
+// Products smaller than this many multiply-adds stay on the calling thread.
+constexpr size_t MIN_PARALLEL_FLOPS = size_t{1} << 21;
+
+static_assert(MC % MR == 0, "MC must be a multiple of MR");
+static_assert(NC % NR<float> == 0 and NC % NR<double> == 0, "NC must be a multiple of NR");
+
+constexpr size_t round_up(size_t const value, size_t const multiple)
+{
+  return ((value + multiple - 1) / multiple) * multiple;
+}
+
+template <class T>
+GemmOperand<T> offset(GemmOperand<T> const op, size_t const i, size_t const j)
+{
+  return {op.data + (i * op.rs) + (j * op.cs), op.rs, op.cs};
+}
+
+// Packs MR-row slivers [first, last) of an (m x kc) block of A, each stored column by column and
+// padded with zeros up to MR rows.
+template <class T>
+void pack_a(
+    size_t const m,
+    size_t const kc,
+    GemmOperand<T> const a,
+    T *packed,
+    size_t const first,
+    size_t const last
+)
+{
+  for (size_t s{first}; s < last; s++)
+  {
+    auto const ir = s * MR;
+    auto const mr = std::min(MR, m - ir);
+    T *dst        = packed + (ir * kc);
+    for (size_t p{0}; p < kc; p++)
+    {
+      for (size_t r{0}; r < mr; r++)
+      {
+        dst[r] = a.data[((ir + r) * a.rs) + (p * a.cs)];
+      }
+      std::fill(dst + mr, dst + MR, T{0.0});
+      dst += MR;
+    }
+  }
+}
+
+// Packs NR-column slivers [first, last) of a (kc x nc) block of B, each stored row by row and
+// padded with zeros up to NR columns.
+template <class T>
+void pack_b(
+    size_t const kc,
+    size_t const nc,
+    GemmOperand<T> const b,
+    T *packed,
+    size_t const first,
+    size_t const last
+)
+{
+  for (size_t s{first}; s < last; s++)
+  {
+    auto const jr = s * NR<T>;
+    auto const nr = std::min(NR<T>, nc - jr);
+    T *dst        = packed + (jr * kc);
+    for (size_t p{0}; p < kc; p++)
+    {
+      T const *src = b.data + (p * b.rs) + (jr * b.cs);
+      if (nr == NR<T> and b.cs == 1)
+      {
+        for (size_t j{0}; j < NR<T>; j += simd_size<T>)
+        {
+          Batch<T>::load_unaligned(src + j).store_aligned(dst + j);
+        }
+      }
+      else
+      {
+        for (size_t j{0}; j < nr; j++)
+        {
+          dst[j] = src[j * b.cs];
+        }
+        std::fill(dst + nr, dst + NR<T>, T{0.0});
+      }
+      dst += NR<T>;
+    }
+  }
+}
+
+// Computes an (mr x nr) tile of C from an MR-row sliver of packed A and an NR-column sliver of
+// packed B, either overwriting C or accumulating into it.
+template <class T>
+void micro_kernel(
+    size_t const kc,
+    T const *a,
+    T const *b,
+    T *c,
+    size_t const ldc,
+    size_t const mr,
+    size_t const nr,
+    bool const accumulate
+)
+{
+  std::array<Batch<T>, MR * NB> acc;
+  acc.fill(Batch<T>(T{0.0}));
+
+  for (size_t p{0}; p < kc; p++)
+  {
+    std::array<Batch<T>, NB> b_p;
+    for (size_t j{0}; j < NB; j++)
+    {
+      b_p[j] = Batch<T>::load_aligned(b + (p * NR<T>) + (j * simd_size<T>));
+    }
+    for (size_t i{0}; i < MR; i++)
+    {
+      auto const a_ip = Batch<T>(a[(p * MR) + i]);
+      for (size_t j{0}; j < NB; j++)
+      {
+        acc[(i * NB) + j] = xsimd::fma(a_ip, b_p[j], acc[(i * NB) + j]);
+      }
+    }
+  }
+
+  if (mr == MR and nr == NR<T>)
+  {
+    for (size_t i{0}; i < MR; i++)
+    {
+      for (size_t j{0}; j < NB; j++)
+      {
+        T *dst   = c + (i * ldc) + (j * simd_size<T>);
+        auto res = acc[(i * NB) + j];
+        if (accumulate)
+        {
+          res += Batch<T>::load_unaligned(dst);
+        }
+        res.store_unaligned(dst);
+      }
+    }
+    return;
+  }
+
+  std::array<T, MR * NR<T>> tile;
+  for (size_t i{0}; i < MR; i++)
+  {
+    for (size_t j{0}; j < NB; j++)
+    {
+      acc[(i * NB) + j].store_unaligned(&tile[(i * NR<T>) + (j * simd_size<T>)]);
+    }
+  }
+  for (size_t i{0}; i < mr; i++)
+  {
+    for (size_t j{0}; j < nr; j++)
+    {
+      auto const res     = tile[(i * NR<T>) + j];
+      c[(i * ldc) + j] = accumulate ? c[(i * ldc) + j] + res : res;
+    }
+  }
+}
+
+// Multiplies the (mc x kc) block of packed A by the (kc x nc) block of packed B into C, in
+// MC-row chunks so that the slivers of A being reused stay in L2.
+template <class T>
+void macro_kernel(
+    size_t const mc,
+    size_t const nc,
+    size_t const kc,
+    T const *packed_a,
+    T const *packed_b,
+    T *c,
+    size_t const ldc,
+    bool const accumulate
+)
+{
+  for (size_t ic{0}; ic < mc; ic += MC)
+  {
+    auto const mb = std::min(MC, mc - ic);
+    for (size_t jr{0}; jr < nc; jr += NR<T>)
+    {
+      auto const nr = std::min(NR<T>, nc - jr);
+      for (size_t ir{ic}; ir < ic + mb; ir += MR)
+      {
+        auto const mr = std::min(MR, mc - ir);
+        micro_kernel(
+            kc,
+            packed_a + (ir * kc),
+            packed_b + (jr * kc),
+            c + (ir * ldc) + jr,
+            ldc,
+            mr,
+            nr,
+            accumulate
+        );
+      }
+    }
+  }
+}
+
+// Splits an (m x n) block of C into a ways_m x ways_n grid of tiles for the thread pool. The
+// grid follows the aspect ratio of the block, so tall-skinny products are split along M and
+// short-wide ones along N.
+struct Partition
+{
+  size_t tile_m{0};
+  size_t tile_n{0};
+  size_t ways_m{1};
+  size_t ways_n{1};
+};
+
+template <class T>
+Partition partition(size_t const m, size_t const n, size_t const threads)
+{
+  auto const units_m = (m + MR - 1) / MR;
+  auto const units_n = (n + NR<T> - 1) / NR<T>;
+  auto const tasks   = static_cast<double>(threads * 4);
+
+  auto const ideal_m = std::sqrt(tasks * static_cast<double>(m) / static_cast<double>(n));
+  auto const ways_m  = std::clamp<size_t>(static_cast<size_t>(std::lround(ideal_m)), 1, units_m);
+  auto const ways_n  = std::clamp<size_t>(
+      static_cast<size_t>(std::ceil(tasks / static_cast<double>(ways_m))), 1, units_n
+  );
+
+  Partition part;
+  part.tile_m = ((units_m + ways_m - 1) / ways_m) * MR;
+  part.tile_n = ((units_n + ways_n - 1) / ways_n) * NR<T>;
+  part.ways_m = (m + part.tile_m - 1) / part.tile_m;
+  part.ways_n = (n + part.tile_n - 1) / part.tile_n;
+
+  return part;
+}
+
+// Loads of the rows of an A with contiguous rows
+template <class T>
+auto row_loads(GemmOperand<T> const a)
+{
+  return [a](size_t const i) { return ContiguousLoad<T>{a.data + (i * a.rs)}; };
+}
+
+// y[first, last) = sum_p x[p] * A[first:last, p] for an A with contiguous columns, adding
+// GEMV_BLOCK columns at a time to cut the traffic on y.
+template <class T>
+void gemv_cols(
+    size_t const first,
+    size_t const last,
+    size_t const n,
+    GemmOperand<T> const a,
+    T const *x,
+    T *y
+)
+{
+  auto const vec_last = first + ((last - first) - ((last - first) % simd_size<T>));
+  std::fill(y + first, y + last, T{0.0});
+
+  size_t p{0};
+  for (; p + GEMV_BLOCK <= n; p += GEMV_BLOCK)
+  {
+    std::array<T const *, GEMV_BLOCK> cols;
+    std::array<Batch<T>, GEMV_BLOCK> x_p;
+    for (size_t c{0}; c < GEMV_BLOCK; c++)
+    {
+      cols[c] = a.data + ((p + c) * a.cs);
+      x_p[c]  = Batch<T>(x[p + c]);
+    }
+
+    for (size_t i{first}; i < vec_last; i += simd_size<T>)
+    {
+      auto y_i = Batch<T>::load_unaligned(y + i);
+      for (size_t c{0}; c < GEMV_BLOCK; c++)
+      {
+        y_i = xsimd::fma(Batch<T>::load_unaligned(cols[c] + i), x_p[c], y_i);
+      }
+      y_i.store_unaligned(y + i);
+    }
+    for (size_t i{vec_last}; i < last; i++)
+    {
+      for (size_t c{0}; c < GEMV_BLOCK; c++)
+      {
+        y[i] = std::fma(cols[c][i], x[p + c], y[i]);
+      }
+    }
+  }
+  for (; p < n; p++)
+  {
+    T const *col = a.data + (p * a.cs);
+    for (size_t i{first}; i < last; i++)
+    {
+      y[i] = std::fma(col[i], x[p], y[i]);
+    }
+  }
+}
+
+// C = A * B on up to `threads` threads, see `gemm`
+template <class T>
+void gemm_blocked(
+    size_t const m,
+    size_t const n,
+    size_t const k,
+    GemmOperand<T> const a,
+    GemmOperand<T> const b,
+    T *c,
+    size_t const ldc,
+    size_t const threads
+)
+{
+  if (k == 0)
+  {
+    for (size_t i{0}; i < m; i++)
+    {
+      std::fill(c + (i * ldc), c + (i * ldc) + n, T{0.0});
+    }
+    return;
+  }
+
+  auto const run = [threads](size_t const count, auto const &fn)
+  {
+    if (threads == 1)
+    {
+      fn(0, count);
+      return;
+    }
+    thread_pool().parallel_for(0, count, 1, fn);
+  };
+
+  // All threads share the packed panels: B is packed once per (KC x NC) panel and A once per
+  // (MB x KC) block, each of them cooperatively, and only then split into tiles of C.
+  auto const mb_max = std::min(MB, round_up(m, MR));
+  auto const nc_max = std::min(NC, round_up(n, NR<T>));
+  PackBuffer<T> packed_a(mb_max * std::min(KC, k));
+  PackBuffer<T> packed_b(nc_max * std::min(KC, k));
+
+  for (size_t jc{0}; jc < n; jc += NC)
+  {
+    auto const nc      = std::min(NC, n - jc);
+    auto const b_count = (nc + NR<T> - 1) / NR<T>;
+
+    for (size_t pc{0}; pc < k; pc += KC)
+    {
+      auto const kc = std::min(KC, k - pc);
+
+      for (size_t ic{0}; ic < m; ic += MB)
+      {
+        auto const mb      = std::min(MB, m - ic);
+        auto const a_count = (mb + MR - 1) / MR;
+        auto const b_todo  = ic == 0 ? b_count : 0;
+
+        run(b_todo + a_count,
+            [&](size_t const first, size_t const last)
+            {
+              for (size_t s{first}; s < last; s++)
+              {
+                if (s < b_todo)
+                {
+                  pack_b(kc, nc, offset(b, pc, jc), packed_b.data(), s, s + 1);
+                }
+                else
+                {
+                  pack_a(mb, kc, offset(a, ic, pc), packed_a.data(), s - b_todo, s - b_todo + 1);
+                }
+              }
+            });
+
+        auto const part = partition<T>(mb, nc, threads);
+        run(part.ways_m * part.ways_n,
+            [&](size_t const first, size_t const last)
+            {
+              for (size_t t{first}; t < last; t++)
+              {
+                auto const ir = (t / part.ways_n) * part.tile_m;
+                auto const jr = (t % part.ways_n) * part.tile_n;
+                macro_kernel(
+                    std::min(part.tile_m, mb - ir),
+                    std::min(part.tile_n, nc - jr),
+                    kc,
+                    packed_a.data() + (ir * kc),
+                    packed_b.data() + (jr * kc),
+                    c + ((ic + ir) * ldc) + jc + jr,
+                    ldc,
+                    pc != 0
+                );
+              }
+            });
+      }
+    }
+  }
+}
+
+} // namespace
+
+template <class T>
+void gemm(
+    size_t const m,
+    size_t const n,
+    size_t const k,
+    GemmOperand<T> const a,
+    GemmOperand<T> const b,
+    T *c,
+    size_t const ldc
+)
+{
+  gemm_blocked(m, n, k, a, b, c, ldc, m * n * k < MIN_PARALLEL_FLOPS ? 1 : num_threads());
+}
+
+template void
+gemm(size_t, size_t, size_t, GemmOperand<float>, GemmOperand<float>, float *, size_t);
+template void
+gemm(size_t, size_t, size_t, GemmOperand<double>, GemmOperand<double>, double *, size_t);
+
+void batched_gemm(
+    size_t const batch,
+    size_t const m,
+    size_t const n,
+    size_t const k,
+    float const *a,
+    float const *b,
+    float *c
+)
+{
+  // Every product runs on a single thread, the batch is what gets split between threads
+  auto const body = [&](size_t const first, size_t const last)
+  {
+    for (size_t i{first}; i < last; i++)
+    {
+      GemmOperand const a_i{a + (i * m * k), k, 1};
+      auto const *b_i = b + (i * k * n);
+      auto *c_i       = c + (i * m * n);
+      if (n == 1)
+      {
+        gemv_rows(0, m, k, row_loads(a_i), b_i, c_i);
+        continue;
+      }
+      gemm_blocked(m, n, k, a_i, GemmOperand{b_i, n, 1}, c_i, n, 1);
+    }
+  };
+
+  auto const flops = std::max<size_t>(m * n * k, 1);
+  if (batch * flops < MIN_PARALLEL_FLOPS)
+  {
+    body(0, batch);
+    return;
+  }
+  // Tasks of a few products each when they are tiny, so that scheduling does not dominate
+  auto const grain = std::max<size_t>((MIN_PARALLEL_FLOPS / 16) / flops, 1);
+  thread_pool().parallel_for(0, batch, grain, body);
+}
+
+template <class T>
+void gemv(size_t const m, size_t const n, GemmOperand<T> const a, T const *x, T *y)
+{
+  auto const body = [&](size_t const first, size_t const last)
+  {
+    if (a.cs == 1)
+    {
+      gemv_rows(first, last, n, row_loads(a), x, y);
+    }
+    else if (a.rs == 1)
+    {
+      gemv_cols(first, last, n, a, x, y);
+    }
+    else
+    {
+      for (size_t i{first}; i < last; i++)
+      {
+        T res{0.0};
+        for (size_t p{0}; p < n; p++)
+        {
+          res = std::fma(a.data[(i * a.rs) + (p * a.cs)], x[p], res);
+        }
+        y[i] = res;
+      }
+    }
+  };
+
+  if (m * n < parallel_threshold())
+  {
+    body(0, m);
+    return;
+  }
+  auto const rows = std::max<size_t>(grain_size() / std::max<size_t>(n, 1), 1);
+  thread_pool().parallel_for(0, m, round_up(rows, GEMV_BLOCK), body);
+}
+
+template void gemv(size_t, size_t, GemmOperand<float>, float const *, float *);
+template void gemv(size_t, size_t, GemmOperand<double>, double const *, double *);
+
+} // namespace gpu_playground::backend
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+namespace gpu_playground::backend
+{
+
+// Operand of a GEMM: element (i, j) lives at data[(i * rs) + (j * cs)].
+template <class T>
+struct GemmOperand
+{
+  T const *data{nullptr};
+  size_t rs{0};
+  size_t cs{1};
+};
+
+template <class T>
+GemmOperand(T const *, size_t, size_t) -> GemmOperand<T>;
+
+// Computes C = A * B, with A of shape (m x k), B of shape (k x n) and C a row-major (m x n)
+// matrix with leading dimension ldc. A and B are packed into contiguous panels, blocked for
+// the cache hierarchy, and multiplied by a register-tiled micro-kernel. T is float or double.
+template <class T>
+void gemm(size_t m, size_t n, size_t k, GemmOperand<T> a, GemmOperand<T> b, T *c, size_t ldc);
+
+// Computes C_i = A_i * B_i for i < batch, with the row-major A_i (m x k), B_i (k x n) and
+// C_i (m x n) stored one after the other in a, b and c. The batch is split between threads.
+void batched_gemm(
+    size_t batch, size_t m, size_t n, size_t k, float const *a, float const *b, float *c
+);
+
+// Computes y = A * x, with A of shape (m x n) and x, y contiguous. Row-major A is reduced with
+// row-blocked dot products, A with contiguous columns is accumulated column by column. T is
+// float or double.
+template <class T>
+void gemv(size_t m, size_t n, GemmOperand<T> a, T const *x, T *y);
+
+} // namespace gpu_playground::backend
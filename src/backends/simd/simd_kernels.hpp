@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#include <xsimd/xsimd.hpp>
+
+namespace gpu_playground::backend
+{
+
+// Reductions shared by the SIMD kernels. They read their operands through loads: load(i) returns
+// the batch starting at element i and load[i] the single element i, so that the same kernel reads
+// float or double elements as they are and widens 16-bit ones as it goes.
+
+// Rows (or columns) of A handled together by the GEMVs, sharing every load of x (or y).
+inline constexpr size_t GEMV_BLOCK = 4;
+
+// Loads of contiguous T elements
+template <class T>
+struct ContiguousLoad
+{
+  T const *data;
+
+  [[nodiscard]] xsimd::batch<T> operator()(size_t const i) const
+  {
+    return xsimd::batch<T>::load_unaligned(this->data + i);
+  }
+
+  [[nodiscard]] T operator[](size_t const i) const { return this->data[i]; }
+};
+
+template <class T>
+ContiguousLoad(T const *) -> ContiguousLoad<T>;
+
+using FloatLoad = ContiguousLoad<float>;
+
+// Element type produced by a load
+template <class Load>
+using load_value_t = std::decay_t<decltype(std::declval<Load const &>()[0])>;
+
+// Dot product of [begin, end) using several independent accumulators, so that consecutive fmas
+// do not wait on each other.
+template <class LoadA, class LoadB>
+load_value_t<LoadA> dot_range(LoadA const &a, LoadB const &b, size_t const begin, size_t const end)
+{
+  using T = load_value_t<LoadA>;
+  static_assert(std::is_same_v<T, load_value_t<LoadB>>, "Both loads must produce the same type");
+
+  constexpr size_t width  = xsimd::batch<T>::size;
+  constexpr size_t unroll = 4;
+  constexpr size_t step   = unroll * width;
+
+  std::array<xsimd::batch<T>, unroll> acc;
+  acc.fill(xsimd::batch<T>(T{0.0}));
+
+  size_t i{begin};
+  for (; i + step <= end; i += step)
+  {
+    for (size_t u{0}; u < unroll; u++)
+    {
+      acc[u] = xsimd::fma(a(i + (u * width)), b(i + (u * width)), acc[u]);
+    }
+  }
+  for (; i + width <= end; i += width)
+  {
+    acc[0] = xsimd::fma(a(i), b(i), acc[0]);
+  }
+
+  T res = xsimd::reduce_add((acc[0] + acc[1]) + (acc[2] + acc[3]));
+  for (; i < end; i++)
+  {
+    res = std::fma(a[i], b[i], res);
+  }
+
+  return res;
+}
+
+// y[i] = A[i, :] . x for rows [first, last), GEMV_BLOCK rows at a time with one accumulator each.
+// row(i) returns the load of row i of A.
+template <class T, class RowLoad>
+void gemv_rows(
+    size_t const first,
+    size_t const last,
+    size_t const n,
+    RowLoad const &row,
+    T const *x,
+    T *y
+)
+{
+  using Row = std::decay_t<decltype(row(first))>;
+  static_assert(std::is_same_v<load_value_t<Row>, T>, "Rows of A must load the type of x");
+
+  constexpr size_t width = xsimd::batch<T>::size;
+  auto const vec_n       = n - (n % width);
+
+  size_t i{first};
+  for (; i + GEMV_BLOCK <= last; i += GEMV_BLOCK)
+  {
+    std::array<Row, GEMV_BLOCK> rows;
+    std::array<xsimd::batch<T>, GEMV_BLOCK> acc;
+    for (size_t r{0}; r < GEMV_BLOCK; r++)
+    {
+      rows[r] = row(i + r);
+      acc[r]  = xsimd::batch<T>(T{0.0});
+    }
+
+    for (size_t p{0}; p < vec_n; p += width)
+    {
+      auto const x_p = xsimd::batch<T>::load_unaligned(x + p);
+      for (size_t r{0}; r < GEMV_BLOCK; r++)
+      {
+        acc[r] = xsimd::fma(rows[r](p), x_p, acc[r]);
+      }
+    }
+
+    for (size_t r{0}; r < GEMV_BLOCK; r++)
+    {
+      T res = xsimd::reduce_add(acc[r]);
+      for (size_t p{vec_n}; p < n; p++)
+      {
+        res = std::fma(rows[r][p], x[p], res);
+      }
+      y[i + r] = res;
+    }
+  }
+  for (; i < last; i++)
+  {
+    y[i] = dot_range(row(i), ContiguousLoad<T>{x}, 0, n);
+  }
+}
+
+} // namespace gpu_playground::backend
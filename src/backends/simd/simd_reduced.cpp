@@ -0,0 +1,235 @@
+#include <algorithm>
+
+#include <xsimd/xsimd.hpp>
+
+#include "simd_kernels.hpp"
+#include "simd_reduced.hpp"
+#include "thread_pool.hpp"
+
+namespace gpu_playground::backend
+{
+
+namespace
+{
+
+using Batch  = xsimd::batch<float>;
+using UBatch = xsimd::batch<uint32_t>;
+
+constexpr size_t simd_size = Batch::size;
+
+static_assert(UBatch::size == simd_size, "Float and bit batches must have the same size");
+
+constexpr size_t round_up(size_t const value, size_t const multiple)
+{
+  return ((value + multiple - 1) / multiple) * multiple;
+}
+
+// `half_to_float` on every lane, with the special cases picked by masks instead of branches
+Batch widen_half(UBatch const value)
+{
+  UBatch const shifted_exp(uint32_t{0x7c00} << 13);
+  UBatch const exp_adjust(uint32_t{127 - 15} << 23);
+
+  auto bits            = (value & UBatch(0x7fffU)) << 13;
+  auto const exp       = bits & shifted_exp;
+  bits                 = bits + exp_adjust;
+  auto const subnormal = xsimd::bitwise_cast<uint32_t>(
+      xsimd::bitwise_cast<float>(bits + UBatch(1U << 23)) - Batch(bits_float(113U << 23))
+  );
+  bits = xsimd::select(exp == shifted_exp, bits + exp_adjust, bits);
+  bits = xsimd::select(exp == UBatch(0U), subnormal, bits);
+  return xsimd::bitwise_cast<float>(bits | ((value & UBatch(0x8000U)) << 16));
+}
+
+// `float_to_half` on every lane, the result in the low 16 bits
+UBatch narrow_half(Batch const value)
+{
+  UBatch const f32_inf(255U << 23);
+  UBatch const f16_overflow((127U + 16) << 23);
+  UBatch const f16_normal(113U << 23);
+  UBatch const denorm_magic(((127U - 15) + (23 - 10) + 1) << 23);
+
+  auto bits       = xsimd::bitwise_cast<uint32_t>(value);
+  auto const sign = bits & UBatch(0x80000000U);
+  bits            = bits ^ sign;
+
+  auto const special   = xsimd::select(bits > f32_inf, UBatch(0x7e00U), UBatch(0x7c00U));
+  auto const subnormal = xsimd::bitwise_cast<uint32_t>(
+                             xsimd::bitwise_cast<float>(bits) +
+                             xsimd::bitwise_cast<float>(denorm_magic)
+                         ) -
+                         denorm_magic;
+  auto const odd    = (bits >> 13) & UBatch(1U);
+  auto const normal = (bits - UBatch((127U - 15) << 23) + UBatch(0xfffU) + odd) >> 13;
+
+  auto res = xsimd::select(bits < f16_normal, subnormal, normal);
+  res      = xsimd::select(bits >= f16_overflow, special, res);
+  return res | (sign >> 16);
+}
+
+Batch widen_bfloat16(UBatch const value) { return xsimd::bitwise_cast<float>(value << 16); }
+
+// `float_to_bfloat16` on every lane, the result in the low 16 bits
+UBatch narrow_bfloat16(Batch const value)
+{
+  auto const bits    = xsimd::bitwise_cast<uint32_t>(value);
+  auto const odd     = (bits >> 16) & UBatch(1U);
+  auto const rounded = (bits + UBatch(0x7fffU) + odd) >> 16;
+  auto const nan     = (bits & UBatch(0x7fffffffU)) > UBatch(0x7f800000U);
+  return xsimd::select(nan, (bits >> 16) | UBatch(0x40U), rounded);
+}
+
+// Loads of 16-bit elements, zero-extended to 32-bit lanes and widened
+template <DType dtype>
+struct ReducedLoad
+{
+  uint16_t const *data;
+
+  [[nodiscard]] Batch operator()(size_t const i) const
+  {
+    auto const bits = UBatch::load_unaligned(this->data + i);
+    if constexpr (dtype == DType::F16)
+    {
+      return widen_half(bits);
+    }
+    else
+    {
+      return widen_bfloat16(bits);
+    }
+  }
+
+  [[nodiscard]] float operator[](size_t const i) const
+  {
+    return reduced_to_float(dtype, this->data[i]);
+  }
+};
+
+// Calls fn with the loads of `data`, so that kernels are instantiated once per dtype
+template <class Fn>
+void visit_load(DType const dtype, void const *data, Fn const &fn)
+{
+  switch (dtype)
+  {
+  case DType::F16:
+    fn(ReducedLoad<DType::F16>{static_cast<uint16_t const *>(data)});
+    break;
+  case DType::BF16:
+    fn(ReducedLoad<DType::BF16>{static_cast<uint16_t const *>(data)});
+    break;
+  default:
+    fn(FloatLoad{static_cast<float const *>(data)});
+    break;
+  }
+}
+
+template <DType dtype>
+void narrow_range(float const *src, uint16_t *dst, size_t const begin, size_t const end)
+{
+  size_t i{begin};
+  for (; i + simd_size <= end; i += simd_size)
+  {
+    auto const value = Batch::load_unaligned(src + i);
+    if constexpr (dtype == DType::F16)
+    {
+      narrow_half(value).store_unaligned(dst + i);
+    }
+    else
+    {
+      narrow_bfloat16(value).store_unaligned(dst + i);
+    }
+  }
+  for (; i < end; i++)
+  {
+    dst[i] = float_to_reduced(dtype, src[i]);
+  }
+}
+
+} // namespace
+
+void widen(
+    DType const dtype, uint16_t const *src, float *dst, size_t const begin, size_t const end
+)
+{
+  visit_load(
+      dtype,
+      src,
+      [&](auto const load)
+      {
+        size_t i{begin};
+        for (; i + simd_size <= end; i += simd_size)
+        {
+          load(i).store_unaligned(dst + i);
+        }
+        for (; i < end; i++)
+        {
+          dst[i] = load[i];
+        }
+      }
+  );
+}
+
+void narrow(
+    DType const dtype, float const *src, uint16_t *dst, size_t const begin, size_t const end
+)
+{
+  if (dtype == DType::F16)
+  {
+    narrow_range<DType::F16>(src, dst, begin, end);
+  }
+  else
+  {
+    narrow_range<DType::BF16>(src, dst, begin, end);
+  }
+}
+
+float mixed_dot(
+    DType const a_type,
+    void const *a,
+    DType const b_type,
+    void const *b,
+    size_t const begin,
+    size_t const end
+)
+{
+  float res{0.0};
+  visit_load(
+      a_type,
+      a,
+      [&](auto const load_a)
+      {
+        visit_load(
+            b_type, b, [&](auto const load_b) { res = dot_range(load_a, load_b, begin, end); }
+        );
+      }
+  );
+  return res;
+}
+
+void reduced_gemv(
+    DType const dtype, size_t const m, size_t const n, uint16_t const *a, float const *x, float *y
+)
+{
+  auto const body = [&](size_t const first, size_t const last)
+  {
+    if (dtype == DType::F16)
+    {
+      auto const row = [&](size_t const i) { return ReducedLoad<DType::F16>{a + (i * n)}; };
+      gemv_rows(first, last, n, row, x, y);
+    }
+    else
+    {
+      auto const row = [&](size_t const i) { return ReducedLoad<DType::BF16>{a + (i * n)}; };
+      gemv_rows(first, last, n, row, x, y);
+    }
+  };
+
+  if (m * n < parallel_threshold())
+  {
+    body(0, m);
+    return;
+  }
+  auto const rows = std::max<size_t>(grain_size() / std::max<size_t>(n, 1), 1);
+  thread_pool().parallel_for(0, m, round_up(rows, GEMV_BLOCK), body);
+}
+
+} // namespace gpu_playground::backend
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "dtype.hpp"
+
+namespace gpu_playground::backend
+{
+
+// Kernels on F16 and BF16 storage, which widen the 16-bit elements to float in registers as they
+// load them, so that every sum is accumulated in float.
+
+// dst = src over elements [begin, end), src holding `dtype` elements
+void widen(DType dtype, uint16_t const *src, float *dst, size_t begin, size_t end);
+
+// dst = src over elements [begin, end), rounded to nearest even to `dtype`
+void narrow(DType dtype, float const *src, uint16_t *dst, size_t begin, size_t end);
+
+// Sum of a[i] * b[i] over [begin, end), where each of a and b holds elements of its own dtype
+float mixed_dot(
+    DType a_type, void const *a, DType b_type, void const *b, size_t begin, size_t end
+);
+
+// Computes y = A * x, with A a row-major (m x n) matrix of `dtype` elements and x, y float.
+// Rows are reduced as in `gemv`, each block of rows reading x once.
+void reduced_gemv(DType dtype, size_t m, size_t n, uint16_t const *a, float const *x, float *y);
+
+} // namespace gpu_playground::backend
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include <xsimd/xsimd.hpp>
+
+#include "simd_sparse.hpp"
+
+namespace gpu_playground::backend
+{
+
+namespace
+{
+
+using Batch      = xsimd::batch<float>;
+using IndexBatch = xsimd::batch<CsrIndex>;
+
+constexpr size_t simd_size = Batch::size;
+
+static_assert(IndexBatch::size == simd_size, "Index and value batches must have the same size");
+
+// y_row += value * x_row, over s entries
+void accumulate_row(float const value, float const *x_row, float *y_row, size_t const s)
+{
+  Batch const scale(value);
+  size_t j{0};
+  for (; j + simd_size <= s; j += simd_size)
+  {
+    xsimd::fma(scale, Batch::load_unaligned(x_row + j), Batch::load_unaligned(y_row + j))
+        .store_unaligned(y_row + j);
+  }
+  for (; j < s; j++)
+  {
+    y_row[j] = std::fma(value, x_row[j], y_row[j]);
+  }
+}
+
+} // namespace
+
+SellData sell_from_csr(CsrData const &csr, size_t const rows, size_t const sigma)
+{
+  auto const row_len = [&](CsrIndex const i) -> size_t
+  { return static_cast<size_t>(csr.row_ptr[i + 1] - csr.row_ptr[i]); };
+
+  SellData sell;
+  sell.rows = rows;
+
+  // Sorting within windows keeps rows of similar length together without moving them far from
+  // their neighbours, so that the accesses to x stay local.
+  auto const chunks = (rows + simd_size - 1) / simd_size;
+  auto const window = std::max<size_t>((sigma + simd_size - 1) / simd_size, 1) * simd_size;
+  sell.perm.resize(chunks * simd_size);
+  std::iota(sell.perm.begin(), sell.perm.begin() + static_cast<std::ptrdiff_t>(rows), 0);
+  for (size_t first{0}; first < rows; first += window)
+  {
+    auto const last = std::min(first + window, rows);
+    std::stable_sort(
+        sell.perm.begin() + static_cast<std::ptrdiff_t>(first),
+        sell.perm.begin() + static_cast<std::ptrdiff_t>(last),
+        [&](CsrIndex const lhs, CsrIndex const rhs) { return row_len(lhs) > row_len(rhs); }
+    );
+  }
+
+  sell.chunk_ptr.assign(chunks + 1, 0);
+  sell.chunk_len.assign(chunks, 0);
+  for (size_t c{0}; c < chunks; c++)
+  {
+    for (size_t r{0}; r < simd_size and (c * simd_size) + r < rows; r++)
+    {
+      sell.chunk_len[c] = std::max(sell.chunk_len[c], row_len(sell.perm[(c * simd_size) + r]));
+    }
+    sell.chunk_ptr[c + 1] = sell.chunk_ptr[c] + (sell.chunk_len[c] * simd_size);
+  }
+
+  sell.col_idx.assign(sell.chunk_ptr.back(), 0);
+  sell.values.assign(sell.chunk_ptr.back(), 0.0F);
+  for (size_t c{0}; c < chunks; c++)
+  {
+    for (size_t r{0}; r < simd_size and (c * simd_size) + r < rows; r++)
+    {
+      auto const row   = sell.perm[(c * simd_size) + r];
+      auto const begin = static_cast<size_t>(csr.row_ptr[row]);
+      for (size_t j{0}; j < row_len(row); j++)
+      {
+        auto const k    = sell.chunk_ptr[c] + (j * simd_size) + r;
+        sell.col_idx[k] = csr.col_idx[begin + j];
+        sell.values[k]  = csr.values[begin + j];
+      }
+    }
+  }
+
+  return sell;
+}
+
+void sell_spmv(
+    SellData const &a, float const *x, float *y, size_t const chunk_begin, size_t const chunk_end
+)
+{
+  std::array<float, simd_size> res{};
+  for (size_t c{chunk_begin}; c < chunk_end; c++)
+  {
+    Batch acc(0.0F);
+    for (size_t k{a.chunk_ptr[c]}; k < a.chunk_ptr[c + 1]; k += simd_size)
+    {
+      auto const cols = IndexBatch::load_aligned(&a.col_idx[k]);
+      acc             = xsimd::fma(Batch::load_aligned(&a.values[k]), Batch::gather(x, cols), acc);
+    }
+
+    acc.store_unaligned(res.data());
+    auto const first = c * simd_size;
+    auto const count = std::min(simd_size, a.rows - first);
+    for (size_t r{0}; r < count; r++)
+    {
+      y[a.perm[first + r]] = res[r];
+    }
+  }
+}
+
+void csr_spmm(
+    CsrData const &a,
+    float const *x,
+    float *y,
+    size_t const s,
+    size_t const row_begin,
+    size_t const row_end
+)
+{
+  for (size_t i{row_begin}; i < row_end; i++)
+  {
+    auto *y_row = y + (i * s);
+    std::fill(y_row, y_row + s, 0.0F);
+    auto const end = static_cast<size_t>(a.row_ptr[i + 1]);
+    for (auto k = static_cast<size_t>(a.row_ptr[i]); k < end; k++)
+    {
+      accumulate_row(a.values[k], x + (static_cast<size_t>(a.col_idx[k]) * s), y_row, s);
+    }
+  }
+}
+
+void sell_spmm(
+    SellData const &a,
+    float const *x,
+    float *y,
+    size_t const s,
+    size_t const chunk_begin,
+    size_t const chunk_end
+)
+{
+  for (size_t c{chunk_begin}; c < chunk_end; c++)
+  {
+    auto const first = c * simd_size;
+    auto const count = std::min(simd_size, a.rows - first);
+    for (size_t r{0}; r < count; r++)
+    {
+      auto *y_row = y + (static_cast<size_t>(a.perm[first + r]) * s);
+      std::fill(y_row, y_row + s, 0.0F);
+      for (size_t k{a.chunk_ptr[c] + r}; k < a.chunk_ptr[c + 1]; k += simd_size)
+      {
+        accumulate_row(a.values[k], x + (static_cast<size_t>(a.col_idx[k]) * s), y_row, s);
+      }
+    }
+  }
+}
+
+} // namespace gpu_playground::backend
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <xsimd/xsimd.hpp>
+
+#include "sparse_buffer.hpp"
+
+namespace gpu_playground::backend
+{
+
+// SELL-C-sigma storage with C the SIMD width. Chunk c holds rows perm[c * C .. (c + 1) * C) in
+// column-major order: entry j of its r-th row sits at chunk_ptr[c] + (j * C) + r. Rows shorter
+// than the chunk are padded with zeros in column 0.
+struct SellData
+{
+  size_t rows{0};
+  std::vector<size_t> chunk_ptr; // chunks + 1 offsets
+  std::vector<size_t> chunk_len;
+  std::vector<CsrIndex> perm;
+  std::vector<CsrIndex, xsimd::aligned_allocator<CsrIndex>> col_idx;
+  std::vector<float, xsimd::aligned_allocator<float>> values;
+};
+
+// Packs `csr` into chunks, sorting rows by decreasing length within windows of `sigma` rows
+// (rounded up to a whole number of chunks).
+SellData sell_from_csr(CsrData const &csr, size_t rows, size_t sigma);
+
+// y = a * x over chunks [chunk_begin, chunk_end), one chunk of rows per instruction.
+void sell_spmv(SellData const &a, float const *x, float *y, size_t chunk_begin, size_t chunk_end);
+
+// Y = a * X over rows [row_begin, row_end), with X a row-major block of s columns: every non-zero
+// scales a whole row of X, s entries per instruction.
+void csr_spmm(
+    CsrData const &a, float const *x, float *y, size_t s, size_t row_begin, size_t row_end
+);
+
+// Y = a * X over chunks [chunk_begin, chunk_end), as `csr_spmm` for the rows of every chunk.
+void sell_spmm(
+    SellData const &a, float const *x, float *y, size_t s, size_t chunk_begin, size_t chunk_end
+);
+
+} // namespace gpu_playground::backend
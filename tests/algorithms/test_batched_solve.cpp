@@ -0,0 +1,115 @@
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers.hpp"
+
+#include "device.hpp"
+
+#include "algorithms.hpp"
+#include "matchers.hpp"
+#include "tensor.hpp"
+#include "thread_settings.hpp"
+
+using namespace Catch::Matchers;
+using namespace gpu_playground;
+
+TEST_CASE("algorithms: batched solves", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // Three 3x3 SPD systems with integer solutions, and a fourth one with a zero right-hand side
+  // that has converged from the start and must stay untouched by the others' iterations
+  // clang-format off
+  std::vector<float> const a_data{
+      4.0, 1.0, 0.0, 1.0, 3.0, 1.0, 0.0, 1.0, 2.0,
+      2.0, 0.0, 0.0, 0.0, 5.0, 0.0, 0.0, 0.0, 1.0,
+      6.0, 2.0, 1.0, 2.0, 5.0, 2.0, 1.0, 2.0, 4.0,
+      3.0, 1.0, 1.0, 1.0, 3.0, 1.0, 1.0, 1.0, 3.0,
+  };
+  std::vector<float> const b_data{6.0, 10.0, 8.0, -2.0, 5.0, 2.0, 5.0, -1.0, 3.0, 0.0, 0.0, 0.0};
+  std::vector<float> const ref{1.0, 2.0, 3.0, -1.0, 1.0, 2.0, 1.0, -1.0, 1.0, 0.0, 0.0, 0.0};
+  // clang-format on
+  constexpr size_t batch{4};
+  Tensor a(a_data, Shape{12, 3}, devices[DeviceIdx::SERIAL]);
+  Tensor b(b_data, Shape{12, 1}, devices[DeviceIdx::SERIAL]);
+  Tensor x0 = Tensor::zeros(Shape{12, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+        x0.to(device);
+
+        auto const cg       = batched_conjugate_gradient(a, b, x0, batch, 1000, 1e-6F);
+        auto const cholesky = batched_cholesky_solve(a, b, batch);
+
+        REQUIRE_THAT(cg.cpu(), VectorsWithinAbsRel(ref, 1e-5F, 1e-5F));
+        REQUIRE_THAT(cholesky.cpu(), VectorsWithinAbsRel(ref, 1e-5F, 1e-5F));
+      }
+    }
+  }
+}
+
+TEST_CASE("algorithms: batched solves parallel", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  ScopedThreadSettings const settings{4, 7, 0};
+
+  // Diagonally dominant tridiagonal systems whose diagonal and solution vary with the system, in
+  // a batch that does not fill its last SIMD group. CG starts from a non-zero guess.
+  constexpr size_t batch{37};
+  constexpr size_t n{12};
+  std::vector<float> a_data(batch * n * n, 0.0);
+  std::vector<float> b_data(batch * n, 0.0);
+  std::vector<float> x0_data(batch * n, 1.0);
+  std::vector<float> ref(batch * n);
+  for (size_t s{0}; s < batch; s++)
+  {
+    auto *a_s = a_data.data() + (s * n * n);
+    for (size_t i{0}; i < n; i++)
+    {
+      ref[(s * n) + i] = static_cast<float>((s + (i * 3)) % 7) - 3.0F;
+      a_s[(i * n) + i] = static_cast<float>(3 + ((s + i) % 4));
+      if (i + 1 < n)
+      {
+        a_s[(i * n) + i + 1]   = -1.0;
+        a_s[((i + 1) * n) + i] = -1.0;
+      }
+    }
+    for (size_t i{0}; i < n; i++)
+    {
+      for (size_t j{0}; j < n; j++)
+      {
+        b_data[(s * n) + i] += a_s[(i * n) + j] * ref[(s * n) + j];
+      }
+    }
+  }
+  Tensor a(a_data, Shape{batch * n, n}, devices[DeviceIdx::SERIAL]);
+  Tensor b(b_data, Shape{batch * n, 1}, devices[DeviceIdx::SERIAL]);
+  Tensor x0(x0_data, Shape{batch * n, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+        x0.to(device);
+
+        auto const cg       = batched_conjugate_gradient(a, b, x0, batch, 1000, 1e-5F);
+        auto const cholesky = batched_cholesky_solve(a, b, batch);
+
+        REQUIRE_THAT(cg.cpu(), VectorsWithinAbsRel(ref, 1e-5F, 1e-5F));
+        REQUIRE_THAT(cholesky.cpu(), VectorsWithinAbsRel(ref, 1e-5F, 1e-5F));
+      }
+    }
+  }
+}
@@ -0,0 +1,139 @@
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers.hpp"
+
+#include "device.hpp"
+
+#include "algorithms.hpp"
+#include "matchers.hpp"
+#include "tensor.hpp"
+
+using namespace Catch::Matchers;
+using namespace gpu_playground;
+
+TEST_CASE("algorithms: bicgstab", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // Same non-symmetric system as the GMRES test, with solution {1, -2, 3, -1, 2}
+  // clang-format off
+  std::vector<float> const a_data{5.0, 2.0, 0.0, 0.0, 1.0, -1.0, 6.0, 3.0, 0.0, 0.0, 0.0, -2.0, 7.0, 1.0, 0.0, 2.0, 0.0, -1.0, 5.0, 2.0, 0.0, 1.0, 0.0, -3.0, 6.0};
+  std::vector<float> const b_data{3.0, -4.0, 24.0, -2.0, 13.0};
+  std::vector<float> const ref{1.0, -2.0, 3.0, -1.0, 2.0};
+  // clang-format on
+  Shape const a_shape{5, 5};
+  Shape const b_shape{5, 1};
+  Tensor a(a_data, a_shape, devices[DeviceIdx::SERIAL]);
+  Tensor b(b_data, b_shape, devices[DeviceIdx::SERIAL]);
+  Tensor x0 = Tensor::zeros(b_shape, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+        x0.to(device);
+        auto const sparse = CsrMatrix::from_dense(a);
+
+        auto const c = bicgstab(a, b, x0, 1000, 1e-5);
+        auto const s = bicgstab(sparse, b, x0, 1000, 1e-5);
+
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref, 1e-5F, 1e-5F));
+        REQUIRE_THAT(s.cpu(), VectorsWithinAbsRel(ref, 1e-5F, 1e-5F));
+      }
+    }
+  }
+}
+
+TEST_CASE("algorithms: bicgstab exact half step", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // The half-step residual s of a scaled identity is exactly zero, so that omega would be 0 / 0
+  std::vector<float> const a_data{2.0, 0.0, 0.0, 0.0, 2.0, 0.0, 0.0, 0.0, 2.0};
+  std::vector<float> const b_data{1.0, 2.0, 3.0};
+  std::vector<float> const ref{0.5, 1.0, 1.5};
+  Tensor a(a_data, Shape{3, 3}, devices[DeviceIdx::SERIAL]);
+  Tensor b(b_data, Shape{3, 1}, devices[DeviceIdx::SERIAL]);
+  Tensor x0 = Tensor::zeros(Shape{3, 1}, devices[DeviceIdx::SERIAL]);
+  Tensor a_1(std::vector<float>{4.0}, Shape{1, 1}, devices[DeviceIdx::SERIAL]);
+  Tensor b_1(std::vector<float>{2.0}, Shape{1, 1}, devices[DeviceIdx::SERIAL]);
+  Tensor x0_1 = Tensor::zeros(Shape{1, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+        x0.to(device);
+        a_1.to(device);
+        b_1.to(device);
+        x0_1.to(device);
+
+        auto const c       = bicgstab(a, b, x0, 100, 1e-5);
+        auto const c_every = bicgstab(a, b, x0, 100, 1e-5, 4);
+        auto const c_1     = bicgstab(a_1, b_1, x0_1, 100, 1e-5);
+
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref));
+        REQUIRE_THAT(c_every.cpu(), VectorsWithinAbsRel(ref));
+        REQUIRE_THAT(c_1.cpu(), VectorsWithinAbsRel(std::vector<float>{0.5}));
+      }
+    }
+  }
+}
+
+TEST_CASE("algorithms: bicgstab convection-diffusion", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // Upwinded 1D convection-diffusion
+  constexpr size_t n{40};
+  std::vector<backend::Triplet> triplets;
+  std::vector<float> ref(n);
+  for (size_t i{0}; i < n; i++)
+  {
+    auto const row = static_cast<backend::CsrIndex>(i);
+    triplets.push_back({row, row, 3.0});
+    if (i > 0)
+    {
+      triplets.push_back({row, row - 1, -2.0});
+    }
+    if (i + 1 < n)
+    {
+      triplets.push_back({row, row + 1, -0.5});
+    }
+    ref[i] = static_cast<float>(i % 5) - 2.0F;
+  }
+  std::vector<float> b_data(n, 0.0);
+  for (auto const &[row, col, value] : triplets)
+  {
+    b_data[row] += value * ref[col];
+  }
+  Tensor b(b_data, Shape{n, 1}, devices[DeviceIdx::SERIAL]);
+  Tensor x0 = Tensor::zeros(Shape{n, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        b.to(device);
+        x0.to(device);
+        auto const a = CsrMatrix::from_triplets(Shape{n, n}, triplets, device);
+
+        auto const c = bicgstab(a, b, x0, 1000, 1e-5);
+
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref, 1e-4F, 1e-4F));
+      }
+    }
+  }
+}
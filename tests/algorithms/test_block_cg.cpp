@@ -0,0 +1,170 @@
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers.hpp"
+
+#include "device.hpp"
+
+#include "algorithms.hpp"
+#include "matchers.hpp"
+#include "tensor.hpp"
+
+using namespace Catch::Matchers;
+using namespace gpu_playground;
+
+namespace
+{
+
+// 5-point Laplacian on a side x side grid
+backend::CsrData laplacian(size_t const side)
+{
+  auto const n = side * side;
+  std::vector<backend::Triplet> triplets;
+  for (size_t i{0}; i < n; i++)
+  {
+    auto const row = static_cast<backend::CsrIndex>(i);
+    triplets.push_back({row, row, 4.0});
+    if (i % side > 0)
+    {
+      triplets.push_back({row, row - 1, -1.0});
+      triplets.push_back({row - 1, row, -1.0});
+    }
+    if (i >= side)
+    {
+      triplets.push_back({row, static_cast<backend::CsrIndex>(i - side), -1.0});
+      triplets.push_back({static_cast<backend::CsrIndex>(i - side), row, -1.0});
+    }
+  }
+  return backend::csr_from_triplets(Shape{n, n}, triplets);
+}
+
+} // namespace
+
+TEST_CASE("algorithms: block conjugate gradient", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // Tridiagonal system of the conjugate gradient test, with right-hand sides B = A X for the
+  // integer solutions X
+  // clang-format off
+  std::vector<float> const a_data{6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0};
+  std::vector<float> const b_data{4.0, -6.0, 14.0, 8.0, 0.0, -16.0, 12.0, 6.0, 16.0, 16.0, 0.0, -16.0, 26.0, -6.0, 14.0};
+  std::vector<float> const ref{1.0, -1.0, 2.0, 2.0, 0.0, -2.0, 3.0, 1.0, 2.0, 4.0, 0.0, -2.0, 5.0, -1.0, 2.0};
+  // clang-format on
+  Shape const b_shape{5, 3};
+  Tensor a(a_data, Shape{5, 5}, devices[DeviceIdx::SERIAL]);
+  Tensor b(b_data, b_shape, devices[DeviceIdx::SERIAL]);
+  Tensor x0 = Tensor::zeros(b_shape, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+        x0.to(device);
+        auto const csr = CsrMatrix::from_dense(a);
+
+        auto const dense  = block_conjugate_gradient(a, b, x0, 1000, 1e-5F);
+        auto const sparse = block_conjugate_gradient(csr, b, x0, 1000, 1e-5F);
+
+        REQUIRE_THAT(dense.cpu(), VectorsWithinAbsRel(ref, 1e-5F, 1e-5F));
+        REQUIRE_THAT(sparse.cpu(), VectorsWithinAbsRel(ref, 1e-5F, 1e-5F));
+      }
+    }
+  }
+}
+
+TEST_CASE("algorithms: block conjugate gradient matches column solves", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  constexpr size_t side{16};
+  constexpr size_t n{side * side};
+  constexpr size_t s{8};
+  constexpr float tol{1e-4};
+  auto const csr = laplacian(side);
+  std::vector<float> b_data(n * s);
+  for (size_t i{0}; i < b_data.size(); i++)
+  {
+    b_data[i] = static_cast<float>((i * 7) % 11) - 5.0F;
+  }
+  Tensor b(b_data, Shape{n, s}, devices[DeviceIdx::SERIAL]);
+  Tensor x0 = Tensor::zeros(Shape{n, s}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        b.to(device);
+        x0.to(device);
+        CsrMatrix const a(Shape{n, n}, csr.row_ptr, csr.col_idx, csr.values, device);
+        SellMatrix const sell(Shape{n, n}, csr.row_ptr, csr.col_idx, csr.values, device);
+
+        std::vector<float> ref(n * s);
+        std::vector<float> b_col(n);
+        for (size_t j{0}; j < s; j++)
+        {
+          for (size_t i{0}; i < n; i++)
+          {
+            b_col[i] = b_data[(i * s) + j];
+          }
+          auto const x_col = conjuaget_gradient(
+              a, Tensor(b_col, Shape{n, 1}, device), Tensor::zeros(Shape{n, 1}, device), 1000, tol
+          );
+          auto const x_host = x_col.cpu();
+          for (size_t i{0}; i < n; i++)
+          {
+            ref[(i * s) + j] = x_host[i];
+          }
+        }
+
+        auto const x      = block_conjugate_gradient(a, b, x0, 1000, tol);
+        auto const x_sell = block_conjugate_gradient(sell, b, x0, 1000, tol);
+
+        REQUIRE_THAT(x.cpu(), VectorsWithinAbsRel(ref, 1e-4F, 1e-4F));
+        REQUIRE_THAT(x_sell.cpu(), VectorsWithinAbsRel(ref, 1e-4F, 1e-4F));
+      }
+    }
+  }
+}
+
+TEST_CASE("algorithms: block conjugate gradient breakdown", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // A repeated right-hand side and a zero one leave the block without full rank, so that the
+  // columns are finished one at a time
+  // clang-format off
+  std::vector<backend::CsrIndex> const row_ptr{0, 2, 5, 8, 11, 13};
+  std::vector<backend::CsrIndex> const col_idx{0, 1, 0, 1, 2, 1, 2, 3, 2, 3, 4, 3, 4};
+  std::vector<float> const values{6.0, -1.0, -1.0, 6.0, -1.0, -1.0, 6.0, -1.0, -1.0, 6.0, -1.0, -1.0, 6.0};
+  std::vector<float> const b_data{4.0, 4.0, 0.0, 8.0, 8.0, 0.0, 12.0, 12.0, 0.0, 16.0, 16.0, 0.0, 26.0, 26.0, 0.0};
+  std::vector<float> const ref{1.0, 1.0, 0.0, 2.0, 2.0, 0.0, 3.0, 3.0, 0.0, 4.0, 4.0, 0.0, 5.0, 5.0, 0.0};
+  // clang-format on
+  Shape const b_shape{5, 3};
+  Tensor b(b_data, b_shape, devices[DeviceIdx::SERIAL]);
+  Tensor x0 = Tensor::zeros(b_shape, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        b.to(device);
+        x0.to(device);
+        CsrMatrix const a(Shape{5, 5}, row_ptr, col_idx, values, device);
+
+        auto const x = block_conjugate_gradient(a, b, x0, 1000, 1e-5F);
+
+        REQUIRE_THAT(x.cpu(), VectorsWithinAbsRel(ref, 1e-5F, 1e-5F));
+      }
+    }
+  }
+}
@@ -45,3 +45,144 @@ TEST_CASE("algorithms: conjugate gradient", "[algorithms]")
     }
   }
 }
+
+TEST_CASE("algorithms: conjugate gradient in double precision", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // The dense system above, whose exact solution is far more accurate than float can hold
+  // clang-format off
+  std::vector<float> const a_data{6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0};
+  std::vector<float> const b_data{1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<double> const ref{577.0 / 2310.0, 192.0 / 385.0, 49.0 / 66.0, 368.0 / 385.0, 2293.0 / 2310.0};
+  // clang-format on
+  Shape const a_shape{5, 5};
+  Shape const b_shape{5, 1};
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F64))
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        auto const a  = Tensor(a_data, a_shape, device).to_dtype(DType::F64);
+        auto const b  = Tensor(b_data, b_shape, device).to_dtype(DType::F64);
+        auto const x0 = Tensor::zeros(b_shape, device).to_dtype(DType::F64);
+
+        auto const c = conjuaget_gradient(a, b, x0, 1000, 1e-14);
+
+        REQUIRE(c.dtype() == DType::F64);
+        REQUIRE_THAT(c.cpu_f64(), VectorsWithinAbsRel(ref, 1e-14, 1e-14));
+      }
+    }
+  }
+}
+
+TEST_CASE("algorithms: conjugate gradient sparse", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // Same tridiagonal system as the dense test, stored in CSR
+  // clang-format off
+  std::vector<backend::CsrIndex> const row_ptr{0, 2, 5, 8, 11, 13};
+  std::vector<backend::CsrIndex> const col_idx{0, 1, 0, 1, 2, 1, 2, 3, 2, 3, 4, 3, 4};
+  std::vector<float> const values{6.0, -1.0, -1.0, 6.0, -1.0, -1.0, 6.0, -1.0, -1.0, 6.0, -1.0, -1.0, 6.0};
+  std::vector<float> const b_data{1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<float> const ref{0.24978355, 0.4987013, 0.74242425, 0.95584416, 0.9926407};
+  // clang-format on
+  Shape const a_shape{5, 5};
+  Shape const b_shape{5, 1};
+  Tensor b(b_data, b_shape, devices[DeviceIdx::SERIAL]);
+  Tensor x0 = Tensor::zeros(b_shape, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        b.to(device);
+        x0.to(device);
+        CsrMatrix const a(a_shape, row_ptr, col_idx, values, device);
+
+        auto const c = conjuaget_gradient(a, b, x0);
+
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("algorithms: conjugate gradient check every", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // Same tridiagonal system as the sparse test, checking convergence every 3 iterations
+  // clang-format off
+  std::vector<backend::CsrIndex> const row_ptr{0, 2, 5, 8, 11, 13};
+  std::vector<backend::CsrIndex> const col_idx{0, 1, 0, 1, 2, 1, 2, 3, 2, 3, 4, 3, 4};
+  std::vector<float> const values{6.0, -1.0, -1.0, 6.0, -1.0, -1.0, 6.0, -1.0, -1.0, 6.0, -1.0, -1.0, 6.0};
+  std::vector<float> const b_data{1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<float> const ref{0.24978355, 0.4987013, 0.74242425, 0.95584416, 0.9926407};
+  // clang-format on
+  Shape const a_shape{5, 5};
+  Shape const b_shape{5, 1};
+  Tensor b(b_data, b_shape, devices[DeviceIdx::SERIAL]);
+  Tensor x0 = Tensor::zeros(b_shape, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        b.to(device);
+        x0.to(device);
+        CsrMatrix const a(a_shape, row_ptr, col_idx, values, device);
+        JacobiPreconditioner const jacobi{backend::CsrData{row_ptr, col_idx, values}, device};
+
+        auto const c  = conjuaget_gradient(a, b, x0, 1000, 1e-6, 3);
+        auto const pc = preconditioned_conjugate_gradient(a, b, x0, jacobi, 1000, 1e-6, 3);
+
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref, 1e-6F, 1e-6F));
+        REQUIRE_THAT(pc.cpu(), VectorsWithinAbsRel(ref, 1e-6F, 1e-6F));
+      }
+    }
+  }
+}
+
+TEST_CASE("algorithms: conjugate gradient check every after convergence", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // The identity is solved exactly by the first iteration, and the next ones run unchecked on a
+  // zero residual
+  std::vector<backend::CsrIndex> const row_ptr{0, 1, 2, 3};
+  std::vector<backend::CsrIndex> const col_idx{0, 1, 2};
+  std::vector<float> const values{1.0, 1.0, 1.0};
+  std::vector<float> const b_data{1.0, -2.0, 3.0};
+  Shape const a_shape{3, 3};
+  Shape const b_shape{3, 1};
+  Tensor b(b_data, b_shape, devices[DeviceIdx::SERIAL]);
+  Tensor x0 = Tensor::zeros(b_shape, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        b.to(device);
+        x0.to(device);
+        CsrMatrix const a(a_shape, row_ptr, col_idx, values, device);
+        JacobiPreconditioner const jacobi{backend::CsrData{row_ptr, col_idx, values}, device};
+
+        auto const c  = conjuaget_gradient(a, b, x0, 100, 1e-5, 4);
+        auto const pc = preconditioned_conjugate_gradient(a, b, x0, jacobi, 100, 1e-5, 4);
+
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(b_data));
+        REQUIRE_THAT(pc.cpu(), VectorsWithinAbsRel(b_data));
+      }
+    }
+  }
+}
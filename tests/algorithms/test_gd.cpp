@@ -45,3 +45,67 @@ TEST_CASE("algorithms: gradient descent", "[algorithms]")
     }
   }
 }
+
+TEST_CASE("algorithms: gradient descent in double precision", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // The system above, solved below the accuracy of float
+  // clang-format off
+  std::vector<float> const a_data{6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0};
+  std::vector<float> const b_data{1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<double> const ref{577.0 / 2310.0, 192.0 / 385.0, 49.0 / 66.0, 368.0 / 385.0, 2293.0 / 2310.0};
+  // clang-format on
+  Shape const a_shape{5, 5};
+  Shape const b_shape{5, 1};
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F64))
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        auto const a  = Tensor(a_data, a_shape, device).to_dtype(DType::F64);
+        auto const b  = Tensor(b_data, b_shape, device).to_dtype(DType::F64);
+        auto const x0 = Tensor::zeros(b_shape, device).to_dtype(DType::F64);
+
+        auto const c = gradient_descent(a, b, x0, 1000, 1e-14);
+
+        REQUIRE(c.dtype() == DType::F64);
+        REQUIRE_THAT(c.cpu_f64(), VectorsWithinAbsRel(ref, 1e-14, 1e-14));
+      }
+    }
+  }
+}
+
+TEST_CASE("algorithms: gradient descent check every after convergence", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // The identity is solved exactly by the first iteration, and the next ones run unchecked on a
+  // zero residual
+  std::vector<float> const a_data{1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
+  std::vector<float> const b_data{1.0, -2.0, 3.0};
+  Shape const a_shape{3, 3};
+  Shape const b_shape{3, 1};
+  Tensor a(a_data, a_shape, devices[DeviceIdx::SERIAL]);
+  Tensor b(b_data, b_shape, devices[DeviceIdx::SERIAL]);
+  Tensor x0 = Tensor::zeros(b_shape, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+        x0.to(device);
+
+        auto const c = gradient_descent(a, b, x0, 100, 1e-5, 4);
+
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(b_data));
+      }
+    }
+  }
+}
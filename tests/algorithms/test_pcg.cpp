@@ -0,0 +1,260 @@
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers.hpp"
+
+#include "device.hpp"
+
+#include "algorithms.hpp"
+#include "matchers.hpp"
+#include "preconditioners.hpp"
+#include "tensor.hpp"
+#include "thread_settings.hpp"
+
+using namespace Catch::Matchers;
+using namespace gpu_playground;
+
+namespace
+{
+
+// 5-point Laplacian on a side x side grid, with rows and columns scaled by 1, 10, 100, 1 ... so
+// that the system is badly conditioned unless it is preconditioned
+backend::CsrData scaled_laplacian(size_t const side)
+{
+  auto const n     = side * side;
+  auto const scale = [](size_t const i) { return std::pow(10.0F, static_cast<float>(i % 3)); };
+
+  std::vector<backend::Triplet> triplets;
+  auto const push = [&](size_t const row, size_t const col, float const value)
+  {
+    triplets.push_back(
+        {static_cast<backend::CsrIndex>(row),
+         static_cast<backend::CsrIndex>(col),
+         value * scale(row) * scale(col)}
+    );
+  };
+  for (size_t i{0}; i < side; i++)
+  {
+    for (size_t j{0}; j < side; j++)
+    {
+      auto const row = (i * side) + j;
+      push(row, row, 4.0);
+      if (i > 0)
+      {
+        push(row, row - side, -1.0);
+      }
+      if (j > 0)
+      {
+        push(row, row - 1, -1.0);
+      }
+      if (j + 1 < side)
+      {
+        push(row, row + 1, -1.0);
+      }
+      if (i + 1 < side)
+      {
+        push(row, row + side, -1.0);
+      }
+    }
+  }
+  return backend::csr_from_triplets(Shape{n, n}, triplets);
+}
+
+float residual_norm(backend::CsrData const &a, std::vector<float> const &x, float const b)
+{
+  double sum{0.0};
+  for (size_t i{0}; i + 1 < a.row_ptr.size(); i++)
+  {
+    double r{b};
+    for (auto k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++)
+    {
+      r -= static_cast<double>(a.values[k]) * x[a.col_idx[k]];
+    }
+    sum += r * r;
+  }
+  return static_cast<float>(std::sqrt(sum));
+}
+
+} // namespace
+
+TEST_CASE("algorithms: preconditioned conjugate gradient", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // Same tridiagonal system as the conjugate gradient test
+  // clang-format off
+  std::vector<backend::CsrIndex> const row_ptr{0, 2, 5, 8, 11, 13};
+  std::vector<backend::CsrIndex> const col_idx{0, 1, 0, 1, 2, 1, 2, 3, 2, 3, 4, 3, 4};
+  std::vector<float> const values{6.0, -1.0, -1.0, 6.0, -1.0, -1.0, 6.0, -1.0, -1.0, 6.0, -1.0, -1.0, 6.0};
+  std::vector<float> const b_data{1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<float> const ref{0.24978355, 0.4987013, 0.74242425, 0.95584416, 0.9926407};
+  // clang-format on
+  backend::CsrData const csr{row_ptr, col_idx, values};
+  Shape const a_shape{5, 5};
+  Shape const b_shape{5, 1};
+  Tensor b(b_data, b_shape, devices[DeviceIdx::SERIAL]);
+  Tensor x0 = Tensor::zeros(b_shape, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        b.to(device);
+        x0.to(device);
+        CsrMatrix const a(a_shape, row_ptr, col_idx, values, device);
+
+        auto const jacobi =
+            preconditioned_conjugate_gradient(a, b, x0, JacobiPreconditioner{csr, device});
+        auto const ssor = preconditioned_conjugate_gradient(a, b, x0, SsorPreconditioner{csr, 1.2});
+        auto const ilu  = preconditioned_conjugate_gradient(a, b, x0, Ilu0Preconditioner{csr});
+
+        REQUIRE_THAT(jacobi.cpu(), VectorsWithinAbsRel(ref, 1e-6F, 1e-6F));
+        REQUIRE_THAT(ssor.cpu(), VectorsWithinAbsRel(ref, 1e-6F, 1e-6F));
+        REQUIRE_THAT(ilu.cpu(), VectorsWithinAbsRel(ref, 1e-6F, 1e-6F));
+      }
+    }
+  }
+}
+
+TEST_CASE("algorithms: preconditioned conjugate gradient in double precision", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // Dense version of the system above, preconditioned by its diagonal held in F64
+  // clang-format off
+  std::vector<float> const a_data{6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0};
+  std::vector<float> const b_data{1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<double> const ref{577.0 / 2310.0, 192.0 / 385.0, 49.0 / 66.0, 368.0 / 385.0, 2293.0 / 2310.0};
+  // clang-format on
+  Shape const a_shape{5, 5};
+  Shape const b_shape{5, 1};
+
+  struct DiagonalPreconditioner
+  {
+    Tensor inv_diag;
+
+    [[nodiscard]] Tensor apply(Tensor const &r) const { return r.cmul(this->inv_diag); }
+  };
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F64))
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        auto const a  = Tensor(a_data, a_shape, device).to_dtype(DType::F64);
+        auto const b  = Tensor(b_data, b_shape, device).to_dtype(DType::F64);
+        auto const x0 = Tensor::zeros(b_shape, device).to_dtype(DType::F64);
+        DiagonalPreconditioner const m{
+            Tensor::from_f64(std::vector<double>(5, 1.0 / 6.0), b_shape, device)
+        };
+
+        auto const c = preconditioned_conjugate_gradient(a, b, x0, m, 1000, 1e-14);
+
+        REQUIRE(c.dtype() == DType::F64);
+        REQUIRE_THAT(c.cpu_f64(), VectorsWithinAbsRel(ref, 1e-14, 1e-14));
+      }
+    }
+  }
+}
+
+TEST_CASE("algorithms: ilu(0) of a tridiagonal matrix", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // The LU factors of a tridiagonal matrix have no fill-in, so ILU(0) is exact and a single
+  // iteration solves the system
+  // clang-format off
+  std::vector<backend::CsrIndex> const row_ptr{0, 2, 5, 8, 11, 13};
+  std::vector<backend::CsrIndex> const col_idx{0, 1, 0, 1, 2, 1, 2, 3, 2, 3, 4, 3, 4};
+  std::vector<float> const values{6.0, -1.0, -1.0, 6.0, -1.0, -1.0, 6.0, -1.0, -1.0, 6.0, -1.0, -1.0, 6.0};
+  std::vector<float> const b_data{1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<float> const ref{0.24978355, 0.4987013, 0.74242425, 0.95584416, 0.9926407};
+  // clang-format on
+  Tensor b(b_data, Shape{5, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        b.to(device);
+        Ilu0Preconditioner const ilu{backend::CsrData{row_ptr, col_idx, values}};
+
+        REQUIRE_THAT(ilu.apply(b).cpu(), VectorsWithinAbsRel(ref, 1e-6F, 1e-6F));
+      }
+    }
+  }
+}
+
+TEST_CASE("algorithms: preconditioned conjugate gradient convergence", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // After the same number of iterations, every preconditioner is closer to the solution than
+  // plain conjugate gradient on a badly scaled system
+  constexpr size_t side{12};
+  constexpr size_t n{side * side};
+  constexpr size_t iters{10};
+  auto const csr = scaled_laplacian(side);
+  Tensor b       = Tensor::ones(Shape{n, 1}, devices[DeviceIdx::SERIAL]);
+  Tensor x0      = Tensor::zeros(Shape{n, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        b.to(device);
+        x0.to(device);
+        CsrMatrix const a(Shape{n, n}, csr.row_ptr, csr.col_idx, csr.values, device);
+
+        auto const cg     = conjuaget_gradient(a, b, x0, iters, 0.0);
+        auto const jacobi = preconditioned_conjugate_gradient(
+            a, b, x0, JacobiPreconditioner{csr, device}, iters, 0.0
+        );
+        auto const ssor =
+            preconditioned_conjugate_gradient(a, b, x0, SsorPreconditioner{csr}, iters, 0.0);
+        auto const ilu =
+            preconditioned_conjugate_gradient(a, b, x0, Ilu0Preconditioner{csr}, iters, 0.0);
+
+        auto const cg_residual = residual_norm(csr, cg.cpu(), 1.0);
+        REQUIRE(residual_norm(csr, jacobi.cpu(), 1.0) < cg_residual);
+        REQUIRE(residual_norm(csr, ssor.cpu(), 1.0) < cg_residual);
+        REQUIRE(residual_norm(csr, ilu.cpu(), 1.0) < cg_residual);
+      }
+    }
+  }
+}
+
+TEST_CASE("algorithms: preconditioners parallel", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // Every row of a level is solved by the same operations whichever thread runs it, so the
+  // parallel solves match the sequential ones exactly
+  constexpr size_t side{15};
+  constexpr size_t n{side * side};
+  auto const csr = scaled_laplacian(side);
+  std::vector<float> r_data(n);
+  for (size_t i{0}; i < n; i++)
+  {
+    r_data[i] = static_cast<float>(i % 7) - 3.0F;
+  }
+  Tensor const r(r_data, Shape{n, 1}, devices[DeviceIdx::SERIAL]);
+  SsorPreconditioner const ssor{csr, 1.5};
+  Ilu0Preconditioner const ilu{csr};
+  auto const ssor_ref = ssor.apply(r).cpu();
+  auto const ilu_ref  = ilu.apply(r).cpu();
+
+  ScopedThreadSettings const settings{4, 7, 0};
+
+  REQUIRE_THAT(ssor.apply(r).cpu(), VectorsWithinAbsRel(ssor_ref));
+  REQUIRE_THAT(ilu.apply(r).cpu(), VectorsWithinAbsRel(ilu_ref));
+}
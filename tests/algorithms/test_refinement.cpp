@@ -0,0 +1,97 @@
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers.hpp"
+
+#include "device.hpp"
+
+#include "algorithms.hpp"
+#include "matchers.hpp"
+#include "tensor.hpp"
+
+using namespace Catch::Matchers;
+using namespace gpu_playground;
+
+TEST_CASE("algorithms: mixed precision refinement", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // The system of the conjugate gradient tests, solved to double accuracy from F32 corrections
+  // clang-format off
+  std::vector<double> const a_data{6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0};
+  std::vector<double> const b_data{1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<double> const ref{577.0 / 2310.0, 192.0 / 385.0, 49.0 / 66.0, 368.0 / 385.0, 2293.0 / 2310.0};
+  // clang-format on
+  Shape const a_shape{5, 5};
+  Shape const b_shape{5, 1};
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F64))
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        auto const a  = Tensor::from_f64(a_data, a_shape, device);
+        auto const b  = Tensor::from_f64(b_data, b_shape, device);
+        auto const x0 = Tensor::zeros(b_shape, device).to_dtype(DType::F64);
+
+        auto const c = mixed_precision_refinement(a, b, x0, 100, 1e-14);
+
+        REQUIRE(c.dtype() == DType::F64);
+        REQUIRE_THAT(c.cpu_f64(), VectorsWithinAbsRel(ref, 1e-14, 1e-14));
+      }
+    }
+  }
+}
+
+TEST_CASE("algorithms: mixed precision refinement beyond float", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // A tridiagonal SPD system whose matrix, right-hand side and solution all differ from their
+  // float roundings, so that only the F64 residuals can bring x to double accuracy. A few
+  // corrections must be enough, each F32 solve gaining about 4 digits.
+  constexpr size_t n{100};
+  auto const tiny = std::ldexp(1.0, -30);
+  std::vector<double> a_data(n * n, 0.0);
+  std::vector<double> ref(n);
+  for (size_t i{0}; i < n; i++)
+  {
+    a_data[(i * n) + i] = 4.0 + (tiny * static_cast<double>(i % 7));
+    if (i + 1 < n)
+    {
+      a_data[(i * n) + i + 1]   = -1.0 - tiny;
+      a_data[((i + 1) * n) + i] = -1.0 - tiny;
+    }
+    ref[i] = 1.0 + (static_cast<double>(i % 5) / 3.0) + (tiny * static_cast<double>(i));
+  }
+  std::vector<double> b_data(n, 0.0);
+  for (size_t i{0}; i < n; i++)
+  {
+    for (size_t j{0}; j < n; j++)
+    {
+      b_data[i] += a_data[(i * n) + j] * ref[j];
+    }
+  }
+  Shape const b_shape{n, 1};
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F64))
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        auto const a  = Tensor::from_f64(a_data, Shape{n, n}, device);
+        auto const b  = Tensor::from_f64(b_data, b_shape, device);
+        auto const x0 = Tensor::ones(b_shape, device).to_dtype(DType::F64);
+
+        auto const c = mixed_precision_refinement(a, b, x0, 6, 1e-12);
+
+        REQUIRE(c.dtype() == DType::F64);
+        REQUIRE_THAT(c.cpu_f64(), VectorsWithinAbsRel(ref, 1e-12, 1e-12));
+      }
+    }
+  }
+}
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers.hpp"
+
+#include "device.hpp"
+
+#include "algorithms.hpp"
+#include "matchers.hpp"
+#include "reordering.hpp"
+#include "tensor.hpp"
+
+using namespace Catch::Matchers;
+using namespace gpu_playground;
+
+namespace
+{
+
+// 5-point Laplacian on a side x side grid, with the grid points numbered in a scrambled order
+backend::CsrData scrambled_laplacian(size_t const side)
+{
+  auto const n     = side * side;
+  auto const label = [n](size_t const point)
+  { return static_cast<backend::CsrIndex>((point * 37) % n); };
+
+  std::vector<backend::Triplet> triplets;
+  for (size_t i{0}; i < side; i++)
+  {
+    for (size_t j{0}; j < side; j++)
+    {
+      auto const row = label((i * side) + j);
+      triplets.push_back({row, row, 4.0});
+      if (i > 0)
+      {
+        triplets.push_back({row, label(((i - 1) * side) + j), -1.0});
+      }
+      if (j > 0)
+      {
+        triplets.push_back({row, label((i * side) + j - 1), -1.0});
+      }
+      if (j + 1 < side)
+      {
+        triplets.push_back({row, label((i * side) + j + 1), -1.0});
+      }
+      if (i + 1 < side)
+      {
+        triplets.push_back({row, label(((i + 1) * side) + j), -1.0});
+      }
+    }
+  }
+  return backend::csr_from_triplets(Shape{n, n}, triplets);
+}
+
+bool is_permutation(std::vector<backend::CsrIndex> perm)
+{
+  std::sort(perm.begin(), perm.end());
+  for (size_t i{0}; i < perm.size(); i++)
+  {
+    if (perm[i] != static_cast<backend::CsrIndex>(i))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+TEST_CASE("algorithms: reordering bandwidth", "[algorithms]")
+{
+  constexpr size_t side{12};
+  auto const a = scrambled_laplacian(side);
+
+  auto const rcm = Reordering::rcm(a);
+  auto const nd  = Reordering::nested_dissection(a, 8);
+
+  REQUIRE(is_permutation(rcm.perm()));
+  REQUIRE(is_permutation(nd.perm()));
+  REQUIRE(bandwidth(a) > 2 * side);
+  REQUIRE(bandwidth(rcm.apply(a)) <= side + 1);
+  REQUIRE(rcm.apply(a).values.size() == a.values.size());
+  REQUIRE(nd.apply(a).values.size() == a.values.size());
+}
+
+TEST_CASE("algorithms: reordering disconnected", "[algorithms]")
+{
+  // Diagonal block and two isolated vertices, which must all be ordered
+  backend::CsrData const a{{0, 2, 4, 5, 6}, {0, 1, 0, 1, 2, 3}, {2.0, -1.0, -1.0, 2.0, 1.0, 1.0}};
+
+  REQUIRE(is_permutation(Reordering::rcm(a).perm()));
+  REQUIRE(is_permutation(Reordering::nested_dissection(a, 1).perm()));
+}
+
+TEST_CASE("algorithms: reordered spmv", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  constexpr size_t side{9};
+  constexpr size_t n{side * side};
+  auto const a = scrambled_laplacian(side);
+  std::vector<float> x_data(n);
+  std::vector<float> ref(n, 0.0);
+  for (size_t j{0}; j < n; j++)
+  {
+    x_data[j] = static_cast<float>(j % 7) - 3.0F;
+  }
+  for (size_t i{0}; i < n; i++)
+  {
+    for (auto k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++)
+    {
+      ref[i] += a.values[k] * x_data[a.col_idx[k]];
+    }
+  }
+  Tensor x(x_data, Shape{n, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        x.to(device);
+
+        // Multiplying in the reordered space and restoring the result gives back A x
+        auto const product = [](CsrMatrix const &pa, Tensor const &px, Tensor const &)
+        { return pa * px; };
+        auto const rcm = solve_reordered(a, x, x, Reordering::rcm(a), product);
+        auto const nd  = solve_reordered(a, x, x, Reordering::nested_dissection(a, 8), product);
+
+        REQUIRE_THAT(rcm.cpu(), VectorsWithinAbsRel(ref));
+        REQUIRE_THAT(nd.cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("algorithms: conjugate gradient reordered", "[algorithms]")
+{
+  auto const devices = make_devices();
+
+  // Same tridiagonal system as the conjugate gradient test, with its unknowns scrambled
+  // clang-format off
+  std::vector<backend::CsrIndex> const order{3, 0, 4, 1, 2};
+  std::vector<float> const b_data{4.0, 1.0, 5.0, 2.0, 3.0};
+  std::vector<float> const ref{0.95584416, 0.24978355, 0.9926407, 0.4987013, 0.74242425};
+  // clang-format on
+  std::vector<backend::Triplet> triplets;
+  for (size_t i{0}; i < 5; i++)
+  {
+    auto const row = static_cast<backend::CsrIndex>(i);
+    triplets.push_back({row, row, 6.0});
+    for (size_t j{0}; j < 5; j++)
+    {
+      auto const distance = std::abs(order[i] - order[j]);
+      if (distance == 1)
+      {
+        triplets.push_back({row, static_cast<backend::CsrIndex>(j), -1.0});
+      }
+    }
+  }
+  auto const a = backend::csr_from_triplets(Shape{5, 5}, triplets);
+  Tensor b(b_data, Shape{5, 1}, devices[DeviceIdx::SERIAL]);
+  Tensor x0 = Tensor::zeros(Shape{5, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        b.to(device);
+        x0.to(device);
+
+        auto const c = solve_reordered(
+            a,
+            b,
+            x0,
+            Reordering::rcm(a),
+            [](CsrMatrix const &pa, Tensor const &pb, Tensor const &px0)
+            { return conjuaget_gradient(pa, pb, px0); }
+        );
+
+        REQUIRE(bandwidth(Reordering::rcm(a).apply(a)) == 1);
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref, 1e-6F, 1e-6F));
+      }
+    }
+  }
+}
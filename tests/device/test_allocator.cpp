@@ -0,0 +1,86 @@
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers.hpp"
+
+#include "device.hpp"
+
+#include "algorithms.hpp"
+#include "matchers.hpp"
+#include "tensor.hpp"
+
+using namespace Catch::Matchers;
+using namespace gpu_playground;
+
+TEST_CASE("device: allocator steady state", "[device]")
+{
+  auto const devices = make_devices();
+
+  // clang-format off
+  std::vector<float> const a_data{6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0, -1.0, 0.0, 0.0, 0.0, -1.0, 6.0};
+  std::vector<float> const b_data{1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<float> const ref{0.24978355, 0.4987013, 0.74242425, 0.95584416, 0.9926407};
+  // clang-format on
+  Shape const a_shape{5, 5};
+  Shape const b_shape{5, 1};
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        Tensor const a(a_data, a_shape, device);
+        Tensor const b(b_data, b_shape, device);
+        Tensor const x0 = Tensor::zeros(b_shape, device);
+
+        {
+          auto const c = conjuaget_gradient(a, b, x0);
+          REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref));
+        }
+        auto const warm = device->allocator_stats();
+
+        {
+          auto const c = conjuaget_gradient(a, b, x0);
+          REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref));
+        }
+        auto const steady = device->allocator_stats();
+
+        REQUIRE(steady.misses == warm.misses);
+      }
+    }
+  }
+}
+
+TEST_CASE("device: allocator trim", "[device]")
+{
+  auto const devices = make_devices();
+
+  Shape const shape{16, 16};
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        {
+          auto const a = Tensor::ones(shape, device);
+          auto const b = a.cmul(a);
+          b.sync();
+        }
+
+        {
+          auto const a = Tensor::zeros(shape, device);
+          REQUIRE_THAT(
+              a.cpu(), VectorsWithinAbsRel(std::vector<float>(shape.rows * shape.cols, 0.0))
+          );
+        }
+
+        device->trim();
+        REQUIRE(device->allocator_stats().bytes_cached == 0);
+      }
+    }
+  }
+}
@@ -0,0 +1,233 @@
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers.hpp"
+
+#include "device.hpp"
+
+#include "matchers.hpp"
+#include "tensor.hpp"
+
+using namespace Catch::Matchers;
+using namespace gpu_playground;
+
+TEST_CASE("device: dtype conversions", "[device]")
+{
+  auto const devices = make_devices();
+
+  constexpr float inf = std::numeric_limits<float>::infinity();
+
+  // Exact values, ties rounded to even at the last bit of each 16-bit type, its overflow and
+  // (for F16) subnormals. The tail of plain integers brings the conversions to the vector code.
+  auto const ulp_f16  = std::ldexp(1.0F, -10);
+  auto const ulp_bf16 = std::ldexp(1.0F, -7);
+  auto const sub_f16  = std::ldexp(1.0F, -24);
+  std::vector<float> data{
+      0.0,
+      -2.5,
+      1.0F + (ulp_f16 / 2),
+      1.0F + (3 * ulp_f16 / 2),
+      1.0F + (ulp_bf16 / 2),
+      1.0F + (3 * ulp_bf16 / 2),
+      65'504.0,
+      65'520.0,
+      sub_f16,
+      sub_f16 / 2,
+      3 * sub_f16 / 2,
+      -inf,
+  };
+  std::vector<float> f16_ref{
+      0.0,
+      -2.5,
+      1.0,
+      1.0F + (2 * ulp_f16),
+      1.0F + (ulp_bf16 / 2),
+      1.0F + (3 * ulp_bf16 / 2),
+      65'504.0,
+      inf,
+      sub_f16,
+      0.0,
+      2 * sub_f16,
+      -inf,
+  };
+  std::vector<float> bf16_ref{
+      0.0,
+      -2.5,
+      1.0,
+      1.0,
+      1.0,
+      1.0F + (2 * ulp_bf16),
+      65'536.0,
+      65'536.0,
+      sub_f16,
+      sub_f16 / 2,
+      3 * sub_f16 / 2,
+      -inf,
+  };
+  for (size_t i{0}; i < 21; i++)
+  {
+    auto const value = static_cast<float>(i) - 10.0F;
+    data.push_back(value);
+    f16_ref.push_back(value);
+    bf16_ref.push_back(value);
+  }
+  Shape const shape{data.size(), 1};
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F16))
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        Tensor const a(data, shape, device);
+
+        auto const half  = a.to_dtype(DType::F16);
+        auto const bhalf = a.to_dtype(DType::BF16);
+
+        REQUIRE(half.dtype() == DType::F16);
+        REQUIRE(bhalf.dtype() == DType::BF16);
+        REQUIRE(half.cpu() == f16_ref);
+        REQUIRE(bhalf.cpu() == bf16_ref);
+        REQUIRE(half.to_dtype(DType::F32).cpu() == f16_ref);
+        REQUIRE(bhalf.to_dtype(DType::F32).cpu() == bf16_ref);
+        REQUIRE(half.to_dtype(DType::F16).cpu() == f16_ref);
+      }
+    }
+  }
+}
+
+TEST_CASE("device: dtype across devices", "[device]")
+{
+  auto const devices = make_devices();
+
+  std::vector<float> const data{1.0, -2.0, 3.0, 0.5, 0.25, 7.0};
+  Shape const shape{2, 3};
+  Tensor a = Tensor(data, shape, devices[DeviceIdx::SERIAL]).to_dtype(DType::BF16);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::BF16))
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        auto b = Tensor::zeros(shape, device);
+        b      = a;
+
+        REQUIRE(a.dtype() == DType::BF16);
+        REQUIRE(b.dtype() == DType::BF16);
+        REQUIRE(a.cpu() == data);
+        REQUIRE(b.cpu() == data);
+      }
+    }
+  }
+}
+
+TEST_CASE("device: F64 arithmetic", "[device]")
+{
+  auto const devices = make_devices();
+
+  // Integers plus multiples of 2^-30, which float rounds away but double keeps, in matrices whose
+  // rows end in partial batches
+  constexpr size_t rows{6};
+  constexpr size_t cols{7};
+  auto const tiny = std::ldexp(1.0, -30);
+  std::vector<double> a_data(rows * cols);
+  std::vector<double> b_data(rows * cols);
+  for (size_t i{0}; i < rows * cols; i++)
+  {
+    a_data[i] = static_cast<double>(i % 9) + (tiny * static_cast<double>(i % 5));
+    b_data[i] = static_cast<double>(1 + (i % 4)) - (tiny * 3.0);
+  }
+  std::vector<double> v_data(rows);
+  for (size_t i{0}; i < rows; i++)
+  {
+    v_data[i] = 2.0 + (tiny * static_cast<double>(i));
+  }
+  std::vector<double> x_data(cols);
+  for (size_t j{0}; j < cols; j++)
+  {
+    x_data[j] = static_cast<double>(j) - 3.0 + tiny;
+  }
+  double const alpha_value = 0.5 + tiny;
+
+  std::vector<double> add_ref(rows * cols);
+  std::vector<double> lazy_ref(rows * cols);
+  std::vector<double> broadcast_ref(rows * cols);
+  std::vector<double> axpy_ref(rows * cols);
+  std::vector<double> transpose_ref(rows * cols);
+  std::vector<double> mul_ref(rows * rows, 0.0);
+  std::vector<double> gemv_ref(rows, 0.0);
+  std::vector<float> f32_ref(rows * cols);
+  std::vector<float> f16_ref(rows * cols);
+  double dot_ref{0.0};
+  for (size_t i{0}; i < rows; i++)
+  {
+    for (size_t j{0}; j < cols; j++)
+    {
+      auto const a_ij               = a_data[(i * cols) + j];
+      auto const b_ij               = b_data[(i * cols) + j];
+      add_ref[(i * cols) + j]       = a_ij + b_ij;
+      lazy_ref[(i * cols) + j]      = ((a_ij * b_ij) - a_ij) / alpha_value;
+      broadcast_ref[(i * cols) + j] = a_ij / v_data[i];
+      axpy_ref[(i * cols) + j]      = (alpha_value * a_ij) + b_ij;
+      transpose_ref[(j * rows) + i] = a_ij;
+      f32_ref[(i * cols) + j]       = static_cast<float>(a_ij);
+      f16_ref[(i * cols) + j]       = static_cast<float>(((i * cols) + j) % 9);
+      gemv_ref[i] += a_ij * x_data[j];
+      dot_ref += a_ij * b_ij;
+      for (size_t k{0}; k < rows; k++)
+      {
+        mul_ref[(i * rows) + k] += a_ij * b_data[(k * cols) + j];
+      }
+    }
+  }
+
+  Shape const shape{rows, cols};
+  Tensor a = Tensor::from_f64(a_data, shape, devices[DeviceIdx::SERIAL]);
+  Tensor b = Tensor::from_f64(b_data, shape, devices[DeviceIdx::SERIAL]);
+
+  constexpr double tol{1e-13};
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F64))
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+        auto const v     = Tensor::from_f64(v_data, Shape{rows, 1}, device);
+        auto const x     = Tensor::from_f64(x_data, Shape{cols, 1}, device);
+        auto const alpha = Tensor::from_f64({alpha_value}, Shape{1, 1}, device);
+        auto const a_vec = Tensor::from_f64(a_data, Shape{rows * cols, 1}, device);
+        auto const b_vec = Tensor::from_f64(b_data, Shape{rows * cols, 1}, device);
+
+        Tensor const lazy = (a.lazy().cmul(b.lazy()) - a.lazy()).sdiv(alpha.lazy());
+        Tensor axpy{b};
+        axpy.axpy(alpha, a);
+        Tensor assigned = Tensor::zeros(Shape{1, 1}, device);
+        assigned        = (a.lazy().cmul(b.lazy()) - a.lazy()).sdiv(alpha.lazy());
+
+        REQUIRE(a.dtype() == DType::F64);
+        REQUIRE(lazy.dtype() == DType::F64);
+        REQUIRE(a.cpu_f64() == a_data);
+        REQUIRE_THAT((a + b).cpu_f64(), VectorsWithinAbsRel(add_ref, tol, tol));
+        REQUIRE_THAT(lazy.cpu_f64(), VectorsWithinAbsRel(lazy_ref, tol, tol));
+        REQUIRE(assigned.dtype() == DType::F64);
+        REQUIRE_THAT(assigned.cpu_f64(), VectorsWithinAbsRel(lazy_ref, tol, tol));
+        REQUIRE_THAT(a.cdiv(v).cpu_f64(), VectorsWithinAbsRel(broadcast_ref, tol, tol));
+        REQUIRE_THAT(axpy.cpu_f64(), VectorsWithinAbsRel(axpy_ref, tol, tol));
+        REQUIRE(a.transpose().cpu_f64() == transpose_ref);
+        REQUIRE_THAT((a * b.transpose()).cpu_f64(), VectorsWithinAbsRel(mul_ref, tol, tol));
+        REQUIRE_THAT((a * x).cpu_f64(), VectorsWithinAbsRel(gemv_ref, tol, tol));
+        REQUIRE_THAT(a_vec.dot(b_vec).item_f64(), WithinAbsRel(dot_ref, tol, tol));
+        REQUIRE(a.cpu() == f32_ref);
+        REQUIRE(a.to_dtype(DType::F32).cpu() == f32_ref);
+        REQUIRE(a.to_dtype(DType::F16).cpu() == f16_ref);
+      }
+    }
+  }
+}
@@ -0,0 +1,206 @@
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers.hpp"
+
+#include "device.hpp"
+
+#include "matchers.hpp"
+#include "matrix_market.hpp"
+#include "tensor.hpp"
+#include "thread_settings.hpp"
+
+using namespace Catch::Matchers;
+using namespace gpu_playground;
+
+namespace
+{
+
+// File holding `contents` in the temp directory, removed when it goes out of scope. Its name is
+// made unique so that concurrent test runs do not write to the same file.
+class TempFile
+{
+  std::string m_path;
+
+public:
+  TempFile(std::string const &name, std::string const &contents)
+  {
+    static std::atomic<size_t> counter{0};
+    auto const unique = std::to_string(std::random_device{}()) + "_" +
+                        std::to_string(counter.fetch_add(1)) + "_" + name;
+    this->m_path      = (std::filesystem::temp_directory_path() / unique).string();
+    std::ofstream(this->m_path, std::ios::binary) << contents;
+  }
+
+  TempFile(TempFile const &)            = delete;
+  TempFile &operator=(TempFile const &) = delete;
+  TempFile(TempFile &&)                 = delete;
+  TempFile &operator=(TempFile &&)      = delete;
+
+  ~TempFile()
+  {
+    std::error_code error;
+    std::filesystem::remove(this->m_path, error);
+  }
+
+  [[nodiscard]] std::string const &path() const { return this->m_path; }
+};
+
+} // namespace
+
+TEST_CASE("io: matrix market general", "[io]")
+{
+  auto const devices = make_devices();
+
+  TempFile const file(
+      "gpu_playground_general.mtx",
+      "%%MatrixMarket matrix coordinate real general\r\n"
+      "% comment\r\n"
+      "\r\n"
+      "2 3 4\r\n"
+      "1 1 1.5\r\n"
+      "2 3 -2.5e1\r\n"
+      "\r\n"
+      "1 3 +3\r\n"
+      "2 1 0.125E+2"
+  );
+  std::vector<float> const ref{1.5, 0.0, 3.0, 12.5, 0.0, -25.0};
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        auto const a = load_matrix_market_dense(file.path(), device);
+
+        REQUIRE(a.has_value());
+        REQUIRE(a->shape().rows == 2);
+        REQUIRE(a->shape().cols == 3);
+        REQUIRE_THAT(a->cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("io: matrix market symmetric", "[io]")
+{
+  auto const devices = make_devices();
+
+  TempFile const pattern(
+      "gpu_playground_pattern.mtx",
+      "%%MatrixMarket matrix coordinate pattern symmetric\n"
+      "3 3 3\n"
+      "1 1\n"
+      "2 1\n"
+      "3 2\n"
+  );
+  TempFile const skew(
+      "gpu_playground_skew.mtx",
+      "%%MatrixMarket matrix coordinate integer skew-symmetric\n"
+      "3 3 2\n"
+      "2 1 4\n"
+      "3 1 -7\n"
+  );
+  std::vector<float> const ref_pattern{1.0, 1.0, 0.0, 1.0, 0.0, 1.0, 0.0, 1.0, 0.0};
+  std::vector<float> const ref_skew{0.0, -4.0, 7.0, 4.0, 0.0, 0.0, -7.0, 0.0, 0.0};
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        auto const a = load_matrix_market_dense(pattern.path(), device);
+        auto const b = load_matrix_market_dense(skew.path(), device);
+
+        REQUIRE(a.has_value());
+        REQUIRE(b.has_value());
+        REQUIRE_THAT(a->cpu(), VectorsWithinAbsRel(ref_pattern));
+        REQUIRE_THAT(b->cpu(), VectorsWithinAbsRel(ref_skew));
+      }
+    }
+  }
+}
+
+TEST_CASE("io: matrix market parallel", "[io]")
+{
+  auto const devices = make_devices();
+
+  ScopedThreadSettings const settings{4};
+
+  // Large enough to be split in several chunks, with integer values so that every sum is exact
+  constexpr size_t rows{20'000};
+  std::string contents = "%%MatrixMarket matrix coordinate real general\n";
+  contents += std::to_string(rows) + " " + std::to_string(rows) + " " + std::to_string(3 * rows);
+  contents += "\n";
+  std::vector<float> x_data(rows);
+  std::vector<float> ref(rows, 0.0);
+  for (size_t j{0}; j < rows; j++)
+  {
+    x_data[j] = static_cast<float>(j % 5) - 2.0F;
+  }
+  for (size_t i{0}; i < rows; i++)
+  {
+    for (size_t k{0}; k < 3; k++)
+    {
+      auto const col   = (i + (k * 7)) % rows;
+      auto const value = static_cast<int>((i + k) % 9) - 4;
+      contents += std::to_string(i + 1) + " " + std::to_string(col + 1) + " ";
+      contents += std::to_string(value) + ".0\n";
+
+      ref[i] += static_cast<float>(value) * x_data[col];
+    }
+  }
+  TempFile const file("gpu_playground_parallel.mtx", contents);
+  Tensor x(x_data, Shape{rows, 1}, devices[DeviceIdx::SERIAL]);
+
+  auto const mm = read_matrix_market(file.path());
+  REQUIRE(mm.has_value());
+  REQUIRE(mm->triplets.size() == 3 * rows);
+  REQUIRE(mm->stats.bytes == contents.size());
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        x.to(device);
+        auto const a = load_matrix_market_csr(file.path(), device);
+
+        REQUIRE(a.has_value());
+        REQUIRE_THAT((*a * x).cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("io: matrix market malformed", "[io]")
+{
+  TempFile const bad_banner(
+      "gpu_playground_array.mtx", "%%MatrixMarket matrix array real general\n2 2\n1\n2\n3\n4\n"
+  );
+  TempFile const bad_count(
+      "gpu_playground_count.mtx",
+      "%%MatrixMarket matrix coordinate real general\n2 2 3\n1 1 1.0\n2 2 1.0\n"
+  );
+  TempFile const bad_index(
+      "gpu_playground_index.mtx", "%%MatrixMarket matrix coordinate real general\n2 2 1\n3 1 1.0\n"
+  );
+  TempFile const bad_value(
+      "gpu_playground_value.mtx", "%%MatrixMarket matrix coordinate real general\n2 2 1\n1 1 x\n"
+  );
+
+  REQUIRE_FALSE(read_matrix_market("gpu_playground_missing.mtx").has_value());
+  REQUIRE_FALSE(read_matrix_market(bad_banner.path()).has_value());
+  REQUIRE_FALSE(read_matrix_market(bad_count.path()).has_value());
+  REQUIRE_FALSE(read_matrix_market(bad_index.path()).has_value());
+  REQUIRE_FALSE(read_matrix_market(bad_value.path()).has_value());
+}
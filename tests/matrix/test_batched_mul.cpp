@@ -0,0 +1,148 @@
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers.hpp"
+
+#include "device.hpp"
+
+#include "matchers.hpp"
+#include "tensor.hpp"
+#include "thread_settings.hpp"
+
+using namespace Catch::Matchers;
+using namespace gpu_playground;
+
+namespace
+{
+
+// Integer-valued stacks of (m x k) and (k x n) matrices, and their products
+struct Batch
+{
+  std::vector<float> a;
+  std::vector<float> b;
+  std::vector<float> ref;
+};
+
+Batch make_batch(size_t const batch, size_t const m, size_t const n, size_t const k)
+{
+  Batch res{
+      std::vector<float>(batch * m * k),
+      std::vector<float>(batch * k * n),
+      std::vector<float>(batch * m * n, 0.0)
+  };
+  for (size_t i{0}; i < res.a.size(); i++)
+  {
+    res.a[i] = static_cast<float>(i % 7) - 3.0F;
+  }
+  for (size_t i{0}; i < res.b.size(); i++)
+  {
+    res.b[i] = static_cast<float>(i % 5) - 2.0F;
+  }
+  for (size_t s{0}; s < batch; s++)
+  {
+    for (size_t i{0}; i < m; i++)
+    {
+      for (size_t j{0}; j < n; j++)
+      {
+        for (size_t p{0}; p < k; p++)
+        {
+          res.ref[(s * m * n) + (i * n) + j] +=
+              res.a[(s * m * k) + (i * k) + p] * res.b[(s * k * n) + (p * n) + j];
+        }
+      }
+    }
+  }
+  return res;
+}
+
+} // namespace
+
+TEST_CASE("matrix: batched mul", "[matrix]")
+{
+  auto const devices = make_devices();
+
+  // clang-format off
+  std::vector<float> const a_data{0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0};
+  std::vector<float> const b_data{0.0, 1.0, 2.0, 3.0, 4.0, 5.0, -1.0, 2.0, 1.0, 1.0, 0.0, 3.0};
+  std::vector<float> const ref{10.0, 13.0, 28.0, 40.0, -1.0, 2.0, 1.0, 1.0};
+  // clang-format on
+  Tensor a(a_data, Shape{4, 3}, devices[DeviceIdx::SERIAL]);
+  Tensor b(b_data, Shape{6, 2}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+
+        auto const c            = a.batched_mul(b, 2);
+        auto const [rows, cols] = c.shape();
+
+        REQUIRE(rows == 4);
+        REQUIRE(cols == 2);
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("matrix: batched mul vectors", "[matrix]")
+{
+  auto const devices = make_devices();
+
+  constexpr size_t batch{9};
+  constexpr size_t m{13};
+  constexpr size_t k{11};
+  auto const data = make_batch(batch, m, 1, k);
+  Tensor a(data.a, Shape{batch * m, k}, devices[DeviceIdx::SERIAL]);
+  Tensor b(data.b, Shape{batch * k, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+
+        REQUIRE_THAT(a.batched_mul(b, batch).cpu(), VectorsWithinAbsRel(data.ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("matrix: batched mul parallel", "[matrix]")
+{
+  auto const devices = make_devices();
+
+  ScopedThreadSettings const settings{4, 7, 0};
+
+  // Enough work for the batch to be split between threads, with sizes that are not multiples of
+  // the register tiles
+  constexpr size_t batch{80};
+  constexpr size_t m{33};
+  constexpr size_t n{31};
+  constexpr size_t k{29};
+  auto const data = make_batch(batch, m, n, k);
+  Tensor a(data.a, Shape{batch * m, k}, devices[DeviceIdx::SERIAL]);
+  Tensor b(data.b, Shape{batch * k, n}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+
+        REQUIRE_THAT(a.batched_mul(b, batch).cpu(), VectorsWithinAbsRel(data.ref));
+      }
+    }
+  }
+}
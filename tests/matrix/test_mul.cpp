@@ -8,6 +8,7 @@
 
 #include "matchers.hpp"
 #include "tensor.hpp"
+#include "thread_settings.hpp"
 
 using namespace Catch::Matchers;
 using namespace gpu_playground;
@@ -40,3 +41,170 @@ TEST_CASE("matrix: mul", "[matrix]")
     }
   }
 }
+
+TEST_CASE("matrix: mul blocked", "[matrix]")
+{
+  auto const devices = make_devices();
+
+  // Shapes that are not multiples of the register tile and span several cache blocks
+  constexpr size_t m{150};
+  constexpr size_t k{300};
+  constexpr size_t n{37};
+  std::vector<float> a_data(m * k);
+  std::vector<float> b_data(k * n);
+  for (size_t i{0}; i < a_data.size(); i++)
+  {
+    a_data[i] = static_cast<float>((i % 7)) - 3.0F;
+  }
+  for (size_t i{0}; i < b_data.size(); i++)
+  {
+    b_data[i] = static_cast<float>((i % 5)) - 2.0F;
+  }
+  std::vector<float> ref(m * n, 0.0F);
+  for (size_t i{0}; i < m; i++)
+  {
+    for (size_t p{0}; p < k; p++)
+    {
+      for (size_t j{0}; j < n; j++)
+      {
+        ref[(i * n) + j] += a_data[(i * k) + p] * b_data[(p * n) + j];
+      }
+    }
+  }
+  Tensor a(a_data, Shape{m, k}, devices[DeviceIdx::SERIAL]);
+  Tensor b(b_data, Shape{k, n}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+
+        auto const c = a * b;
+
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("matrix: mul parallel", "[matrix]")
+{
+  auto const devices = make_devices();
+
+  ScopedThreadSettings const settings{4};
+
+  constexpr size_t m{201};
+  constexpr size_t k{64};
+  constexpr size_t n{190};
+  std::vector<float> a_data(m * k);
+  std::vector<float> b_data(k * n);
+  for (size_t i{0}; i < a_data.size(); i++)
+  {
+    a_data[i] = static_cast<float>((i % 5)) - 2.0F;
+  }
+  for (size_t i{0}; i < b_data.size(); i++)
+  {
+    b_data[i] = static_cast<float>((i % 3)) - 1.0F;
+  }
+  std::vector<float> ref(m * n, 0.0F);
+  for (size_t i{0}; i < m; i++)
+  {
+    for (size_t p{0}; p < k; p++)
+    {
+      for (size_t j{0}; j < n; j++)
+      {
+        ref[(i * n) + j] += a_data[(i * k) + p] * b_data[(p * n) + j];
+      }
+    }
+  }
+  Tensor a(a_data, Shape{m, k}, devices[DeviceIdx::SERIAL]);
+  Tensor b(b_data, Shape{k, n}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+
+        auto const c = a * b;
+
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("matrix: mul reduced precision", "[matrix]")
+{
+  auto const devices = make_devices();
+
+  ScopedThreadSettings const settings{4};
+
+  // Small integers are exact in F16 and BF16, and b is scaled so that the sums leave the F16
+  // range: only a float accumulation gets them right
+  constexpr size_t m{23};
+  constexpr size_t k{41};
+  constexpr size_t n{19};
+  std::vector<float> a_data(m * k);
+  std::vector<float> b_data(k * n);
+  std::vector<float> bt_data(n * k);
+  for (size_t i{0}; i < a_data.size(); i++)
+  {
+    a_data[i] = static_cast<float>((i % 7)) - 3.0F;
+  }
+  for (size_t p{0}; p < k; p++)
+  {
+    for (size_t j{0}; j < n; j++)
+    {
+      auto const value     = 256.0F * (static_cast<float>((p + (2 * j)) % 5) - 2.0F);
+      b_data[(p * n) + j]  = value;
+      bt_data[(j * k) + p] = value;
+    }
+  }
+  std::vector<float> ref(m * n, 0.0F);
+  for (size_t i{0}; i < m; i++)
+  {
+    for (size_t p{0}; p < k; p++)
+    {
+      for (size_t j{0}; j < n; j++)
+      {
+        ref[(i * n) + j] += a_data[(i * k) + p] * b_data[(p * n) + j];
+      }
+    }
+  }
+  Tensor a(a_data, Shape{m, k}, devices[DeviceIdx::SERIAL]);
+  Tensor b(b_data, Shape{k, n}, devices[DeviceIdx::SERIAL]);
+  Tensor bt(bt_data, Shape{n, k}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F16))
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+        bt.to(device);
+
+        for (auto const dtype : {DType::F16, DType::BF16})
+        {
+          INFO(std::string(get_dtype_name(dtype)));
+          auto const a_r = a.to_dtype(dtype);
+          auto const b_r = b.to_dtype(dtype);
+
+          REQUIRE_THAT((a_r * b).cpu(), VectorsWithinAbsRel(ref));
+          REQUIRE_THAT((a * b_r).cpu(), VectorsWithinAbsRel(ref));
+          REQUIRE_THAT((a_r * b_r).cpu(), VectorsWithinAbsRel(ref));
+          REQUIRE_THAT((a_r * bt.transpose()).cpu(), VectorsWithinAbsRel(ref));
+        }
+      }
+    }
+  }
+}
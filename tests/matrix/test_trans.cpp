@@ -8,6 +8,7 @@
 
 #include "matchers.hpp"
 #include "tensor.hpp"
+#include "thread_settings.hpp"
 
 using namespace Catch::Matchers;
 using namespace gpu_playground;
@@ -39,3 +40,136 @@ TEST_CASE("matrix: trans", "[matrix]")
     }
   }
 }
+
+TEST_CASE("matrix: trans view mul", "[matrix]")
+{
+  auto const devices = make_devices();
+
+  std::vector<float> const data{0.0, 1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<float> const ref_tn{9.0, 12.0, 15.0, 12.0, 17.0, 22.0, 15.0, 22.0, 29.0};
+  std::vector<float> const ref_nt{5.0, 14.0, 14.0, 50.0};
+  std::vector<float> const ref_tt{3.0, 9.0, 15.0, 4.0, 14.0, 24.0, 5.0, 19.0, 33.0};
+  Shape const shape{2, 3};
+  Tensor a(data, shape, devices[DeviceIdx::SERIAL]);
+  Tensor b(data, Shape{3, 2}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+
+        auto const tn = a.transpose() * a;
+        auto const nt = a * a.transpose();
+        auto const tt = a.transpose() * b.transpose();
+
+        REQUIRE_THAT(tn.cpu(), VectorsWithinAbsRel(ref_tn));
+        REQUIRE_THAT(nt.cpu(), VectorsWithinAbsRel(ref_nt));
+        REQUIRE_THAT(tt.cpu(), VectorsWithinAbsRel(ref_tt));
+      }
+    }
+  }
+}
+
+TEST_CASE("matrix: trans view cwise", "[matrix]")
+{
+  auto const devices = make_devices();
+
+  std::vector<float> const data{0.0, 1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<float> const ref_sum{0.0, 4.0, 3.0, 7.0, 6.0, 10.0};
+  std::vector<float> const ref_square{0.0, 9.0, 1.0, 16.0, 4.0, 25.0};
+  Tensor a(data, Shape{2, 3}, devices[DeviceIdx::SERIAL]);
+  Tensor b(data, Shape{3, 2}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+
+        auto const at = a.transpose();
+        auto const c  = at + b;
+        auto const d  = b + at;
+        auto const e  = at.cmul(at);
+        Tensor const f(at.lazy().cmul(at.lazy()));
+
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref_sum));
+        REQUIRE_THAT(d.cpu(), VectorsWithinAbsRel(ref_sum));
+        REQUIRE_THAT(e.cpu(), VectorsWithinAbsRel(ref_square));
+        REQUIRE_THAT(f.cpu(), VectorsWithinAbsRel(ref_square));
+      }
+    }
+  }
+}
+
+TEST_CASE("matrix: trans copy on write", "[matrix]")
+{
+  auto const devices = make_devices();
+
+  std::vector<float> const data{0.0, 1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<float> const ref{0.0, 6.0, 2.0, 8.0, 4.0, 10.0};
+  Tensor a(data, Shape{2, 3}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+
+        auto at = a.transpose();
+        at += at;
+
+        REQUIRE_THAT(at.cpu(), VectorsWithinAbsRel(ref));
+        REQUIRE_THAT(a.cpu(), VectorsWithinAbsRel(data));
+      }
+    }
+  }
+}
+
+TEST_CASE("matrix: trans parallel", "[matrix]")
+{
+  auto const devices = make_devices();
+
+  ScopedThreadSettings const settings{4, 7, 0};
+
+  // Several cache blocks of rows, with ragged edges in both directions
+  constexpr size_t rows{150};
+  constexpr size_t cols{77};
+  std::vector<float> data(rows * cols);
+  std::vector<float> ref(cols * rows);
+  for (size_t i{0}; i < rows; i++)
+  {
+    for (size_t j{0}; j < cols; j++)
+    {
+      auto const value        = static_cast<float>((i * cols) + j);
+      data[(i * cols) + j] = value;
+      ref[(j * rows) + i]  = value;
+    }
+  }
+  Tensor a(data, Shape{rows, cols}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+
+        auto const c = a.transpose().contiguous();
+
+        REQUIRE(c.shape().rows == cols);
+        REQUIRE(c.shape().cols == rows);
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
@@ -0,0 +1,160 @@
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers.hpp"
+
+#include "device.hpp"
+
+#include "matchers.hpp"
+#include "tensor.hpp"
+#include "thread_settings.hpp"
+
+using namespace Catch::Matchers;
+using namespace gpu_playground;
+
+TEST_CASE("matrix-vector: broadcast row", "[matrix-vector]")
+{
+  auto const devices = make_devices();
+
+  std::vector<float> const a_data{0.0, 1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<float> const v_data{1.0, 2.0, 4.0};
+  std::vector<float> const add_ref{1.0, 3.0, 6.0, 4.0, 6.0, 9.0};
+  std::vector<float> const sub_ref{-1.0, -1.0, -2.0, 2.0, 2.0, 1.0};
+  std::vector<float> const mul_ref{0.0, 2.0, 8.0, 3.0, 8.0, 20.0};
+  std::vector<float> const div_ref{0.0, 0.5, 0.5, 3.0, 2.0, 1.25};
+  Tensor a(a_data, Shape{2, 3}, devices[DeviceIdx::SERIAL]);
+  Tensor v(v_data, Shape{1, 3}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        v.to(device);
+
+        REQUIRE_THAT((a + v).cpu(), VectorsWithinAbsRel(add_ref));
+        REQUIRE_THAT((a - v).cpu(), VectorsWithinAbsRel(sub_ref));
+        REQUIRE_THAT(a.cmul(v).cpu(), VectorsWithinAbsRel(mul_ref));
+        REQUIRE_THAT(a.cdiv(v).cpu(), VectorsWithinAbsRel(div_ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("matrix-vector: broadcast column", "[matrix-vector]")
+{
+  auto const devices = make_devices();
+
+  std::vector<float> const a_data{0.0, 1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<float> const v_data{2.0, 4.0};
+  std::vector<float> const add_ref{2.0, 3.0, 4.0, 7.0, 8.0, 9.0};
+  std::vector<float> const sub_ref{-2.0, -1.0, 0.0, -1.0, 0.0, 1.0};
+  std::vector<float> const mul_ref{0.0, 2.0, 4.0, 12.0, 16.0, 20.0};
+  std::vector<float> const div_ref{0.0, 0.5, 1.0, 0.75, 1.0, 1.25};
+  Tensor a(a_data, Shape{2, 3}, devices[DeviceIdx::SERIAL]);
+  Tensor v(v_data, Shape{2, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        v.to(device);
+
+        REQUIRE_THAT((a + v).cpu(), VectorsWithinAbsRel(add_ref));
+        REQUIRE_THAT((a - v).cpu(), VectorsWithinAbsRel(sub_ref));
+        REQUIRE_THAT(a.cmul(v).cpu(), VectorsWithinAbsRel(mul_ref));
+        REQUIRE_THAT(a.cdiv(v).cpu(), VectorsWithinAbsRel(div_ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("matrix-vector: broadcast transposed", "[matrix-vector]")
+{
+  auto const devices = make_devices();
+
+  // The column vector of a transposed matrix runs along the rows of its storage
+  std::vector<float> const a_data{0.0, 1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<float> const col_data{1.0, 2.0, 4.0};
+  std::vector<float> const row_data{2.0, 4.0};
+  std::vector<float> const col_ref{1.0, 4.0, 3.0, 6.0, 6.0, 9.0};
+  std::vector<float> const row_ref{0.0, 12.0, 2.0, 16.0, 4.0, 20.0};
+  Tensor a(a_data, Shape{2, 3}, devices[DeviceIdx::SERIAL]);
+  Tensor col(col_data, Shape{3, 1}, devices[DeviceIdx::SERIAL]);
+  Tensor row(row_data, Shape{1, 2}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        col.to(device);
+        row.to(device);
+
+        auto c = a.transpose();
+        c += col;
+
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(col_ref));
+        REQUIRE_THAT(a.transpose().cmul(row).cpu(), VectorsWithinAbsRel(row_ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("matrix-vector: broadcast parallel", "[matrix-vector]")
+{
+  auto const devices = make_devices();
+
+  ScopedThreadSettings const settings{4, 7, 0};
+
+  // Rows that are not a multiple of the batch size, and powers of two so that divisions are exact
+  constexpr size_t rows{37};
+  constexpr size_t cols{53};
+  std::vector<float> a_data(rows * cols);
+  std::vector<float> row_data(cols);
+  std::vector<float> col_data(rows);
+  std::vector<float> add_ref(rows * cols);
+  std::vector<float> div_ref(rows * cols);
+  for (size_t j{0}; j < cols; j++)
+  {
+    row_data[j] = static_cast<float>(j % 9) - 4.0F;
+  }
+  for (size_t i{0}; i < rows; i++)
+  {
+    col_data[i] = static_cast<float>(1U << (i % 4));
+    for (size_t j{0}; j < cols; j++)
+    {
+      auto const k = (i * cols) + j;
+      a_data[k]    = static_cast<float>((i + (2 * j)) % 11);
+      add_ref[k]   = a_data[k] + row_data[j];
+      div_ref[k]   = a_data[k] / col_data[i];
+    }
+  }
+  Tensor a(a_data, Shape{rows, cols}, devices[DeviceIdx::SERIAL]);
+  Tensor row(row_data, Shape{1, cols}, devices[DeviceIdx::SERIAL]);
+  Tensor col(col_data, Shape{rows, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        row.to(device);
+        col.to(device);
+
+        REQUIRE_THAT((a + row).cpu(), VectorsWithinAbsRel(add_ref));
+        REQUIRE_THAT(a.cdiv(col).cpu(), VectorsWithinAbsRel(div_ref));
+      }
+    }
+  }
+}
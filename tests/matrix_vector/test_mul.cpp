@@ -8,6 +8,7 @@
 
 #include "matchers.hpp"
 #include "tensor.hpp"
+#include "thread_settings.hpp"
 
 using namespace Catch::Matchers;
 using namespace gpu_playground;
@@ -40,3 +41,111 @@ TEST_CASE("matrix-vector: mul", "[matrix-vector]")
     }
   }
 }
+
+TEST_CASE("matrix-vector: mul parallel", "[matrix-vector]")
+{
+  auto const devices = make_devices();
+
+  ScopedThreadSettings const settings{4, 7, 0};
+
+  // Integer values keep every sum exact, whatever the order of the additions
+  constexpr size_t m{37};
+  constexpr size_t k{301};
+  std::vector<float> a_data(m * k);
+  std::vector<float> at_data(k * m);
+  std::vector<float> x_data(k);
+  std::vector<float> ref(m, 0.0);
+  for (size_t p{0}; p < k; p++)
+  {
+    x_data[p] = static_cast<float>(p % 5) - 2.0F;
+  }
+  for (size_t i{0}; i < m; i++)
+  {
+    for (size_t p{0}; p < k; p++)
+    {
+      auto const value     = static_cast<float>((i + (3 * p)) % 7) - 3.0F;
+      a_data[(i * k) + p]  = value;
+      at_data[(p * m) + i] = value;
+
+      ref[i] += value * x_data[p];
+    }
+  }
+  Tensor a(a_data, Shape{m, k}, devices[DeviceIdx::SERIAL]);
+  Tensor at(at_data, Shape{k, m}, devices[DeviceIdx::SERIAL]);
+  Tensor x(x_data, Shape{k, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        at.to(device);
+        x.to(device);
+
+        auto const ax  = a * x;
+        auto const atx = at.transpose() * x;
+        auto const xa  = x.transpose() * at;
+
+        REQUIRE_THAT(ax.cpu(), VectorsWithinAbsRel(ref));
+        REQUIRE_THAT(atx.cpu(), VectorsWithinAbsRel(ref));
+        REQUIRE_THAT(xa.cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("matrix-vector: mul reduced precision", "[matrix-vector]")
+{
+  auto const devices = make_devices();
+
+  ScopedThreadSettings const settings{4, 7, 0};
+
+  // Small integers are exact in F16 and BF16, and x is scaled so that the sums leave the F16
+  // range: only a float accumulation gets them right
+  constexpr size_t m{37};
+  constexpr size_t k{301};
+  std::vector<float> a_data(m * k);
+  std::vector<float> x_data(k);
+  std::vector<float> ref(m, 0.0);
+  for (size_t p{0}; p < k; p++)
+  {
+    x_data[p] = 256.0F * (static_cast<float>(p % 5) - 2.0F);
+  }
+  for (size_t i{0}; i < m; i++)
+  {
+    for (size_t p{0}; p < k; p++)
+    {
+      auto const value    = static_cast<float>((i + (3 * p)) % 7) - 3.0F;
+      a_data[(i * k) + p] = value;
+
+      ref[i] += value * x_data[p];
+    }
+  }
+  Tensor a(a_data, Shape{m, k}, devices[DeviceIdx::SERIAL]);
+  Tensor x(x_data, Shape{k, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F16))
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        x.to(device);
+
+        for (auto const dtype : {DType::F16, DType::BF16})
+        {
+          INFO(std::string(get_dtype_name(dtype)));
+          auto const a_r = a.to_dtype(dtype);
+          auto const x_r = x.to_dtype(dtype);
+
+          REQUIRE_THAT((a_r * x).cpu(), VectorsWithinAbsRel(ref));
+          REQUIRE_THAT((a * x_r).cpu(), VectorsWithinAbsRel(ref));
+          REQUIRE_THAT((a_r * x_r).cpu(), VectorsWithinAbsRel(ref));
+        }
+      }
+    }
+  }
+}
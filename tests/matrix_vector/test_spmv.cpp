@@ -0,0 +1,213 @@
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers.hpp"
+
+#include "device.hpp"
+
+#include "csr_matrix.hpp"
+#include "matchers.hpp"
+#include "sell_matrix.hpp"
+#include "tensor.hpp"
+#include "thread_settings.hpp"
+
+using namespace Catch::Matchers;
+using namespace gpu_playground;
+
+TEST_CASE("matrix-vector: spmv", "[matrix-vector]")
+{
+  auto const devices = make_devices();
+
+  // [[1 0 2 0], [0 0 0 0], [0 3 0 4], [5 0 0 6]], with an empty row
+  std::vector<backend::CsrIndex> const row_ptr{0, 2, 2, 4, 6};
+  std::vector<backend::CsrIndex> const col_idx{0, 2, 1, 3, 0, 3};
+  std::vector<float> const values{1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+  std::vector<float> const x_data{1.0, 2.0, 3.0, 4.0};
+  std::vector<float> const ref{7.0, 0.0, 22.0, 29.0};
+  Shape const shape{4, 4};
+  Tensor x(x_data, Shape{4, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        x.to(device);
+        CsrMatrix const a(shape, row_ptr, col_idx, values, device);
+
+        auto const y = a * x;
+
+        REQUIRE(a.nnz() == values.size());
+        REQUIRE_THAT(y.cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("matrix-vector: spmv parallel", "[matrix-vector]")
+{
+  auto const devices = make_devices();
+
+  ScopedThreadSettings const settings{4, 7, 0};
+
+  // Rows of 0 to 20 non-zeros, so that both full batches and remainders are gathered. Integer
+  // values keep every sum exact.
+  constexpr size_t rows{37};
+  constexpr size_t cols{53};
+  std::vector<backend::CsrIndex> row_ptr{0};
+  std::vector<backend::CsrIndex> col_idx;
+  std::vector<float> values;
+  std::vector<float> x_data(cols);
+  std::vector<float> ref(rows, 0.0);
+  for (size_t j{0}; j < cols; j++)
+  {
+    x_data[j] = static_cast<float>(j % 5) - 2.0F;
+  }
+  for (size_t i{0}; i < rows; i++)
+  {
+    for (size_t k{0}; k < (i * 7) % 21; k++)
+    {
+      auto const col   = (i % 13) + (k * 2);
+      auto const value = static_cast<float>((i + k) % 7) - 3.0F;
+      col_idx.push_back(static_cast<backend::CsrIndex>(col));
+      values.push_back(value);
+
+      ref[i] += value * x_data[col];
+    }
+    row_ptr.push_back(static_cast<backend::CsrIndex>(values.size()));
+  }
+  Tensor x(x_data, Shape{cols, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        x.to(device);
+        CsrMatrix const a(Shape{rows, cols}, row_ptr, col_idx, values, device);
+
+        auto const y = a * x;
+
+        REQUIRE_THAT(y.cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("matrix-vector: spmv sell", "[matrix-vector]")
+{
+  auto const devices = make_devices();
+
+  ScopedThreadSettings const settings{4, 7, 0};
+
+  // Irregular rows given as unsorted triplets, with every entry of a row split in two duplicates
+  constexpr size_t rows{61};
+  constexpr size_t cols{47};
+  std::vector<backend::Triplet> triplets;
+  std::vector<float> dense(rows * cols, 0.0);
+  std::vector<float> x_data(cols);
+  std::vector<float> ref(rows, 0.0);
+  for (size_t j{0}; j < cols; j++)
+  {
+    x_data[j] = static_cast<float>(j % 5) - 2.0F;
+  }
+  for (size_t i{rows}; i-- > 0;)
+  {
+    for (size_t k{0}; k < (i * i) % 23; k++)
+    {
+      auto const col   = (i + (k * 2)) % cols;
+      auto const value = static_cast<float>(((i + k) % 3) + 1);
+      auto const row   = static_cast<backend::CsrIndex>(i);
+      triplets.push_back({row, static_cast<backend::CsrIndex>(col), value});
+      triplets.push_back({row, static_cast<backend::CsrIndex>(col), value});
+      dense[(i * cols) + col] += 2.0F * value;
+
+      ref[i] += 2.0F * value * x_data[col];
+    }
+  }
+  Tensor a_dense(dense, Shape{rows, cols}, devices[DeviceIdx::SERIAL]);
+  Tensor x(x_data, Shape{cols, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a_dense.to(device);
+        x.to(device);
+        auto const csr      = CsrMatrix::from_triplets(Shape{rows, cols}, triplets, device);
+        auto const sell     = SellMatrix::from_triplets(Shape{rows, cols}, triplets, device, 16);
+        auto const unsorted = SellMatrix::from_dense(a_dense, 1);
+
+        REQUIRE(csr.nnz() == sell.nnz());
+        REQUIRE_THAT((csr * x).cpu(), VectorsWithinAbsRel(ref));
+        REQUIRE_THAT((sell * x).cpu(), VectorsWithinAbsRel(ref));
+        REQUIRE_THAT((unsorted * x).cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("matrix-vector: spmm", "[matrix-vector]")
+{
+  auto const devices = make_devices();
+
+  ScopedThreadSettings const settings{4, 7, 0};
+
+  // Block of s columns, wider than a batch with a remainder, multiplied by irregular rows with
+  // empty ones. The block is also given as a transposed view, which is made contiguous first.
+  constexpr size_t rows{45};
+  constexpr size_t cols{38};
+  constexpr size_t s{11};
+  std::vector<backend::Triplet> triplets;
+  std::vector<float> x_data(cols * s);
+  std::vector<float> x_trans(s * cols);
+  std::vector<float> ref(rows * s, 0.0);
+  for (size_t i{0}; i < cols; i++)
+  {
+    for (size_t j{0}; j < s; j++)
+    {
+      x_data[(i * s) + j]     = static_cast<float>((i + (j * 3)) % 7) - 3.0F;
+      x_trans[(j * cols) + i] = x_data[(i * s) + j];
+    }
+  }
+  for (size_t i{0}; i < rows; i++)
+  {
+    for (size_t k{0}; k < (i * 5) % 17; k++)
+    {
+      auto const col   = (i + (k * 3)) % cols;
+      auto const value = static_cast<float>((i + k) % 5) - 2.0F;
+      triplets.push_back(
+          {static_cast<backend::CsrIndex>(i), static_cast<backend::CsrIndex>(col), value}
+      );
+      for (size_t j{0}; j < s; j++)
+      {
+        ref[(i * s) + j] += value * x_data[(col * s) + j];
+      }
+    }
+  }
+  Tensor x(x_data, Shape{cols, s}, devices[DeviceIdx::SERIAL]);
+  Tensor x_t(x_trans, Shape{s, cols}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        x.to(device);
+        x_t.to(device);
+        auto const csr  = CsrMatrix::from_triplets(Shape{rows, cols}, triplets, device);
+        auto const sell = SellMatrix::from_triplets(Shape{rows, cols}, triplets, device, 16);
+
+        REQUIRE_THAT((csr * x).cpu(), VectorsWithinAbsRel(ref));
+        REQUIRE_THAT((sell * x).cpu(), VectorsWithinAbsRel(ref));
+        REQUIRE_THAT((csr * x_t.transpose()).cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
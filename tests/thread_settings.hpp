@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+#include "thread_pool.hpp"
+
+// Sets the thread count, grain size and parallel threshold of the CPU backends for the lifetime of
+// the guard, and restores the previous ones when it goes out of scope, also when a REQUIRE throws.
+class ScopedThreadSettings
+{
+  size_t m_num_threads;
+  size_t m_grain_size;
+  size_t m_parallel_threshold;
+
+public:
+  explicit ScopedThreadSettings(
+      size_t const num_threads,
+      size_t const grain_size         = gpu_playground::grain_size(),
+      size_t const parallel_threshold = gpu_playground::parallel_threshold()
+  )
+      : m_num_threads(gpu_playground::num_threads()),
+        m_grain_size(gpu_playground::grain_size()),
+        m_parallel_threshold(gpu_playground::parallel_threshold())
+  {
+    gpu_playground::set_num_threads(num_threads);
+    gpu_playground::set_grain_size(grain_size);
+    gpu_playground::set_parallel_threshold(parallel_threshold);
+  }
+
+  ScopedThreadSettings(ScopedThreadSettings const &)            = delete;
+  ScopedThreadSettings &operator=(ScopedThreadSettings const &) = delete;
+  ScopedThreadSettings(ScopedThreadSettings &&)                 = delete;
+  ScopedThreadSettings &operator=(ScopedThreadSettings &&)      = delete;
+
+  ~ScopedThreadSettings()
+  {
+    gpu_playground::set_num_threads(this->m_num_threads);
+    gpu_playground::set_grain_size(this->m_grain_size);
+    gpu_playground::set_parallel_threshold(this->m_parallel_threshold);
+  }
+};
@@ -0,0 +1,128 @@
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers.hpp"
+
+#include "device.hpp"
+
+#include "matchers.hpp"
+#include "tensor.hpp"
+#include "thread_settings.hpp"
+
+using namespace Catch::Matchers;
+using namespace gpu_playground;
+
+TEST_CASE("vector: dot", "[vector]")
+{
+  auto const devices = make_devices();
+
+  std::vector<float> const a_data{0.0, 1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<float> const b_data{1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+  std::vector<float> const ref{70.0};
+  Shape const shape{6, 1};
+  Tensor a(a_data, shape, devices[DeviceIdx::SERIAL]);
+  Tensor b(b_data, shape, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+
+        auto const c            = a.dot(b);
+        auto const [rows, cols] = c.shape();
+
+        REQUIRE(rows == 1);
+        REQUIRE(cols == 1);
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref));
+        REQUIRE(c.item() == ref.front());
+      }
+    }
+  }
+}
+
+TEST_CASE("vector: dot parallel", "[vector]")
+{
+  auto const devices = make_devices();
+
+  ScopedThreadSettings const settings{4, 7, 0};
+
+  constexpr size_t len{1'003};
+  std::vector<float> a_data(len);
+  std::vector<float> const b_data(len, 1.0);
+  for (size_t i{0}; i < len; i++)
+  {
+    a_data[i] = static_cast<float>(i);
+  }
+  std::vector<float> const ref{static_cast<float>((len * (len - 1)) / 2)};
+  Shape const shape{len, 1};
+  Tensor a(a_data, shape, devices[DeviceIdx::SERIAL]);
+  Tensor b(b_data, shape, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+
+        auto const c = a.dot(b);
+
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("vector: dot reduced precision", "[vector]")
+{
+  auto const devices = make_devices();
+
+  ScopedThreadSettings const settings{4, 7, 0};
+
+  // Small integers are exact in F16 and BF16, and b is scaled so that the sum leaves the F16
+  // range: only a float accumulation gets it right
+  constexpr size_t len{1'003};
+  std::vector<float> a_data(len);
+  std::vector<float> b_data(len);
+  std::vector<float> ref{0.0};
+  for (size_t i{0}; i < len; i++)
+  {
+    a_data[i] = static_cast<float>(i % 4) + 1.0F;
+    b_data[i] = 256.0F * (static_cast<float>(i % 3) + 1.0F);
+    ref[0] += a_data[i] * b_data[i];
+  }
+  Shape const shape{len, 1};
+  Tensor a(a_data, shape, devices[DeviceIdx::SERIAL]);
+  Tensor b(b_data, shape, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr and device->supports_dtype(DType::F16))
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+
+        for (auto const dtype : {DType::F16, DType::BF16})
+        {
+          INFO(std::string(get_dtype_name(dtype)));
+          auto const a_r = a.to_dtype(dtype);
+          auto const b_r = b.to_dtype(dtype);
+
+          REQUIRE_THAT(a_r.dot(b).cpu(), VectorsWithinAbsRel(ref));
+          REQUIRE_THAT(a.dot(b_r).cpu(), VectorsWithinAbsRel(ref));
+          REQUIRE_THAT(a_r.dot(b_r).cpu(), VectorsWithinAbsRel(ref));
+          REQUIRE_THAT(a_r.transpose().dot(b_r.transpose()).cpu(), VectorsWithinAbsRel(ref));
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,128 @@
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers.hpp"
+
+#include "device.hpp"
+
+#include "matchers.hpp"
+#include "tensor.hpp"
+
+using namespace Catch::Matchers;
+using namespace gpu_playground;
+
+TEST_CASE("vector: lazy", "[vector]")
+{
+  auto const devices = make_devices();
+
+  std::vector<float> const x_data{0.0, 1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<float> const y_data{1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+  std::vector<float> const alpha_data{2.0};
+  std::vector<float> const beta_data{4.0};
+  std::vector<float> const ref{-1.25, -0.25, 1.25, 3.25, 5.75, 8.75};
+  Shape const shape{6, 1};
+  Shape const scalar_shape{1, 1};
+  Tensor x(x_data, shape, devices[DeviceIdx::SERIAL]);
+  Tensor y(y_data, shape, devices[DeviceIdx::SERIAL]);
+  Tensor alpha(alpha_data, scalar_shape, devices[DeviceIdx::SERIAL]);
+  Tensor beta(beta_data, scalar_shape, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        x.to(device);
+        y.to(device);
+        alpha.to(device);
+        beta.to(device);
+
+        // (x * x - y) / beta + x * alpha - y
+        Tensor const c = (x.lazy().cmul(x.lazy()) - y.lazy()).sdiv(beta.lazy()) +
+                         (x.lazy().smul(alpha.lazy()) - y.lazy());
+
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("vector: lazy in place", "[vector]")
+{
+  auto const devices = make_devices();
+
+  constexpr size_t len{2'000};
+  std::vector<float> x_data(len);
+  std::vector<float> y_data(len);
+  std::vector<float> ref(len);
+  for (size_t i{0}; i < len; i++)
+  {
+    x_data[i] = static_cast<float>(i % 17);
+    y_data[i] = static_cast<float>(i % 5) + 1.0F;
+    ref[i]    = (y_data[i] + (2.0F * x_data[i])) / y_data[i];
+  }
+  Shape const shape{len, 1};
+  Shape const scalar_shape{1, 1};
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        Tensor const x(x_data, shape, device);
+        Tensor y(y_data, shape, device);
+        Tensor const alpha(std::vector<float>{2.0}, scalar_shape, device);
+
+        y = (y.lazy() + x.lazy().smul(alpha.lazy())).cdiv(y.lazy());
+
+        REQUIRE_THAT(y.cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
+
+TEST_CASE("vector: lazy division or zero", "[vector]")
+{
+  auto const devices = make_devices();
+
+  // Every third denominator is zero, the others are plain divisions down to tiny denominators
+  constexpr size_t len{1'003};
+  std::vector<float> x_data(len);
+  std::vector<float> y_data(len);
+  std::vector<float> ref(len);
+  for (size_t i{0}; i < len; i++)
+  {
+    x_data[i] = static_cast<float>(i % 7) - 3.0F;
+    y_data[i] = static_cast<float>(i % 5) + 1.0F;
+    if (i % 3 == 0)
+    {
+      y_data[i] = 0.0F;
+    }
+    else if (i % 3 == 1)
+    {
+      y_data[i] = -std::numeric_limits<float>::min() * 1e6F;
+    }
+    ref[i] = y_data[i] == 0.0F ? 0.0F : x_data[i] / y_data[i];
+  }
+  Shape const shape{len, 1};
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        Tensor const x(x_data, shape, device);
+        Tensor const y(y_data, shape, device);
+
+        Tensor const c = x.lazy().cdiv_or_zero(y.lazy());
+
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}
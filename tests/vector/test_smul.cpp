@@ -8,6 +8,7 @@
 
 #include "matchers.hpp"
 #include "tensor.hpp"
+#include "thread_settings.hpp"
 
 using namespace Catch::Matchers;
 using namespace gpu_playground;
@@ -40,3 +41,37 @@ TEST_CASE("vector: smul", "[vector]")
     }
   }
 }
+
+TEST_CASE("vector: smul parallel", "[vector]")
+{
+  auto const devices = make_devices();
+
+  ScopedThreadSettings const settings{4, 7, 0};
+
+  constexpr size_t size{1'003};
+  std::vector<float> a_data(size);
+  std::vector<float> ref(size);
+  for (size_t i{0}; i < size; i++)
+  {
+    a_data[i] = static_cast<float>(i);
+    ref[i]    = 2.0F * static_cast<float>(i);
+  }
+  Tensor b(std::vector<float>{2.0}, Shape{1, 1}, devices[DeviceIdx::SERIAL]);
+  Tensor a(a_data, Shape{size, 1}, devices[DeviceIdx::SERIAL]);
+
+  for (auto const &device : devices)
+  {
+    if (device != nullptr)
+    {
+      INFO(std::string(get_device_name(device->type())));
+      {
+        a.to(device);
+        b.to(device);
+
+        auto const c = a.smul(b);
+
+        REQUIRE_THAT(c.cpu(), VectorsWithinAbsRel(ref));
+      }
+    }
+  }
+}